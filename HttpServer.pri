@@ -10,26 +10,85 @@ CONFIG (debug, debug|release) {
 
 HEADERS += $$PWD/HttpServer/HttpGlobal.hpp \
            $$PWD/HttpServer/HttpListener.hpp \
+           $$PWD/HttpServer/HttpAcceptor.hpp \
            $$PWD/HttpServer/HttpServerSettings.hpp \
+           $$PWD/HttpServer/HttpServerMetrics.hpp \
+           $$PWD/HttpServer/HttpConnection.hpp \
            $$PWD/HttpServer/HttpConnectionHandler.hpp \
            $$PWD/HttpServer/HttpConnectionHandlerPool.hpp \
+           $$PWD/HttpServer/HttpConnectionDispatcher.hpp \
+           $$PWD/HttpServer/HttpConnectionParker.hpp \
+           $$PWD/HttpServer/HttpPendingQueue.hpp \
+           $$PWD/HttpServer/HttpClientLimiter.hpp \
+           $$PWD/HttpServer/HttpLockFreeQueue.hpp \
+           $$PWD/HttpServer/HttpHandoffChannel.hpp \
+           $$PWD/HttpServer/HttpTimerWheel.hpp \
+           $$PWD/HttpServer/HttpThreadPlacement.hpp \
+           $$PWD/HttpServer/HttpSocketOptions.hpp \
+           $$PWD/HttpServer/HttpUring.hpp \
+           $$PWD/HttpServer/HttpUringSocket.hpp \
+           $$PWD/HttpServer/HttpEventDispatcher.hpp \
+           $$PWD/HttpServer/HttpWorker.hpp \
+           $$PWD/HttpServer/HttpWorkerPool.hpp \
+           $$PWD/HttpServer/HttpChunkedDecoder.hpp \
+           $$PWD/HttpServer/HttpMultipartParser.hpp \
+           $$PWD/HttpServer/HttpHeaders.hpp \
            $$PWD/HttpServer/HttpRequest.hpp \
+           $$PWD/HttpServer/HttpRequestParser.hpp \
+           $$PWD/HttpServer/HttpScanner.hpp \
            $$PWD/HttpServer/HttpResponse.hpp \
+           $$PWD/HttpServer/HttpDeferredResponse.hpp \
            $$PWD/HttpServer/HttpCookie.hpp \
            $$PWD/HttpServer/HttpRequestHandler.hpp \
+           $$PWD/HttpServer/HttpCoroutineHandler.hpp \
            $$PWD/HttpServer/HttpSession.hpp \
            $$PWD/HttpServer/HttpSessionStore.hpp \
            $$PWD/HttpServer/StaticFileController.hpp
 
 SOURCES += $$PWD/HttpServer/HttpGlobal.cpp \
            $$PWD/HttpServer/HttpListener.cpp \
+           $$PWD/HttpServer/HttpAcceptor.cpp \
            $$PWD/HttpServer/HttpServerSettings.cpp \
+           $$PWD/HttpServer/HttpServerMetrics.cpp \
+           $$PWD/HttpServer/HttpConnection.cpp \
            $$PWD/HttpServer/HttpConnectionHandler.cpp \
            $$PWD/HttpServer/HttpConnectionHandlerPool.cpp \
+           $$PWD/HttpServer/HttpConnectionDispatcher.cpp \
+           $$PWD/HttpServer/HttpConnectionParker.cpp \
+           $$PWD/HttpServer/HttpPendingQueue.cpp \
+           $$PWD/HttpServer/HttpClientLimiter.cpp \
+           $$PWD/HttpServer/HttpHandoffChannel.cpp \
+           $$PWD/HttpServer/HttpTimerWheel.cpp \
+           $$PWD/HttpServer/HttpThreadPlacement.cpp \
+           $$PWD/HttpServer/HttpSocketOptions.cpp \
+           $$PWD/HttpServer/HttpUring.cpp \
+           $$PWD/HttpServer/HttpUringSocket.cpp \
+           $$PWD/HttpServer/HttpEventDispatcher.cpp \
+           $$PWD/HttpServer/HttpWorker.cpp \
+           $$PWD/HttpServer/HttpWorkerPool.cpp \
+           $$PWD/HttpServer/HttpChunkedDecoder.cpp \
+           $$PWD/HttpServer/HttpMultipartParser.cpp \
+           $$PWD/HttpServer/HttpHeaders.cpp \
            $$PWD/HttpServer/HttpRequest.cpp \
+           $$PWD/HttpServer/HttpRequestParser.cpp \
+           $$PWD/HttpServer/HttpScanner.cpp \
            $$PWD/HttpServer/HttpResponse.cpp \
+           $$PWD/HttpServer/HttpDeferredResponse.cpp \
            $$PWD/HttpServer/HttpCookie.cpp \
            $$PWD/HttpServer/HttpRequestHandler.cpp \
+           $$PWD/HttpServer/HttpCoroutineHandler.cpp \
            $$PWD/HttpServer/HttpSession.cpp \
            $$PWD/HttpServer/HttpSessionStore.cpp \
            $$PWD/HttpServer/StaticFileController.cpp
+
+# Coroutine request handlers (HttpCoroutineHandler) need a C++20 compiler
+qtwebapp_coroutines {
+    CONFIG += c++2a
+    DEFINES += QTWEBAPP_COROUTINES
+}
+
+# io_uring I/O for the EventLoop engine and the acceptors (HttpUring), needs liburing 2.4 and Linux
+qtwebapp_uring {
+    LIBS += -luring
+    DEFINES += QTWEBAPP_URING
+}
@@ -0,0 +1,298 @@
+#include "HttpAcceptor.hpp"
+#include "HttpThreadPlacement.hpp"
+
+#ifdef Q_OS_UNIX
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <string.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpAcceptor::HttpAcceptor(const HttpServerSettings &settings, HttpRequestHandler *requestHandler, tSocketDescriptor socketDescriptor, HttpServerMetrics *metrics,
+                           HttpClientLimiter *limiter)
+    : QThread()
+{
+    Q_ASSERT(requestHandler != nullptr);
+
+    this->settings = settings;
+    this->requestHandler = requestHandler;
+    this->metrics = metrics;
+    this->limiter = limiter;
+    this->socketDescriptor = socketDescriptor;
+
+    // execute signals in my own thread
+    this->moveToThread(this);
+
+    qDebug("HttpAcceptor (%p): constructed", this);
+    this->start();
+}
+
+HttpAcceptor::~HttpAcceptor()
+{
+    this->quit();
+    this->wait();
+    this->closeSocket(this->socketDescriptor);
+    qDebug("HttpAcceptor (%p): destroyed", this);
+}
+
+void HttpAcceptor::run()
+{
+    qDebug("HttpAcceptor (%p): thread started", this);
+
+    // Accept on the first CPU of the shard, the others are used by the acceptors of the other shards
+    QList<int> cpus = this->settings.acceptorCpus.mid(0, 1);
+    if (!HttpThreadPlacement::pinCurrentThread(cpus))
+    {
+        cpus.clear();
+    }
+
+    this->metrics->registerThread("acceptor", this, cpus, HttpThreadPlacement::getNodeOfCpus(cpus));
+
+    // The dispatcher and the notifier must be created in the thread that uses them
+    this->dispatcher.storeRelease(new HttpConnectionDispatcher(&this->settings, this->requestHandler, this->metrics, this->limiter));
+
+    if (this->settings.ioUring)
+    {
+        this->uring = HttpUring::create(0, 0, this);
+        this->listenChannel = this->uring ? this->uring->listen(this->socketDescriptor, this) : nullptr;
+    }
+
+    if (!this->listenChannel)
+    {
+        this->notifier = new QSocketNotifier(this->socketDescriptor, QSocketNotifier::Read);
+        QObject::connect(this->notifier, &QSocketNotifier::activated, this, &HttpAcceptor::acceptConnections);
+    }
+
+    try
+    {
+        this->exec();
+    }
+
+    catch (...)
+    {
+        qCritical("HttpAcceptor (%p): an uncatched exception occured in the thread", this);
+    }
+
+    delete this->notifier;
+    this->notifier = nullptr;
+
+    delete this->uring;
+    this->uring = nullptr;
+    this->listenChannel = nullptr;
+
+    delete this->dispatcher.fetchAndStoreAcquire(nullptr);
+
+    this->metrics->unregisterThread(this);
+    qDebug("HttpAcceptor (%p): thread stopped", this);
+}
+
+void HttpAcceptor::acceptConnections()
+{
+#ifdef Q_OS_UNIX
+    // Accept everything that is pending, this saves one wakeup per connection during connection storms
+    for (;;)
+    {
+        #ifdef Q_OS_LINUX
+            int socketDescriptor = ::accept4(static_cast<int>(this->socketDescriptor), nullptr, nullptr, SOCK_CLOEXEC);
+        #else
+            int socketDescriptor = ::accept(static_cast<int>(this->socketDescriptor), nullptr, nullptr);
+            if (socketDescriptor != -1)
+            {
+                ::fcntl(socketDescriptor, F_SETFD, FD_CLOEXEC);
+            }
+        #endif
+
+        if (socketDescriptor == -1)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                qWarning("HttpAcceptor (%p): accept failed: %s", this, strerror(errno));
+            }
+
+            return;
+        }
+
+        #ifdef QTWEBAPP_SUPERVERBOSE
+            qDebug("HttpAcceptor (%p): New connection", this);
+        #endif
+
+        this->dispatcher.loadAcquire()->dispatch(socketDescriptor);
+    }
+#endif
+}
+
+void HttpAcceptor::accepted(qintptr socketDescriptor)
+{
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        qDebug("HttpAcceptor (%p): New connection", this);
+    #endif
+
+    this->dispatcher.loadAcquire()->dispatch(socketDescriptor);
+}
+
+void HttpAcceptor::drain()
+{
+    QMetaObject::invokeMethod(this, "drainShard", Qt::QueuedConnection);
+}
+
+void HttpAcceptor::drainShard()
+{
+    qDebug("HttpAcceptor (%p): draining", this);
+
+    delete this->notifier;
+    this->notifier = nullptr;
+
+    if (this->uring)
+    {
+        this->uring->close(this->listenChannel);
+        this->listenChannel = nullptr;
+    }
+
+    // A successor that has inherited the socket keeps it open, so the connections in its accept queue are not reset
+    this->closeSocket(this->socketDescriptor);
+    this->socketDescriptor = -1;
+
+    if (HttpConnectionDispatcher *dispatcher = this->dispatcher.loadAcquire())
+    {
+        dispatcher->drain();
+    }
+}
+
+tSocketDescriptor HttpAcceptor::getSocketDescriptor() const
+{
+    return this->socketDescriptor;
+}
+
+int HttpAcceptor::getConnectionCount() const
+{
+    HttpConnectionDispatcher *dispatcher = this->dispatcher.loadAcquire();
+    return dispatcher ? dispatcher->getConnectionCount() : 0;
+}
+
+tSocketDescriptor HttpAcceptor::createListeningSocket(const QHostAddress &address, quint16 port)
+{
+#if defined(Q_OS_UNIX) && defined(SO_REUSEPORT)
+    sockaddr_storage storage;
+    socklen_t storageLength = 0;
+    memset(&storage, 0, sizeof(storage));
+
+    bool dualStack = false;
+
+    if (address == QHostAddress::Any || address == QHostAddress::AnyIPv6 || address.protocol() == QAbstractSocket::IPv6Protocol)
+    {
+        sockaddr_in6 *address6 = reinterpret_cast<sockaddr_in6*>(&storage);
+        address6->sin6_family = AF_INET6;
+        address6->sin6_port = htons(port);
+
+        Q_IPV6ADDR ip6 = address.toIPv6Address();
+        memcpy(&address6->sin6_addr, &ip6, sizeof(ip6));
+        if (address == QHostAddress::Any)
+        {
+            address6->sin6_addr = in6addr_any;
+            dualStack = true;
+        }
+
+        storageLength = sizeof(sockaddr_in6);
+    }
+
+    else
+    {
+        sockaddr_in *address4 = reinterpret_cast<sockaddr_in*>(&storage);
+        address4->sin_family = AF_INET;
+        address4->sin_port = htons(port);
+        address4->sin_addr.s_addr = htonl(address == QHostAddress::AnyIPv4 ? INADDR_ANY : address.toIPv4Address());
+        storageLength = sizeof(sockaddr_in);
+    }
+
+    int socketDescriptor = ::socket(storage.ss_family, SOCK_STREAM, 0);
+    if (socketDescriptor == -1)
+    {
+        qWarning("HttpAcceptor: cannot create socket: %s", strerror(errno));
+        return -1;
+    }
+
+    ::fcntl(socketDescriptor, F_SETFD, FD_CLOEXEC);
+    ::fcntl(socketDescriptor, F_SETFL, ::fcntl(socketDescriptor, F_GETFL) | O_NONBLOCK);
+
+    const int on = 1;
+    const int off = 0;
+    ::setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    if (dualStack)
+    {
+        ::setsockopt(socketDescriptor, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    }
+
+    if (::setsockopt(socketDescriptor, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) == -1 ||
+        ::bind(socketDescriptor, reinterpret_cast<sockaddr*>(&storage), storageLength) == -1 ||
+        ::listen(socketDescriptor, SOMAXCONN) == -1)
+    {
+        qWarning("HttpAcceptor: cannot bind on port %i: %s", port, strerror(errno));
+        ::close(socketDescriptor);
+        return -1;
+    }
+
+    return socketDescriptor;
+#else
+    Q_UNUSED(address)
+    Q_UNUSED(port)
+    qWarning("HttpAcceptor: SO_REUSEPORT is not supported on this platform");
+    return -1;
+#endif
+}
+
+void HttpAcceptor::closeSocket(tSocketDescriptor socketDescriptor)
+{
+#ifdef Q_OS_UNIX
+    if (socketDescriptor != -1)
+    {
+        ::close(static_cast<int>(socketDescriptor));
+    }
+#else
+    Q_UNUSED(socketDescriptor)
+#endif
+}
+
+HttpServerSettings HttpAcceptor::shardSettings(const HttpServerSettings &settings, quint32 shardCount, quint32 shardIndex)
+{
+    HttpServerSettings shard = settings;
+
+    if (shardCount > 1)
+    {
+        const quint32 workerThreads = settings.workerThreads ? settings.workerThreads : static_cast<quint32>(qMax(QThread::idealThreadCount(), 1));
+
+        shard.minThreads = settings.minThreads / shardCount;
+        shard.maxThreads = qMax(settings.maxThreads / shardCount, 1U);
+        shard.spareThreads = qMax(settings.spareThreads / shardCount, 1U);
+        shard.workerThreads = qMax(workerThreads / shardCount, 1U);
+        shard.maxConnections = qMax(settings.maxConnections / shardCount, 1U);
+        shard.maxPendingConnections = settings.maxPendingConnections / shardCount;
+
+        // Rotate the CPU lists, so that each shard begins with its own CPUs
+        if (!settings.acceptorCpus.isEmpty())
+        {
+            const int offset = static_cast<int>(shardIndex % static_cast<quint32>(settings.acceptorCpus.size()));
+            shard.acceptorCpus = settings.acceptorCpus.mid(offset) + settings.acceptorCpus.mid(0, offset);
+        }
+
+        if (!settings.workerCpus.isEmpty())
+        {
+            const int offset = static_cast<int>((shardIndex * shard.workerThreads) % static_cast<quint32>(settings.workerCpus.size()));
+            shard.workerCpus = settings.workerCpus.mid(offset) + settings.workerCpus.mid(0, offset);
+        }
+    }
+
+    shard.acceptorThreads = 1U;
+    return shard;
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,136 @@
+#ifndef HTTPACCEPTOR_HPP
+#define HTTPACCEPTOR_HPP
+
+#include <QAtomicPointer>
+#include <QHostAddress>
+#include <QSocketNotifier>
+#include <QThread>
+
+#include "HttpGlobal.hpp"
+#include "HttpConnection.hpp"
+#include "HttpConnectionDispatcher.hpp"
+#include "HttpRequestHandler.hpp"
+#include "HttpServerSettings.hpp"
+#include "HttpUring.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Additional accept thread of a HttpListener, used when acceptorThreads is greater than 1.
+  <p>
+  Each acceptor listens on its own socket that is bound to the same port with SO_REUSEPORT,
+  so the kernel spreads incoming connections over all acceptors. Each acceptor accepts in its
+  own thread and passes the connections to its own HttpConnectionDispatcher, which means that
+  every acceptor has its own shard of connection handlers or workers.
+  <p>
+  SO_REUSEPORT is only available on Unix, and only Linux balances the connections between the
+  sockets. On other platforms the listener falls back to a single acceptor.
+  <p>
+  If acceptorCpus is configured, each acceptor pins its thread to one CPU of that list.
+  <p>
+  With ioUring, the acceptor takes the connections from one multishot accept of a HttpUring
+  instead of calling accept() for each of them, if io_uring is available.
+  @see HttpListener for the description of the acceptorThreads setting
+*/
+
+class DECLSPEC HttpAcceptor : public QThread, public HttpUring::Handler
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpAcceptor)
+
+public:
+
+    /**
+      Constructor, starts accepting connections.
+      @param settings Configuration settings of this shard, the acceptor keeps a copy
+      @param requestHandler Handler that will process each incoming HTTP request
+      @param socketDescriptor Listening socket, created by createListeningSocket(). The acceptor takes ownership.
+      @param metrics Counters of the listener. Must not be 0.
+      @param limiter Limits of the client addresses, shared by all acceptors, may be `nullptr`.
+    */
+    HttpAcceptor(const HttpServerSettings &settings, HttpRequestHandler *requestHandler, tSocketDescriptor socketDescriptor, HttpServerMetrics *metrics,
+                 HttpClientLimiter *limiter = nullptr);
+
+    /** Destructor, stops accepting and closes the shard */
+    virtual ~HttpAcceptor();
+
+    /**
+      Create a non-blocking listening socket with SO_REUSEPORT.
+      @param address Local address to bind to, QHostAddress::Any binds to all IPv4 and IPv6 interfaces
+      @param port Local port to bind to
+      @return the socket descriptor, or -1 if SO_REUSEPORT is not supported or the socket cannot be bound.
+    */
+    static tSocketDescriptor createListeningSocket(const QHostAddress &address, quint16 port);
+
+    /** Close a socket that has been created by createListeningSocket() */
+    static void closeSocket(tSocketDescriptor socketDescriptor);
+
+    /**
+      Divide the pool limits of the settings evenly between the given number of shards.
+      The CPU lists are rotated, so that the shards start their acceptors and workers on different CPUs.
+      @param settings Configuration settings of the whole listener
+      @param shardCount Number of acceptors
+      @param shardIndex Number of the shard, 0 is the shard of the listener itself
+    */
+    static HttpServerSettings shardSettings(const HttpServerSettings &settings, quint32 shardCount, quint32 shardIndex = 0);
+
+    /**
+      Stop accepting, close the listening socket and close all connections of this shard as soon
+      as they are idle. The thread keeps running until the acceptor is deleted. This method is thread safe.
+    */
+    void drain();
+
+    /** The listening socket, -1 after drain() */
+    tSocketDescriptor getSocketDescriptor() const;
+
+    /** Number of open and waiting connections of this shard. This method is thread safe. */
+    int getConnectionCount() const;
+
+private:
+
+    /** Configuration settings of this shard */
+    HttpServerSettings settings;
+
+    /** Will be passed to the dispatcher */
+    HttpRequestHandler *requestHandler = nullptr;
+
+    /** Counters of the listener */
+    HttpServerMetrics *metrics = nullptr;
+
+    /** Will be passed to the dispatcher */
+    HttpClientLimiter *limiter = nullptr;
+
+    /** The listening socket */
+    tSocketDescriptor socketDescriptor = -1;
+
+    /** Watches the listening socket, only used in the thread of this acceptor */
+    QSocketNotifier *notifier = nullptr;
+
+    /** Accepts instead of the notifier if io_uring is used, only used in the thread of this acceptor */
+    HttpUring *uring = nullptr;
+
+    /** Multishot accept on the listening socket */
+    HttpUring::Channel *listenChannel = nullptr;
+
+    /** Connection engine of this shard, created and deleted in the thread of this acceptor */
+    QAtomicPointer<HttpConnectionDispatcher> dispatcher;
+
+    /** Executes the threads own event loop */
+    void run();
+
+    /** Received from the ring, passes the connection to the dispatcher */
+    void accepted(qintptr socketDescriptor);
+
+private slots:
+
+    /** Received from the socket notifier, accepts all pending connections */
+    void acceptConnections();
+
+    /** Stop accepting and drain the shard in the thread of this acceptor */
+    void drainShard();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPACCEPTOR_HPP
@@ -0,0 +1,249 @@
+#include "HttpChunkedDecoder.hpp"
+#include "HttpScanner.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+namespace {
+
+/** Value of a hexadecimal digit, -1 for other characters */
+inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+}
+
+HttpChunkedDecoder::HttpChunkedDecoder()
+{
+}
+
+void HttpChunkedDecoder::reset()
+{
+    this->state = ChunkSize;
+    this->remaining = 0;
+    this->digits = 0;
+}
+
+void HttpChunkedDecoder::finishSizeLine()
+{
+    // The last chunk has the size 0 and is followed by the trailer
+    this->state = this->remaining == 0 ? TrailerStart : ChunkData;
+}
+
+HttpChunkedDecoder::Result HttpChunkedDecoder::decode(const char *data, int size, int &consumed, HttpHeaders::Span &piece)
+{
+    piece = {0, 0};
+    int i = 0;
+
+    while (i < size)
+    {
+        const char c = data[i];
+
+        switch (this->state)
+        {
+            case ChunkSize:
+            {
+                const int value = hexValue(c);
+                if (value >= 0)
+                {
+                    // A chunk cannot be larger than a request
+                    this->remaining = this->remaining * 16 + value;
+                    if (this->remaining > 0x7fffffff)
+                    {
+                        this->state = Failed;
+                    }
+
+                    ++this->digits;
+                }
+
+                else if (this->digits == 0)
+                {
+                    this->state = Failed;
+                }
+
+                else if (c == ';' || c == ' ' || c == '\t')
+                {
+                    this->state = ChunkExtension;
+                }
+
+                else if (c == '\r')
+                {
+                    this->state = ChunkSizeLineEnd;
+                }
+
+                else if (c == '\n')
+                {
+                    this->finishSizeLine();
+                }
+
+                else
+                {
+                    this->state = Failed;
+                }
+
+                ++i;
+                break;
+            }
+
+            case ChunkExtension:
+                i = HttpScanner::findLineEnd(data, i, size);
+                if (i < size)
+                {
+                    if (data[i] == '\r')
+                    {
+                        this->state = ChunkSizeLineEnd;
+                    }
+
+                    else
+                    {
+                        this->finishSizeLine();
+                    }
+
+                    ++i;
+                }
+
+                break;
+
+            case ChunkSizeLineEnd:
+                if (c != '\n')
+                {
+                    this->state = Failed;
+                    break;
+                }
+
+                this->finishSizeLine();
+                ++i;
+                break;
+
+            case ChunkData:
+            {
+                // Return the data of the chunk that has been received so far
+                const int pieceSize = static_cast<int>(qMin(this->remaining, static_cast<qint64>(size - i)));
+                piece = {i, pieceSize};
+                this->remaining -= pieceSize;
+                if (this->remaining == 0)
+                {
+                    this->state = ChunkDataEnd;
+                }
+
+                consumed = i + pieceSize;
+                return Incomplete;
+            }
+
+            case ChunkDataEnd:
+                if (c == '\r')
+                {
+                    this->state = ChunkDataLineEnd;
+                }
+
+                else if (c == '\n')
+                {
+                    this->digits = 0;
+                    this->state = ChunkSize;
+                }
+
+                else
+                {
+                    this->state = Failed;
+                    break;
+                }
+
+                ++i;
+                break;
+
+            case ChunkDataLineEnd:
+                if (c != '\n')
+                {
+                    this->state = Failed;
+                    break;
+                }
+
+                this->digits = 0;
+                this->state = ChunkSize;
+                ++i;
+                break;
+
+            case TrailerStart:
+                if (c == '\r')
+                {
+                    this->state = LastLineEnd;
+                }
+
+                else if (c == '\n')
+                {
+                    consumed = i + 1;
+                    this->state = Done;
+                    return Complete;
+                }
+
+                else
+                {
+                    this->state = Trailer;
+                }
+
+                ++i;
+                break;
+
+            case Trailer:
+                // Trailer fields are not used
+                i = HttpScanner::findLineEnd(data, i, size);
+                if (i < size)
+                {
+                    this->state = data[i] == '\r' ? TrailerLineEnd : TrailerStart;
+                    ++i;
+                }
+
+                break;
+
+            case TrailerLineEnd:
+                if (c != '\n')
+                {
+                    this->state = Failed;
+                    break;
+                }
+
+                this->state = TrailerStart;
+                ++i;
+                break;
+
+            case LastLineEnd:
+                if (c != '\n')
+                {
+                    this->state = Failed;
+                    break;
+                }
+
+                consumed = i + 1;
+                this->state = Done;
+                return Complete;
+
+            case Done:
+                consumed = i;
+                return Complete;
+
+            case Failed:
+                consumed = i;
+                return Invalid;
+        }
+    }
+
+    consumed = i;
+    return this->state == Failed ? Invalid : this->state == Done ? Complete : Incomplete;
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,80 @@
+#ifndef HTTPCHUNKEDDECODER_HPP
+#define HTTPCHUNKEDDECODER_HPP
+
+#include "HttpGlobal.hpp"
+#include "HttpHeaders.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Incremental decoder for a request body with "Transfer-Encoding: chunked".
+  <p>
+  The decoder is fed with the received data as it arrives and returns the pieces of the
+  decoded body as spans into that data, so the body is never copied by the decoder and
+  the encoded body is never buffered. Chunk extensions and trailer fields are skipped.
+  Lines may end with CRLF or LF, like in the head of the request.
+*/
+
+class DECLSPEC HttpChunkedDecoder
+{
+public:
+
+    /** Return values of decode() */
+    enum Result : quint8
+    {
+        Incomplete = 0, // more data is needed
+        Complete,       // the last chunk and the trailer have been received
+        Invalid         // the body is malformed
+    };
+
+    /** Constructor */
+    HttpChunkedDecoder();
+
+    /**
+      Decode the received data until a piece of the body has been found or all data has been consumed.
+      @param data Received data, starting after the data that has been consumed by the previous call
+      @param size Size of the data
+      @param consumed Set to the number of bytes of data that have been consumed, including the piece
+      @param piece Set to the piece of the body in data, with size 0 if there is none
+    */
+    Result decode(const char *data, int size, int &consumed, HttpHeaders::Span &piece);
+
+    /** Start again with a new body */
+    void reset();
+
+private:
+
+    /** States of the decoder */
+    enum State : quint8
+    {
+        ChunkSize = 0,
+        ChunkExtension,
+        ChunkSizeLineEnd,
+        ChunkData,
+        ChunkDataEnd,
+        ChunkDataLineEnd,
+        TrailerStart,
+        Trailer,
+        TrailerLineEnd,
+        LastLineEnd,
+        Done,
+        Failed
+    };
+
+    /** Current state */
+    State state = ChunkSize;
+
+    /** Size of the current chunk while its size is parsed, the rest of it while its data is received */
+    qint64 remaining = 0;
+
+    /** Number of digits of the current chunk size */
+    int digits = 0;
+
+    /** Continue after the line with the size of a chunk */
+    void finishSizeLine();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPCHUNKEDDECODER_HPP
@@ -0,0 +1,331 @@
+#include "HttpClientLimiter.hpp"
+
+#include <cstring>
+
+#include <QtEndian>
+
+#ifdef Q_OS_UNIX
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+uint qHash(const HttpClientLimiter::Address &address, uint seed)
+{
+    return ::qHash(address.high ^ (address.low * Q_UINT64_C(0x9E3779B97F4A7C15)), seed);
+}
+
+HttpClientLimiter::HttpClientLimiter(const HttpServerSettings *settings, HttpServerMetrics *metrics)
+{
+    this->metrics = metrics;
+    this->maxConnections = settings->maxClientConnections;
+    this->rate = settings->clientConnectionRate;
+    this->burst = qMax<double>(settings->clientConnectionBurst ? settings->clientConnectionBurst : settings->clientConnectionRate, 1.0);
+    this->requestRate = settings->clientRequestRate;
+    this->requestBurst = qMax<double>(settings->clientRequestBurst ? settings->clientRequestBurst : settings->clientRequestRate, 1.0);
+    this->clock.start();
+}
+
+bool HttpClientLimiter::isEnabled() const
+{
+    return this->maxConnections > 0 || this->rate > 0.0 || this->requestRate > 0.0;
+}
+
+HttpClientLimiter::Address HttpClientLimiter::fromBytes(const quint8 *bytes)
+{
+    Address address;
+    memcpy(&address.high, bytes, sizeof(address.high));
+    memcpy(&address.low, bytes + sizeof(address.high), sizeof(address.low));
+    return address;
+}
+
+bool HttpClientLimiter::getPeerAddress(qintptr socketDescriptor, Address &address)
+{
+#ifdef Q_OS_UNIX
+    sockaddr_storage storage;
+    socklen_t length = sizeof(storage);
+
+    if (::getpeername(static_cast<int>(socketDescriptor), reinterpret_cast<sockaddr*>(&storage), &length) == -1)
+    {
+        return false;
+    }
+
+    quint8 bytes[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 0, 0, 0, 0};
+
+    if (storage.ss_family == AF_INET)
+    {
+        memcpy(bytes + 12, &reinterpret_cast<sockaddr_in*>(&storage)->sin_addr, 4);
+    }
+
+    else if (storage.ss_family == AF_INET6)
+    {
+        memcpy(bytes, &reinterpret_cast<sockaddr_in6*>(&storage)->sin6_addr, 16);
+    }
+
+    else
+    {
+        return false;
+    }
+
+    address = fromBytes(bytes);
+    return true;
+#else
+    Q_UNUSED(socketDescriptor)
+    Q_UNUSED(address)
+    return false;
+#endif
+}
+
+bool HttpClientLimiter::fromHostAddress(const QHostAddress &hostAddress, Address &address)
+{
+    quint8 bytes[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 0, 0, 0, 0};
+
+    if (hostAddress.protocol() == QAbstractSocket::IPv4Protocol)
+    {
+        const quint32 ip4 = qToBigEndian(hostAddress.toIPv4Address());
+        memcpy(bytes + 12, &ip4, 4);
+    }
+
+    else if (hostAddress.protocol() == QAbstractSocket::IPv6Protocol)
+    {
+        const Q_IPV6ADDR ip6 = hostAddress.toIPv6Address();
+        memcpy(bytes, &ip6, 16);
+    }
+
+    else
+    {
+        return false;
+    }
+
+    address = fromBytes(bytes);
+    return true;
+}
+
+HttpClientLimiter::Stripe &HttpClientLimiter::getStripe(const Address &address)
+{
+    return this->stripes[qHash(address, 0) % stripeCount];
+}
+
+HttpClientLimiter::Stripe &HttpClientLimiter::getStripe(qintptr socketDescriptor)
+{
+    return this->stripes[static_cast<quintptr>(socketDescriptor) % stripeCount];
+}
+
+bool HttpClientLimiter::takeAddress(qintptr socketDescriptor, Address &address)
+{
+    Stripe &stripe = this->getStripe(socketDescriptor);
+    QMutexLocker locker(&stripe.mutex);
+
+    auto it = stripe.sockets.find(socketDescriptor);
+    if (it == stripe.sockets.end())
+    {
+        return false;
+    }
+
+    address = it.value();
+    stripe.sockets.erase(it);
+    return true;
+}
+
+void HttpClientLimiter::refill(Client &client, qint64 now) const
+{
+    if (this->rate > 0.0)
+    {
+        client.tokens = qMin(this->burst, client.tokens + (now - client.updated) * this->rate / 1000.0);
+    }
+
+    if (this->requestRate > 0.0)
+    {
+        client.requestTokens = qMin(this->requestBurst, client.requestTokens + (now - client.updated) * this->requestRate / 1000.0);
+    }
+
+    client.updated = now;
+}
+
+bool HttpClientLimiter::acquire(qintptr socketDescriptor)
+{
+    Address address;
+    if (!this->isEnabled() || !getPeerAddress(socketDescriptor, address))
+    {
+        return true;
+    }
+
+    const qint64 now = this->clock.elapsed();
+    Stripe &stripe = this->getStripe(address);
+    QMutexLocker locker(&stripe.mutex);
+
+    auto it = stripe.clients.find(address);
+    if (it == stripe.clients.end())
+    {
+        Client client;
+        client.tokens = this->burst;
+        client.requestTokens = this->requestBurst;
+        client.updated = now;
+        it = stripe.clients.insert(address, client);
+    }
+
+    Client &client = it.value();
+
+    if (this->maxConnections > 0 && client.connections >= this->maxConnections)
+    {
+        locker.unlock();
+        this->metrics->addCappedConnection();
+        return false;
+    }
+
+    if (this->rate > 0.0)
+    {
+        this->refill(client, now);
+
+        if (client.tokens < 1.0)
+        {
+            locker.unlock();
+            this->metrics->addThrottledConnection();
+            return false;
+        }
+
+        client.tokens -= 1.0;
+    }
+
+    ++client.connections;
+    locker.unlock();
+
+    // The peer may be gone when the connection is released, so its address is kept
+    Stripe &socketStripe = this->getStripe(socketDescriptor);
+    QMutexLocker socketLocker(&socketStripe.mutex);
+    socketStripe.sockets.insert(socketDescriptor, address);
+    return true;
+}
+
+void HttpClientLimiter::release(qintptr socketDescriptor)
+{
+    Address address;
+    if (this->isEnabled() && this->takeAddress(socketDescriptor, address))
+    {
+        this->release(address);
+    }
+}
+
+QHostAddress HttpClientLimiter::detach(qintptr socketDescriptor)
+{
+    Address address;
+    if (!this->isEnabled() || !this->takeAddress(socketDescriptor, address))
+    {
+        return QHostAddress();
+    }
+
+    quint8 bytes[16];
+    memcpy(bytes, &address.high, sizeof(address.high));
+    memcpy(bytes + sizeof(address.high), &address.low, sizeof(address.low));
+    return QHostAddress(bytes);
+}
+
+void HttpClientLimiter::attach(qintptr socketDescriptor, const QHostAddress &hostAddress)
+{
+    Address address;
+    if (!this->isEnabled() || !fromHostAddress(hostAddress, address))
+    {
+        return;
+    }
+
+    Stripe &stripe = this->getStripe(socketDescriptor);
+    QMutexLocker locker(&stripe.mutex);
+    stripe.sockets.insert(socketDescriptor, address);
+}
+
+void HttpClientLimiter::release(const QHostAddress &hostAddress)
+{
+    Address address;
+    if (this->isEnabled() && fromHostAddress(hostAddress, address))
+    {
+        this->release(address);
+    }
+}
+
+bool HttpClientLimiter::acquireRequest(const QHostAddress &hostAddress)
+{
+    Address address;
+    if (this->requestRate <= 0.0 || !fromHostAddress(hostAddress, address))
+    {
+        return true;
+    }
+
+    const qint64 now = this->clock.elapsed();
+    Stripe &stripe = this->getStripe(address);
+    QMutexLocker locker(&stripe.mutex);
+
+    // The client stays in the table as long as it has an open connection
+    auto it = stripe.clients.find(address);
+    if (it == stripe.clients.end())
+    {
+        return true;
+    }
+
+    Client &client = it.value();
+    this->refill(client, now);
+
+    if (client.requestTokens < 1.0)
+    {
+        locker.unlock();
+        this->metrics->addThrottledRequest();
+        return false;
+    }
+
+    client.requestTokens -= 1.0;
+    return true;
+}
+
+void HttpClientLimiter::release(const Address &address)
+{
+    Stripe &stripe = this->getStripe(address);
+    QMutexLocker locker(&stripe.mutex);
+
+    auto it = stripe.clients.find(address);
+    if (it != stripe.clients.end() && it.value().connections > 0)
+    {
+        --it.value().connections;
+    }
+}
+
+void HttpClientLimiter::decay()
+{
+    const qint64 now = this->clock.elapsed();
+
+    for (Stripe &stripe : this->stripes)
+    {
+        QMutexLocker locker(&stripe.mutex);
+
+        for (auto it = stripe.clients.begin(); it != stripe.clients.end();)
+        {
+            this->refill(it.value(), now);
+
+            // A new entry would look the same, so the client can be forgotten
+            if (it.value().connections == 0 && (this->rate <= 0.0 || it.value().tokens >= this->burst) &&
+                (this->requestRate <= 0.0 || it.value().requestTokens >= this->requestBurst))
+            {
+                it = stripe.clients.erase(it);
+            }
+
+            else
+            {
+                ++it;
+            }
+        }
+    }
+}
+
+int HttpClientLimiter::getClientCount() const
+{
+    int count = 0;
+
+    for (const Stripe &stripe : this->stripes)
+    {
+        QMutexLocker locker(&stripe.mutex);
+        count += stripe.clients.size();
+    }
+
+    return count;
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
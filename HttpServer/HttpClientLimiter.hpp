@@ -0,0 +1,185 @@
+#ifndef HTTPCLIENTLIMITER_HPP
+#define HTTPCLIENTLIMITER_HPP
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QMutex>
+
+#include "HttpGlobal.hpp"
+#include "HttpServerMetrics.hpp"
+#include "HttpServerSettings.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Limits the connections and requests of each client address. Connections are checked before a
+  handler or worker is taken for them, requests before they are parsed.
+  <p>
+  Example for the configuration settings:
+  <code><pre>
+  maxClientConnections=20
+  clientConnectionRate=10
+  clientConnectionBurst=50
+  clientRequestRate=100
+  clientRequestBurst=200
+  </pre></code>
+  maxClientConnections caps the number of open connections of one address. clientConnectionRate
+  is a token bucket: an address may open that many connections per second on average, and up to
+  clientConnectionBurst connections at once after it has been quiet (0 = the same as the rate).
+  Connections above a limit are rejected with "429 Too Many Requests". clientRequestRate and
+  clientRequestBurst form a second token bucket that each request takes a token from, including
+  the requests of keep-alive connections. A request without a token is answered with
+  "429 Too Many Requests" and its connection is closed. 0 disables a limit.
+  <p>
+  The clients are kept in a hash table that is split into stripes with their own locks, so the
+  acceptors of different shards rarely wait for each other. IPv4 and IPv4-mapped IPv6 addresses
+  count as the same client. decay() removes the clients that have no open connection and a full
+  bucket, it is called periodically by the listener.
+  <p>
+  The address of a connection is read once by acquire(). While the connection is passed around
+  as a socket descriptor, the limiter remembers the address of that descriptor, so release() does
+  not depend on the peer being still connected. The owner of an open connection takes the address
+  with detach() and releases the connection with it later.
+  <p>
+  All methods are thread safe. Client addresses are only known on Unix, on other platforms
+  the limits are not enforced.
+  @see HttpServerMetrics for the number of rejected connections
+*/
+
+class DECLSPEC HttpClientLimiter
+{
+    Q_DISABLE_COPY(HttpClientLimiter)
+
+public:
+
+    /**
+      Constructor.
+      @param settings Configuration settings for the HTTP server. Must not be 0.
+      @param metrics Counts the rejected connections. Must not be 0.
+    */
+    HttpClientLimiter(const HttpServerSettings *settings, HttpServerMetrics *metrics);
+
+    /** Returns true if at least one limit is configured */
+    bool isEnabled() const;
+
+    /**
+      Count a new connection of the peer of the socket and remember its address.
+      @param socketDescriptor references the accepted connection.
+      @return false if the client has exceeded a limit, the connection must be rejected then.
+    */
+    bool acquire(qintptr socketDescriptor);
+
+    /**
+      Count a closed connection with the address that acquire() or attach() has remembered.
+      @param socketDescriptor references the connection, it must not be closed yet.
+    */
+    void release(qintptr socketDescriptor);
+
+    /**
+      Forget the address of a socket, the caller releases the connection with it.
+      @param socketDescriptor references the connection, it must not be closed yet.
+      @return the address, null if the connection is not counted.
+    */
+    QHostAddress detach(qintptr socketDescriptor);
+
+    /**
+      Remember the address of a connection that has been counted already, e.g. after its
+      socket descriptor has been duplicated.
+      @param socketDescriptor references the connection.
+      @param address Address that detach() has returned, nothing happens if it is null.
+    */
+    void attach(qintptr socketDescriptor, const QHostAddress &address);
+
+    /** Count a closed connection of a client */
+    void release(const QHostAddress &address);
+
+    /**
+      Take a token of the request rate of a client.
+      @param address Address that detach() has returned for the connection of the request
+      @return false if the client has exceeded the request rate, the request must be rejected then.
+    */
+    bool acquireRequest(const QHostAddress &address);
+
+    /** Remove the clients that have no open connection and a full bucket */
+    void decay();
+
+    /** Number of clients in the table */
+    int getClientCount() const;
+
+private:
+
+    /** Client address as IPv6, IPv4 addresses are mapped */
+    struct Address
+    {
+        quint64 high;
+        quint64 low;
+
+        bool operator==(const Address &other) const
+        {
+            return this->high == other.high && this->low == other.low;
+        }
+    };
+
+    friend uint qHash(const Address &address, uint seed);
+
+    struct Client
+    {
+        quint32 connections = 0;
+        double tokens = 0.0;
+        double requestTokens = 0.0;
+        qint64 updated = 0; // time of the last refill of the buckets
+    };
+
+    struct Stripe
+    {
+        mutable QMutex mutex;
+        QHash<Address, Client> clients;
+        QHash<qintptr, Address> sockets; // counted connections, keyed by socket descriptor
+    };
+
+    static const int stripeCount = 64;
+
+    Stripe stripes[stripeCount];
+
+    /** Counters of the listener */
+    HttpServerMetrics *metrics = nullptr;
+
+    quint32 maxConnections = 0;
+    double rate = 0.0;
+    double burst = 0.0;
+    double requestRate = 0.0;
+    double requestBurst = 0.0;
+
+    /** Time base of the buckets */
+    QElapsedTimer clock;
+
+    /** Read the address of the peer of a socket */
+    static bool getPeerAddress(qintptr socketDescriptor, Address &address);
+
+    /** Convert a 16 byte IPv6 address */
+    static Address fromBytes(const quint8 *bytes);
+
+    /** Convert a QHostAddress, returns false if it is neither IPv4 nor IPv6 */
+    static bool fromHostAddress(const QHostAddress &hostAddress, Address &address);
+
+    /** Stripe that holds an address */
+    Stripe &getStripe(const Address &address);
+
+    /** Stripe that holds the address of a socket */
+    Stripe &getStripe(qintptr socketDescriptor);
+
+    /** Remove the remembered address of a socket, returns false if there is none */
+    bool takeAddress(qintptr socketDescriptor, Address &address);
+
+    /** Add the tokens of both buckets that have accrued since the last refill */
+    void refill(Client &client, qint64 now) const;
+
+    /** Count a closed connection */
+    void release(const Address &address);
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPCLIENTLIMITER_HPP
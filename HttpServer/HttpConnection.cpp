@@ -0,0 +1,767 @@
+#ifndef QT_NO_OPENSSL
+    #include <QSslSocket>
+    #include <QSslKey>
+    #include <QSslCertificate>
+    #include <QSslConfiguration>
+#endif
+
+#include <QFile>
+
+#ifdef Q_OS_UNIX
+    #include <fcntl.h>
+#endif
+
+#include "HttpConnection.hpp"
+#include "HttpResponse.hpp"
+#include "HttpSocketOptions.hpp"
+#include "HttpUringSocket.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpConnection::HttpConnection(HttpServerSettings *settings, HttpRequestHandler *requestHandler, HttpTimerWheel *timerWheel, HttpClientLimiter *limiter,
+                               HttpServerMetrics *metrics, QSslConfiguration *sslConfiguration, HttpUring *uring, QObject *parent)
+    : QObject(parent),
+      readTimer(timerWheel, [this]() { this->readTimeout(); }),
+      writeTimer(timerWheel, [this]() { this->writeTimeout(); }),
+      resumeTimer(timerWheel, [this]() { this->resumeReading(); })
+{
+    Q_ASSERT(requestHandler != nullptr);
+
+    this->settings = settings;
+    this->requestHandler = requestHandler;
+    this->limiter = limiter;
+    this->metrics = metrics;
+    this->sslConfiguration = sslConfiguration;
+    this->uring = uring;
+
+    // Create TCP or SSL socket, the socket is a child so it follows moveToThread()
+    this->createSocket();
+
+    // Connect signals
+    QObject::connect(this->socket, &QTcpSocket::readyRead, this, &HttpConnection::read);
+    QObject::connect(this->socket, &QTcpSocket::disconnected, this, &HttpConnection::disconnected);
+    QObject::connect(this->socket, &QTcpSocket::bytesWritten, this, &HttpConnection::bytesWritten);
+}
+
+HttpConnection::~HttpConnection()
+{
+    this->readTimer.stop();
+    this->writeTimer.stop();
+    this->resumeTimer.stop();
+    this->socket->close();
+    this->discardRequest();
+
+    if (this->metrics)
+    {
+        this->metrics->addBufferedBytes(-this->bufferedBytes);
+    }
+}
+
+void HttpConnection::createSocket()
+{
+    // If SSL is supported and configured, then create an instance of QSslSocket
+    #ifndef QT_NO_OPENSSL
+        if (this->sslConfiguration)
+        {
+            QSslSocket *sslSocket = new QSslSocket(this);
+            sslSocket->setSslConfiguration(*sslConfiguration);
+            this->socket = sslSocket;
+            qDebug("HttpConnection (%p): SSL is enabled", this);
+            return;
+        }
+    #endif
+
+    if (this->uring)
+    {
+        this->socket = new HttpUringSocket(this->uring, this);
+        return;
+    }
+
+    // else create an instance of QTcpSocket
+    this->socket = new QTcpSocket(this);
+}
+
+bool HttpConnection::open(tSocketDescriptor socketDescriptor)
+{
+    qDebug("HttpConnection (%p): handle new connection", this);
+    Q_ASSERT(this->socket->isOpen() == false); // if not, then the connection is already in use
+
+    ///// FIXME: is this still required?
+    // UGLY workaround - we need to clear writebuffer before reusing this socket
+    // https://bugreports.qt-project.org/browse/QTBUG-28914
+    this->socket->connectToHost("", 0);
+    this->socket->abort();
+
+    if (!this->socket->setSocketDescriptor(socketDescriptor))
+    {
+        qCritical("HttpConnection (%p): cannot initialize socket: %s", this, qPrintable(this->socket->errorString()));
+
+        if (this->limiter)
+        {
+            this->limiter->release(socketDescriptor);
+        }
+
+        return false;
+    }
+
+    this->peerAddress = this->socket->peerAddress();
+
+    // From now on this connection releases the client, with the address that the limiter has counted
+    if (this->limiter)
+    {
+        this->limitedAddress = this->limiter->detach(socketDescriptor);
+    }
+
+    HttpSocketOptions::applyToConnection(this->socket, *this->settings);
+
+    #ifndef QT_NO_OPENSSL
+        // Switch on encryption, if SSL is configured
+        if (this->sslConfiguration)
+        {
+            qDebug("HttpConnection (%p): Starting encryption", this);
+            static_cast<QSslSocket*>(this->socket)->startServerEncryption();
+        }
+    #endif
+
+    // Start timer for read timeout
+    this->readTimer.start(this->settings->readTimeout);
+
+    // delete previous request
+    this->discardRequest();
+    this->receiveBuffer.clear();
+    this->idle = false;
+    this->paused = false;
+    this->socket->setReadBufferSize(0);
+
+    return true;
+}
+
+bool HttpConnection::isOpen() const
+{
+    return this->socket->isOpen();
+}
+
+void HttpConnection::drain()
+{
+    this->draining = true;
+
+    if (this->idle && this->socket->isOpen())
+    {
+        qDebug("HttpConnection (%p): closing idle connection", this);
+        this->socket->disconnectFromHost();
+    }
+}
+
+tSocketDescriptor HttpConnection::park()
+{
+#ifdef Q_OS_UNIX
+    // Only a plain TCP connection without buffered data can be continued by another socket object
+    if (!this->idle || this->draining || this->sslConfiguration || !this->socket->isOpen() ||
+        this->socket->bytesAvailable() > 0 || this->socket->bytesToWrite() > 0 || !this->receiveBuffer.isEmpty())
+    {
+        return -1;
+    }
+
+    // The socket object closes its descriptor, so the connection continues on a duplicate
+    const int socketDescriptor = ::fcntl(static_cast<int>(this->socket->socketDescriptor()), F_DUPFD_CLOEXEC, 0);
+    if (socketDescriptor == -1)
+    {
+        return -1;
+    }
+
+    qDebug("HttpConnection (%p): parking idle connection", this);
+
+    this->readTimer.stop();
+    this->idle = false;
+
+    // Closing the socket object must not look like a disconnect of the client
+    this->socket->blockSignals(true);
+    this->socket->abort();
+    this->socket->blockSignals(false);
+
+    // The parker releases the client from now on
+    if (this->limiter)
+    {
+        this->limiter->attach(socketDescriptor, this->limitedAddress);
+    }
+
+    this->limitedAddress.clear();
+    this->updateBufferedBytes();
+
+    return socketDescriptor;
+#else
+    return -1;
+#endif
+}
+
+void HttpConnection::readTimeout()
+{
+    qDebug("HttpConnection (%p): read timeout occured", this);
+
+    this->socket->flush();
+    this->socket->disconnectFromHost();
+    this->discardRequest();
+    this->watchWrites();
+}
+
+void HttpConnection::writeTimeout()
+{
+    qDebug("HttpConnection (%p): write timeout occured", this);
+    this->socket->abort();
+}
+
+void HttpConnection::watchWrites()
+{
+    if (this->settings->writeTimeout && this->socket->bytesToWrite() > 0 && !this->writeTimer.isActive())
+    {
+        this->writeTimer.start(static_cast<int>(this->settings->writeTimeout));
+    }
+
+    this->updateBufferedBytes();
+}
+
+void HttpConnection::bytesWritten()
+{
+    // Any progress restarts the write timeout
+    if (this->socket->bytesToWrite() > 0)
+    {
+        if (this->settings->writeTimeout)
+        {
+            this->writeTimer.start(static_cast<int>(this->settings->writeTimeout));
+        }
+    }
+
+    else
+    {
+        this->writeTimer.stop();
+    }
+
+    if (this->currentResponse && this->currentResponse->isDeferred() && !this->servingRequest)
+    {
+        this->currentResponse->updateBackpressure();
+    }
+
+    this->updateBufferedBytes();
+}
+
+void HttpConnection::disconnected()
+{
+    qDebug("HttpConnection (%p): disconnected", this);
+
+    this->socket->close();
+    this->readTimer.stop();
+    this->writeTimer.stop();
+    this->resumeTimer.stop();
+    this->paused = false;
+    this->receiveBuffer.clear();
+
+    // Only once, disconnected() may be received again when the object is reused
+    if (this->limiter && !this->limitedAddress.isNull())
+    {
+        this->limiter->release(this->limitedAddress);
+        this->limitedAddress.clear();
+    }
+
+    // A deferred response that is not complete yet gets disconnected from its handle
+    if (!this->servingRequest)
+    {
+        this->discardRequest();
+    }
+
+    this->updateBufferedBytes();
+    emit this->closed();
+}
+
+void HttpConnection::discardRequest()
+{
+    delete this->currentResponse;
+    this->currentResponse = nullptr;
+
+    delete this->currentRequest;
+    this->currentRequest = nullptr;
+}
+
+void HttpConnection::read()
+{
+    // A streamed body is read while the request handler works on the response
+    if (this->currentRequest && this->currentRequest->isBodyStreamed() && this->currentRequest->getStatus() == HttpRequest::WaitForBody)
+    {
+        this->readStreamedBody();
+        return;
+    }
+
+    // A deferred response must be completed before the next request is processed
+    if (this->currentResponse || this->paused)
+    {
+        return;
+    }
+
+    // The socket has buffered new data
+    this->updateBufferedBytes();
+
+    // The loop adds support for HTTP pipelinig, a pipelined request remains in the receive buffer
+    while (this->socket->state() == QAbstractSocket::ConnectedState &&
+           (!this->receiveBuffer.isEmpty() || this->socket->bytesAvailable() > 0))
+    {
+        #ifdef QTWEBAPP_SUPERVERBOSE
+            qDebug("HttpConnection (%p): read input", this);
+        #endif
+
+        // Create new HttpRequest object if necessary
+        if (!this->currentRequest)
+        {
+            // While the memory budget is exhausted, new requests are rejected
+            if (this->isOverBudget())
+            {
+                this->shedRequest();
+                return;
+            }
+
+            // Each request takes a token of the request rate of its client
+            if (this->limiter && !this->limitedAddress.isNull() && !this->limiter->acquireRequest(this->limitedAddress))
+            {
+                this->throttleRequest();
+                return;
+            }
+
+            this->currentRequest = new HttpRequest(this->settings, this->peerAddress, this->requestHandler, this);
+            this->idle = false;
+        }
+
+        // and partly received headers wait until other connections have released memory.
+        // A body is not paused, it has been reserved already.
+        else if (this->currentRequest->getStatus() != HttpRequest::WaitForBody && this->isOverBudget())
+        {
+            qDebug("HttpConnection (%p): memory budget exhausted, pausing", this);
+            this->paused = true;
+            this->socket->setReadBufferSize(4096);
+            this->resumeTimer.start(100);
+            return;
+        }
+
+        // Collect data for the request object
+        if (this->socket->bytesAvailable() > 0)
+        {
+            this->receiveBuffer.append(this->socket->readAll());
+        }
+
+        const HttpRequest::RequestStatus previousStatus = this->currentRequest->getStatus();
+        const int consumed = this->currentRequest->readFromBuffer(this->receiveBuffer);
+        if (consumed == this->receiveBuffer.size())
+        {
+            this->receiveBuffer.clear();
+        }
+
+        else if (consumed > 0)
+        {
+            // Only the rest is copied, the request may still share the consumed part
+            this->receiveBuffer = this->receiveBuffer.mid(consumed);
+        }
+
+        if (this->currentRequest->getStatus() == HttpRequest::WaitForBody)
+        {
+            // Restart timer for read timeout, otherwise it would
+            // expire during large file uploads.
+            this->readTimer.start(this->settings->readTimeout);
+
+            // The announced body is reserved before it is read, it must fit into the memory budget
+            if (previousStatus != HttpRequest::WaitForBody)
+            {
+                this->updateBufferedBytes();
+                if (this->isOverBudget())
+                {
+                    this->shedRequest();
+                    return;
+                }
+            }
+        }
+
+        this->updateBufferedBytes();
+
+        // If the request is aborted, return error message and close the connection
+        if (this->currentRequest->getStatus() == HttpRequest::Abort)
+        {
+            this->socket->write("HTTP/1.1 413 Entity Too Large\nConnection: close\n\n413 Entity Too Large\n");
+            this->socket->flush();
+            this->socket->disconnectFromHost();
+            this->discardRequest();
+            return;
+        }
+
+        // If the request is complete or its body is streamed, let the request mapper dispatch it
+        const bool streamed = this->currentRequest->isBodyStreamed() && this->currentRequest->getStatus() == HttpRequest::WaitForBody;
+        if (this->currentRequest->getStatus() == HttpRequest::Complete || streamed)
+        {
+            this->readTimer.stop();
+            qDebug("HttpConnection (%p): received request", this);
+
+            // Copy the Connection:close header to the response
+            this->currentResponse = new HttpResponse(this->socket, this, this->settings);
+            this->closeConnection = this->currentRequest->hasHeaderValue(HttpHeaders::Connection, "close");
+            if (this->closeConnection)
+            {
+                this->currentResponse->setHeader("Connection", "close");
+            }
+
+            // In case of HTTP 1.0 protocol add the Connection:close header.
+            // This ensures that the HttpResponse does not activate chunked mode, which is not spported by HTTP 1.0.
+            // The same applies when the server is draining its connections.
+            else
+            {
+                if (qstricmp(this->currentRequest->getVersion().constData(), "HTTP/1.0") == 0 || this->draining)
+                {
+                    this->closeConnection = true;
+                    this->currentResponse->setHeader("Connection", "close");
+                }
+            }
+
+            // Call the request mapper
+            this->servingRequest = true;
+            try
+            {
+                this->requestHandler->service(*this->currentRequest, *this->currentResponse);
+            }
+
+            catch (...)
+            {
+                qCritical("HttpConnection (%p): An uncatched exception occured in the request handler", this);
+            }
+
+            this->servingRequest = false;
+            this->updateBufferedBytes();
+
+            // The client may have disconnected while the request handler was busy
+            if (!this->socket->isOpen())
+            {
+                this->discardRequest();
+                return;
+            }
+
+            // Leave a deferred response to the request handler, but do not wait longer than readTimeout
+            if (this->currentResponse->isDeferred() && !this->currentResponse->hasSentLastPart())
+            {
+                qDebug("HttpConnection (%p): response deferred", this);
+                this->currentResponse->flush();
+                this->currentResponse->updateBackpressure();
+                this->watchWrites();
+                this->readTimer.start(this->settings->readTimeout);
+
+                // The body follows the head
+                if (streamed)
+                {
+                    this->readStreamedBody();
+                }
+
+                return;
+            }
+
+            this->finishRequest();
+        }
+
+        // Wait for the rest of the request
+        else
+        {
+            break;
+        }
+    }
+}
+
+void HttpConnection::deferredUpdate()
+{
+    if (!this->currentResponse)
+    {
+        return;
+    }
+
+    this->servingRequest = true;
+    this->currentResponse->applyDeferred();
+    this->servingRequest = false;
+    this->watchWrites();
+
+    if (!this->socket->isOpen())
+    {
+        this->discardRequest();
+        return;
+    }
+
+    if (!this->currentResponse->hasSentLastPart())
+    {
+        // The handler is making progress, so give it another readTimeout
+        this->currentResponse->flush();
+        this->currentResponse->updateBackpressure();
+        this->readTimer.start(this->settings->readTimeout);
+        return;
+    }
+
+    this->finishRequest();
+
+    // Process the requests that the client has sent in the meantime
+    if (this->socket->isOpen())
+    {
+        this->read();
+    }
+}
+
+void HttpConnection::readStreamedBody()
+{
+    while (this->socket->state() == QAbstractSocket::ConnectedState &&
+           this->currentRequest->getStatus() == HttpRequest::WaitForBody && !this->currentRequest->isBodyPaused() &&
+           (!this->receiveBuffer.isEmpty() || this->socket->bytesAvailable() > 0))
+    {
+        if (this->socket->bytesAvailable() > 0)
+        {
+            this->receiveBuffer.append(this->socket->readAll());
+        }
+
+        // The request passes the data to the body callback of the request handler
+        int consumed = 0;
+        this->servingRequest = true;
+        try
+        {
+            consumed = this->currentRequest->readFromBuffer(this->receiveBuffer);
+        }
+
+        catch (...)
+        {
+            qCritical("HttpConnection (%p): An uncatched exception occured in the body callback", this);
+            this->socket->abort();
+        }
+
+        this->servingRequest = false;
+
+        if (consumed == this->receiveBuffer.size())
+        {
+            this->receiveBuffer.clear();
+        }
+
+        else if (consumed > 0)
+        {
+            this->receiveBuffer = this->receiveBuffer.mid(consumed);
+        }
+
+        // Otherwise the rest of a chunk header is missing
+        else if (this->socket->bytesAvailable() == 0)
+        {
+            break;
+        }
+
+        // Any progress restarts the read timeout
+        this->readTimer.start(this->settings->readTimeout);
+    }
+
+    if (!this->socket->isOpen())
+    {
+        this->discardRequest();
+        return;
+    }
+
+    if (this->currentRequest->getStatus() == HttpRequest::Abort)
+    {
+        qWarning("HttpConnection (%p): received broken streamed body", this);
+        this->socket->abort();
+        this->discardRequest();
+        return;
+    }
+
+    // While the body is paused, the socket takes only a little data, the rest waits in the kernel
+    this->socket->setReadBufferSize(this->currentRequest->isBodyPaused() ? 4096 : 0);
+    this->updateBufferedBytes();
+}
+
+void HttpConnection::resumeStreamedBody()
+{
+    this->read();
+}
+
+void HttpConnection::resumeReading()
+{
+    if (this->isOverBudget())
+    {
+        this->resumeTimer.start(100);
+        return;
+    }
+
+    qDebug("HttpConnection (%p): resuming", this);
+    this->paused = false;
+    this->socket->setReadBufferSize(0);
+    this->read();
+}
+
+void HttpConnection::updateBufferedBytes()
+{
+    if (!this->metrics)
+    {
+        return;
+    }
+
+    qint64 usage = 0;
+
+    if (this->socket->isOpen())
+    {
+        usage += this->socket->bytesAvailable() + this->socket->bytesToWrite();
+    }
+
+    usage += this->receiveBuffer.size();
+
+    if (this->currentRequest)
+    {
+        usage += this->currentRequest->getReservedSize();
+    }
+
+    if (usage != this->bufferedBytes)
+    {
+        this->metrics->addBufferedBytes(usage - this->bufferedBytes);
+        this->bufferedBytes = usage;
+    }
+}
+
+bool HttpConnection::isOverBudget() const
+{
+    return this->settings->maxBufferedBytes > 0 && this->metrics &&
+           this->metrics->getBufferedBytes() >= this->settings->maxBufferedBytes;
+}
+
+void HttpConnection::shedRequest()
+{
+    qWarning("HttpConnection (%p): memory budget exhausted, rejecting request", this);
+    this->metrics->addShedRequest();
+
+    this->socket->write("HTTP/1.1 503 Service Unavailable\nConnection: close\nRetry-After: 1\n\n503 Service Unavailable\n");
+    this->socket->flush();
+    this->socket->disconnectFromHost();
+    this->discardRequest();
+    this->updateBufferedBytes();
+}
+
+void HttpConnection::throttleRequest()
+{
+    qDebug("HttpConnection (%p): client exceeded the request rate, rejecting request", this);
+
+    this->socket->write("HTTP/1.1 429 Too Many Requests\nConnection: close\nRetry-After: 1\n\nToo Many Requests\n");
+    this->socket->flush();
+    this->socket->disconnectFromHost();
+    this->discardRequest();
+    this->updateBufferedBytes();
+}
+
+void HttpConnection::finishRequest()
+{
+    // Finalize sending the response if not already done
+    if (!this->currentResponse->hasSentLastPart())
+    {
+        this->currentResponse->write(QByteArray(), true);
+    }
+
+    qDebug("HttpConnection (%p): finished request", this);
+
+    // Find out whether the connection must be closed
+    if (this->draining)
+    {
+        this->closeConnection = true;
+    }
+
+    // The rest of a streamed body cannot be told apart from the next request
+    else if (this->currentRequest->isBodyStreamed() && this->currentRequest->getStatus() != HttpRequest::Complete)
+    {
+        qDebug("HttpConnection (%p): response completed before the streamed body", this);
+        this->closeConnection = true;
+    }
+
+    else if (!this->closeConnection)
+    {
+        // Maybe the request handler or mapper added a Connection:close header in the meantime
+        if (QString::compare(this->currentResponse->getHeaders().value("Connection"), "close", Qt::CaseInsensitive) == 0)
+        {
+            this->closeConnection = true;
+        }
+
+        else
+        {
+            // If we have no Content-Length header and did not use chunked mode, then we have to close the
+            // connection to tell the HTTP client that the end of the response has been reached.
+            if (!this->currentResponse->getHeaders().contains("Content-Length"))
+            {
+                if (QString::compare(this->currentResponse->getHeaders().value("Transfer-Encoding"), "chunked", Qt::CaseInsensitive) != 0)
+                {
+                    this->closeConnection = true;
+                }
+            }
+        }
+    }
+
+    this->discardRequest();
+    this->updateBufferedBytes();
+
+    // Close the connection or prepare for the next request on the same connection.
+    if (this->closeConnection)
+    {
+        this->socket->flush();
+        this->socket->disconnectFromHost();
+        this->watchWrites();
+    }
+
+    else
+    {
+        // Start timer for next request
+        this->idle = true;
+        this->readTimer.start(this->settings->readTimeout);
+        this->watchWrites();
+        emit this->waiting();
+    }
+}
+
+QSslConfiguration *HttpConnection::createSslConfiguration(const HttpServerSettings *settings)
+{
+    // If certificate and key files are configured, then load them
+    QString sslKeyFileName = settings->sslKeyFile;
+    QString sslCertFileName = settings->sslCertFile;
+
+    if (sslKeyFileName.isEmpty() || sslCertFileName.isEmpty())
+    {
+        return nullptr;
+    }
+
+    #ifdef QT_NO_OPENSSL
+        qWarning("HttpConnection: SSL is not supported");
+        return nullptr;
+    #else
+
+        /// TODO / IMPROVEMENT:
+        ///  all platforms: resolve environment variables in path
+        ///  unix: resolve home tilde to home path
+
+        // Load the SSL certificate
+        QFile certFile(sslCertFileName);
+        if (!certFile.open(QIODevice::ReadOnly))
+        {
+            qCritical("HttpConnection: cannot open sslCertFile %s", qUtf8Printable(sslCertFileName));
+            return nullptr;
+        }
+
+        QSslCertificate certificate(&certFile, QSsl::Pem);
+        certFile.close();
+
+        // Load the key file
+        QFile keyFile(sslKeyFileName);
+        if (!keyFile.open(QIODevice::ReadOnly))
+        {
+            qCritical("HttpConnection: cannot open sslKeyFile %s", qUtf8Printable(sslKeyFileName));
+            return nullptr;
+        }
+
+        QSslKey sslKey(&keyFile, QSsl::Rsa, QSsl::Pem);
+        keyFile.close();
+
+        // Create the SSL configuration
+        QSslConfiguration *sslConfiguration = new QSslConfiguration();
+        sslConfiguration->setLocalCertificate(certificate);
+        sslConfiguration->setPrivateKey(sslKey);
+        sslConfiguration->setPeerVerifyMode(QSslSocket::VerifyNone);
+        sslConfiguration->setProtocol(QSsl::TlsV1SslV3);
+
+        qDebug("HttpConnection: SSL settings loaded");
+        return sslConfiguration;
+    #endif
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
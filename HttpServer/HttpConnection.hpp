@@ -0,0 +1,261 @@
+#ifndef HTTPCONNECTION_HPP
+#define HTTPCONNECTION_HPP
+
+#ifndef QT_NO_OPENSSL
+   #include <QSslConfiguration>
+#endif
+
+#include <QObject>
+#include <QTcpSocket>
+
+#include "HttpGlobal.hpp"
+#include "HttpClientLimiter.hpp"
+#include "HttpRequest.hpp"
+#include "HttpRequestHandler.hpp"
+#include "HttpResponse.hpp"
+#include "HttpServerMetrics.hpp"
+#include "HttpServerSettings.hpp"
+#include "HttpTimerWheel.hpp"
+#include "HttpUring.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/** Alias type definition, for compatibility to different Qt versions */
+#if QT_VERSION >= 0x050000
+    using tSocketDescriptor = qintptr;
+#else
+    using tSocketDescriptor = int;
+#endif
+
+/** Alias for QSslConfiguration if OpenSSL is not supported */
+#ifdef QT_NO_OPENSSL
+  #define QSslConfiguration QObject
+#endif
+
+/**
+  A single HTTP connection. It reads incoming requests from the socket, passes them to the
+  request handler and sends back the responses. Since HTTP clients can send multiple requests
+  before waiting for the response, the incoming requests are queued and processed one after
+  the other.
+  <p>
+  The connection does not own a thread. All signals are processed in the thread that the
+  object lives in, so one thread can serve any number of connections. The timeouts of all
+  connections of a thread are driven by one HttpTimerWheel.
+  <p>
+  Example for the required configuration settings:
+  <code><pre>
+  readTimeout=60000
+  writeTimeout=60000
+  writeHighWatermark=65536
+  writeLowWatermark=16384
+  maxBufferedBytes=268435456
+  maxRequestSize=16000
+  maxMultiPartSize=1000000
+  </pre></code>
+  <p>
+  The readTimeout value defines the maximum time to wait for a complete HTTP request,
+  and also for each part of a deferred response (see HttpResponse::defer()).
+  The writeTimeout value defines how long pending output may make no progress before the
+  connection is aborted, so a client that stops receiving cannot hold the connection forever.
+  The watermarks control when response producers have to wait, see HttpResponse.
+  <p>
+  maxBufferedBytes is a memory budget that all connections of a listener share. Each connection
+  reserves the bytes in its socket buffers and the bytes of its current request, including a body
+  that has been announced by Content-Length but not received yet. While the budget is exhausted,
+  new requests are rejected with "503 Service Unavailable" and connections stop reading partly
+  received request headers, so the kernel holds the data back. A request whose body does not fit
+  into the budget is rejected before the body is read. The usage is reported by HttpServerMetrics.
+  <p>
+  If the request handler streams the body of a request (see HttpRequestHandler::streamBody()),
+  the handler is called when the head has been received and the body is read while the response
+  is deferred. Reading stops while the request handler has paused the body. A streamed body is not
+  buffered, only the data that waits in the socket counts against maxBufferedBytes.
+  @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize.
+*/
+class DECLSPEC HttpConnection : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpConnection)
+
+public:
+
+    /**
+      Constructor.
+      @param settings Configuration settings of the HTTP webserver
+      @param requestHandler Handler that will process each incoming HTTP request
+      @param timerWheel Drives the timeouts, must live in the same thread as the connection
+      @param limiter Is told when a connection of a client has been closed, may be `nullptr`
+      @param metrics Counts the buffered bytes for maxBufferedBytes, may be `nullptr`
+      @param sslConfiguration SSL (HTTPS) will be used if not `nullptr`
+      @param uring The socket does its I/O through this ring if not `nullptr` and SSL is not used
+      @param parent Parent object.
+    */
+    HttpConnection(HttpServerSettings *settings, HttpRequestHandler *requestHandler, HttpTimerWheel *timerWheel, HttpClientLimiter *limiter,
+                   HttpServerMetrics *metrics, QSslConfiguration *sslConfiguration = nullptr, HttpUring *uring = nullptr, QObject *parent = nullptr);
+
+    /** Destructor */
+    virtual ~HttpConnection();
+
+    /**
+      Start processing an accepted connection. The connection object can be reused
+      for another socket after closed() has been emitted.
+      @param socketDescriptor references the accepted connection.
+      @return false if the socket could not be initialized.
+    */
+    bool open(tSocketDescriptor socketDescriptor);
+
+    /** Returns true, if a client is connected. */
+    bool isOpen() const;
+
+    /**
+      Close the connection as soon as it is idle. An idle keep-alive connection is closed
+      at once, otherwise the current or next response is sent with "Connection: close".
+      The setting stays when the connection object is reused.
+    */
+    void drain();
+
+    /**
+      Detach an idle keep-alive connection from this object, so that it can wait for its next
+      request somewhere else. The connection object can be reused afterwards, closed() is not emitted.
+      @return a duplicate of the socket descriptor, or -1 if the connection is not idle, uses SSL,
+              has buffered data or parking is not supported.
+    */
+    tSocketDescriptor park();
+
+    /**
+      Load the SSL configuration (certificate and key) from the files named in the settings.
+      @return `nullptr` if SSL is not configured or not supported. The caller takes ownership.
+    */
+    static QSslConfiguration *createSslConfiguration(const HttpServerSettings *settings);
+
+private:
+
+    /** Configuration settings */
+    HttpServerSettings *settings = nullptr;
+
+    /** TCP socket of the current connection  */
+    QTcpSocket *socket = nullptr;
+
+    /** Time for read timeout detection */
+    HttpTimerWheel::Timer readTimer;
+
+    /** Time for write timeout detection, runs while output is pending */
+    HttpTimerWheel::Timer writeTimer;
+
+    /** Checks the memory budget while reading is paused */
+    HttpTimerWheel::Timer resumeTimer;
+
+    /** Storage for the current incoming HTTP request */
+    HttpRequest *currentRequest = nullptr;
+
+    /** Received data that has not been consumed by a request yet, e.g. the start of a pipelined request */
+    QByteArray receiveBuffer;
+
+    /** Response to the current request, kept while it is deferred */
+    HttpResponse *currentResponse = nullptr;
+
+    /** Whether the connection will be closed after the current response */
+    bool closeConnection = false;
+
+    /** Set while the request handler or a deferred response is running, the request must not be deleted then */
+    bool servingRequest = false;
+
+    /** Set while a keep-alive connection waits for its next request */
+    bool idle = false;
+
+    /** Set by drain() */
+    bool draining = false;
+
+    /** Set while reading is paused because the memory budget is exhausted */
+    bool paused = false;
+
+    /** Counters of the listener, also the shared memory budget */
+    HttpServerMetrics *metrics = nullptr;
+
+    /** Bytes that this connection has reserved from the memory budget */
+    qint64 bufferedBytes = 0;
+
+    /** Limits of the client addresses */
+    HttpClientLimiter *limiter = nullptr;
+
+    /** Address of the client, passed to the requests */
+    QHostAddress peerAddress;
+
+    /** Address under which the limiter counts this connection, null if it is not counted */
+    QHostAddress limitedAddress;
+
+    /** Dispatches received requests to services */
+    HttpRequestHandler *requestHandler = nullptr;
+
+    /** Configuration for SSL */
+    QSslConfiguration *sslConfiguration = nullptr;
+
+    /** Ring for the I/O of the socket */
+    HttpUring *uring = nullptr;
+
+    /**  Create SSL, io_uring or TCP socket */
+    void createSocket();
+
+    /** Complete the current response and decide whether the connection stays open */
+    void finishRequest();
+
+    /** Delete the current request and response */
+    void discardRequest();
+
+    /** Update the reservation of this connection in the memory budget */
+    void updateBufferedBytes();
+
+    /** Returns true if maxBufferedBytes has been reached */
+    bool isOverBudget() const;
+
+    /** Reply "503 Service Unavailable" and close the connection */
+    void shedRequest();
+
+    /** Reply "429 Too Many Requests" and close the connection */
+    void throttleRequest();
+
+    /** Pass received data to the callback of a streamed body until it is complete, paused or more data is needed */
+    void readStreamedBody();
+
+signals:
+
+    /** Emitted when the client has disconnected and the socket is closed. */
+    void closed();
+
+    /** Emitted when a response has been sent and the connection waits for the next request. */
+    void waiting();
+
+private slots:
+
+    /** Received from the socket when a read-timeout occured */
+    void readTimeout();
+
+    /** Received from the write timer when pending output has made no progress */
+    void writeTimeout();
+
+    /** Start the write timer if output is pending, also called by HttpResponse */
+    void watchWrites();
+
+    /** Received from the socket when data has been sent */
+    void bytesWritten();
+
+    /** Received from the socket when incoming data can be read */
+    void read();
+
+    /** Received from the resume timer, continues reading when the memory budget allows it */
+    void resumeReading();
+
+    /** Received from the socket when a connection has been closed */
+    void disconnected();
+
+    /** Queued by a HttpDeferredResponse when data has been written to it */
+    void deferredUpdate();
+
+    /** Queued by HttpRequest::resumeBody() when a streamed body continues */
+    void resumeStreamedBody();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPCONNECTION_HPP
@@ -0,0 +1,228 @@
+#include "HttpConnectionDispatcher.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpConnectionDispatcher::HttpConnectionDispatcher(HttpServerSettings *settings, HttpRequestHandler *requestHandler, HttpServerMetrics *metrics,
+                                                   HttpClientLimiter *limiter, QObject *parent)
+    : QObject(parent)
+{
+    this->settings = settings;
+    this->metrics = metrics;
+    this->limiter = limiter && limiter->isEnabled() ? limiter : nullptr;
+    this->pendingQueue = new HttpPendingQueue(settings, metrics);
+
+    if (settings->connectionEngine == HttpServerSettings::EventLoop)
+    {
+        this->workerPool = new HttpWorkerPool(settings, requestHandler, this->pendingQueue, metrics, this->limiter);
+    }
+
+    else
+    {
+        if (settings->parkIdleConnections)
+        {
+            this->parker = new HttpConnectionParker(settings, this->limiter);
+            QObject::connect(this->parker, &HttpConnectionParker::resumed, this, &HttpConnectionDispatcher::resume, Qt::QueuedConnection);
+        }
+
+        this->pool = new HttpConnectionHandlerPool(settings, requestHandler, this->pendingQueue, metrics, this->parker, this->limiter);
+    }
+
+    // Check the waiting connections a few times within maxPendingTime
+    this->pendingTimer.setInterval(static_cast<int>(qBound(1U, this->settings->maxPendingTime / 4, 100U)));
+    QObject::connect(&this->pendingTimer, &QTimer::timeout, this, &HttpConnectionDispatcher::expirePending);
+}
+
+HttpConnectionDispatcher::~HttpConnectionDispatcher()
+{
+    this->pendingTimer.stop();
+
+    // Nobody will serve the waiting connections anymore
+    for (tSocketDescriptor socketDescriptor : this->pendingQueue->takeAll())
+    {
+        if (this->limiter)
+        {
+            this->limiter->release(socketDescriptor);
+        }
+
+        QTcpSocket socket;
+        socket.setSocketDescriptor(socketDescriptor);
+        socket.write("HTTP/1.1 503 Service Unavailable\nConnection: close\n\nService Unavailable\n");
+        socket.flush();
+        socket.close();
+        this->metrics->addRejectedConnection();
+    }
+
+    delete this->pool;
+    this->pool = nullptr;
+
+    // After the pool, because the handlers park their connections until they are deleted
+    delete this->parker;
+    this->parker = nullptr;
+
+    delete this->workerPool;
+    this->workerPool = nullptr;
+
+    delete this->pendingQueue;
+    this->pendingQueue = nullptr;
+}
+
+void HttpConnectionDispatcher::dispatch(tSocketDescriptor socketDescriptor)
+{
+    this->metrics->addAcceptedConnection();
+
+    // A client above its limits does not get a handler or worker
+    if (this->limiter && !this->limiter->acquire(socketDescriptor))
+    {
+        this->reject(socketDescriptor, "429 Too Many Requests", false);
+        return;
+    }
+
+    this->assign(socketDescriptor);
+}
+
+void HttpConnectionDispatcher::resume(tSocketDescriptor socketDescriptor)
+{
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        qDebug("HttpConnectionDispatcher: parked connection has received a request");
+    #endif
+
+    this->assign(socketDescriptor);
+}
+
+void HttpConnectionDispatcher::assign(tSocketDescriptor socketDescriptor)
+{
+    bool dispatched = false;
+
+    if (this->workerPool)
+    {
+        // Let the least loaded worker process the new connection.
+        dispatched = this->workerPool->dispatch(socketDescriptor);
+    }
+
+    else if (this->pool)
+    {
+        HttpConnectionHandler *freeHandler = this->pool->getConnectionHandler();
+
+        // Let the handler process the new connection.
+        if (freeHandler)
+        {
+            freeHandler->assignConnection(socketDescriptor);
+            dispatched = true;
+        }
+    }
+
+    if (dispatched)
+    {
+        return;
+    }
+
+    // Let the connection wait until a handler or worker becomes free
+    if (this->pendingQueue->enqueue(socketDescriptor))
+    {
+        #ifdef QTWEBAPP_SUPERVERBOSE
+            qDebug("HttpConnectionDispatcher: connection is waiting for a free handler");
+        #endif
+
+        // A handler may have become free after it had been asked above
+        this->servePending();
+
+        if (!this->pendingTimer.isActive())
+        {
+            this->pendingTimer.start();
+        }
+
+        return;
+    }
+
+    this->reject(socketDescriptor);
+}
+
+void HttpConnectionDispatcher::drain()
+{
+    if (this->workerPool)
+    {
+        this->workerPool->drain();
+    }
+
+    else if (this->pool)
+    {
+        this->pool->drain();
+    }
+
+    if (this->parker)
+    {
+        this->parker->drain();
+    }
+}
+
+int HttpConnectionDispatcher::getConnectionCount() const
+{
+    int count = this->pendingQueue->getCount();
+
+    if (this->workerPool)
+    {
+        count += this->workerPool->getConnectionCount();
+    }
+
+    else if (this->pool)
+    {
+        count += this->pool->getConnectionCount();
+    }
+
+    if (this->parker)
+    {
+        count += this->parker->getCount();
+    }
+
+    return count;
+}
+
+void HttpConnectionDispatcher::servePending()
+{
+    if (this->workerPool)
+    {
+        this->workerPool->servePending();
+    }
+
+    else if (this->pool)
+    {
+        this->pool->servePending();
+    }
+}
+
+void HttpConnectionDispatcher::expirePending()
+{
+    // Also catches a handler that has become free while a connection was just being queued
+    this->servePending();
+
+    for (tSocketDescriptor socketDescriptor : this->pendingQueue->takeExpired())
+    {
+        this->reject(socketDescriptor);
+    }
+
+    if (this->pendingQueue->isEmpty())
+    {
+        this->pendingTimer.stop();
+    }
+}
+
+void HttpConnectionDispatcher::reject(tSocketDescriptor socketDescriptor, const char *status, bool counted)
+{
+    qDebug("HttpConnectionDispatcher: Rejected connection: %s", status);
+    this->metrics->addRejectedConnection();
+
+    if (this->limiter && counted)
+    {
+        this->limiter->release(socketDescriptor);
+    }
+
+    // The text of the response is the status without the code
+    const QByteArray statusLine(status);
+    QTcpSocket *socket = new QTcpSocket(this);
+    socket->setSocketDescriptor(socketDescriptor);
+    QObject::connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+    socket->write("HTTP/1.1 " + statusLine + "\nConnection: close\n\n" + statusLine.mid(4) + "\n");
+    socket->disconnectFromHost();
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
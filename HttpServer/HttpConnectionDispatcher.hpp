@@ -0,0 +1,118 @@
+#ifndef HTTPCONNECTIONDISPATCHER_HPP
+#define HTTPCONNECTIONDISPATCHER_HPP
+
+#include <QObject>
+#include <QTimer>
+
+#include "HttpGlobal.hpp"
+#include "HttpClientLimiter.hpp"
+#include "HttpConnection.hpp"
+#include "HttpConnectionHandlerPool.hpp"
+#include "HttpConnectionParker.hpp"
+#include "HttpPendingQueue.hpp"
+#include "HttpServerMetrics.hpp"
+#include "HttpWorkerPool.hpp"
+#include "HttpRequestHandler.hpp"
+#include "HttpServerSettings.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Passes accepted connections to the configured connection engine. Every acceptor
+  (the HttpListener itself and each HttpAcceptor) owns one dispatcher, so each
+  acceptor feeds its own shard of handlers or workers.
+  <p>
+  Before a connection is passed on, the HttpClientLimiter checks the limits of its client address.
+  Connections that cannot be served at once wait in a HttpPendingQueue. Connections that
+  do not fit into that queue or wait too long are rejected with "503 Too Many Connections".
+  The dispatcher must live in the thread that accepts the connections.
+  @see HttpServerSettings::connectionEngine
+  @see HttpPendingQueue for the description of the settings maxPendingConnections and maxPendingTime
+*/
+
+class DECLSPEC HttpConnectionDispatcher : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpConnectionDispatcher)
+
+public:
+
+    /**
+      Constructor. Creates the handler pool or the worker pool, depending on the settings.
+      @param settings Configuration settings for the HTTP server. Must not be 0.
+      @param requestHandler The handler that will process each received HTTP request.
+      @param metrics Counters of the listener. Must not be 0.
+      @param limiter Limits of the client addresses, shared by all acceptors, may be `nullptr`.
+      @param parent Parent object.
+    */
+    HttpConnectionDispatcher(HttpServerSettings *settings, HttpRequestHandler *requestHandler, HttpServerMetrics *metrics,
+                             HttpClientLimiter *limiter = nullptr, QObject *parent = nullptr);
+
+    /** Destructor, rejects the waiting connections and closes the pool */
+    virtual ~HttpConnectionDispatcher();
+
+    /**
+      Pass an accepted connection to a free handler or worker, or let it wait for one.
+      @param socketDescriptor references the accepted connection.
+    */
+    void dispatch(tSocketDescriptor socketDescriptor);
+
+    /** Close all connections as soon as they are idle. This method is thread safe. */
+    void drain();
+
+    /** Number of open and waiting connections. This method is thread safe. */
+    int getConnectionCount() const;
+
+private:
+
+    /** Configuration settings */
+    HttpServerSettings *settings = nullptr;
+
+    /** Counters of the listener */
+    HttpServerMetrics *metrics = nullptr;
+
+    /** Limits of the client addresses */
+    HttpClientLimiter *limiter = nullptr;
+
+    /** Connections that wait for a free handler or worker */
+    HttpPendingQueue *pendingQueue = nullptr;
+
+    /** Rejects connections that have waited too long, runs while connections are waiting */
+    QTimer pendingTimer;
+
+    /** Pool of connection handlers, used by the ThreadPerConnection engine */
+    HttpConnectionHandlerPool *pool = nullptr;
+
+    /** Pool of workers, used by the EventLoop engine */
+    HttpWorkerPool *workerPool = nullptr;
+
+    /** Idle keep-alive connections of the ThreadPerConnection engine, `nullptr` if parking is disabled */
+    HttpConnectionParker *parker = nullptr;
+
+    /** Pass a connection to a free handler or worker, or let it wait for one */
+    void assign(tSocketDescriptor socketDescriptor);
+
+    /** Pass waiting connections to free handlers or workers */
+    void servePending();
+
+    /**
+      Reply with an error and close the connection.
+      @param socketDescriptor references the connection.
+      @param status Status line and text of the response
+      @param counted Whether the limiter has counted the connection
+    */
+    void reject(tSocketDescriptor socketDescriptor, const char *status = "503 Too Many Connections", bool counted = true);
+
+private slots:
+
+    /** Received from the pending timer */
+    void expirePending();
+
+    /** Received from the parker when a parked connection has sent its next request */
+    void resume(tSocketDescriptor socketDescriptor);
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPCONNECTIONDISPATCHER_HPP
@@ -1,37 +1,23 @@
 #ifndef HTTPCONNECTIONHANDLER_HPP
 #define HTTPCONNECTIONHANDLER_HPP
 
-#ifndef QT_NO_OPENSSL
-   #include <QSslConfiguration>
-#endif
-
-#include <QTcpSocket>
-#include <QTimer>
+#include <QAtomicInt>
 #include <QThread>
 
 #include "HttpGlobal.hpp"
-#include "HttpRequest.hpp"
+#include "HttpConnection.hpp"
+#include "HttpConnectionParker.hpp"
+#include "HttpHandoffChannel.hpp"
+#include "HttpTimerWheel.hpp"
 #include "HttpRequestHandler.hpp"
+#include "HttpServerMetrics.hpp"
 #include "HttpServerSettings.hpp"
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
 
-/** Alias type definition, for compatibility to different Qt versions */
-#if QT_VERSION >= 0x050000
-    using tSocketDescriptor = qintptr;
-#else
-    using tSocketDescriptor = int;
-#endif
-
-/** Alias for QSslConfiguration if OpenSSL is not supported */
-#ifdef QT_NO_OPENSSL
-  #define QSslConfiguration QObject
-#endif
-
 /**
   The connection handler accepts incoming connections and dispatches incoming requests to to a
-  request mapper. Since HTTP clients can send multiple requests before waiting for the response,
-  the incoming requests are queued and processed one after the other.
+  request mapper. Each handler owns a thread and serves exactly one HttpConnection at a time.
   <p>
   Example for the required configuration settings:
   <code><pre>
@@ -41,6 +27,11 @@ QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
   </pre></code>
   <p>
   The readTimeout value defines the maximum time to wait for a complete HTTP request.
+  <p>
+  If a HttpConnectionParker is given, an idle keep-alive connection is passed to it after each
+  response and the handler becomes free for the next connection.
+  @see HttpConnection for the processing of the requests.
+  @see HttpWorker for an engine that serves many connections per thread.
   @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize.
 */
 class DECLSPEC HttpConnectionHandler : public QThread
@@ -55,46 +46,65 @@ public:
       @param settings Configuration settings of the HTTP webserver
       @param requestHandler Handler that will process each incoming HTTP request
       @param sslConfiguration SSL (HTTPS) will be used if not `nullptr`
+      @param metrics Counters of the listener, may be `nullptr`
+      @param parker Takes idle keep-alive connections, may be `nullptr`
+      @param limiter Limits of the client addresses, may be `nullptr`
     */
-    HttpConnectionHandler(HttpServerSettings *settings, HttpRequestHandler *requestHandler, QSslConfiguration *sslConfiguration = nullptr);
+    HttpConnectionHandler(HttpServerSettings *settings, HttpRequestHandler *requestHandler, QSslConfiguration *sslConfiguration = nullptr,
+                          HttpServerMetrics *metrics = nullptr, HttpConnectionParker *parker = nullptr, HttpClientLimiter *limiter = nullptr);
 
     /** Destructor */
     virtual ~HttpConnectionHandler();
 
-    /** Returns true, if this handler is in use. */
-    bool isBusy();
+    /** Returns true, if this handler is in use. This method is thread safe. */
+    bool isBusy() const;
 
-    /** Mark this handler as busy */
+    /** Mark this handler as busy. This method is thread safe. */
     void setBusy();
 
+    /**
+      Pass a new connection to this handler. This method is thread safe,
+      the connection is opened in the thread of the handler.
+      @param socketDescriptor references the accepted connection.
+    */
+    void assignConnection(tSocketDescriptor socketDescriptor);
+
+    /** Close the connection as soon as it is idle, see HttpConnection::drain(). This method is thread safe. */
+    void drain();
+
 private:
 
-    /** Configuration settings */
-    HttpServerSettings *settings = nullptr;
+    /** The connection that is served by this handler, reused for every accepted socket */
+    HttpConnection *connection = nullptr;
 
-    /** TCP socket of the current connection  */
-    QTcpSocket *socket = nullptr;
+    /** This shows the busy-state from a very early time, written and read by different threads */
+    QAtomicInt busy;
 
-    /** Time for read timeout detection */
-    QTimer readTimer;
+    /** Timeouts of the connection */
+    HttpTimerWheel *timerWheel = nullptr;
 
-    /** Storage for the current incoming HTTP request */
-    HttpRequest *currentRequest = nullptr;
+    /** Passes new connections into the thread of this handler */
+    HttpHandoffChannel *handoff = nullptr;
 
-    /** Dispatches received requests to services */
-    HttpRequestHandler *requestHandler = nullptr;
+    /** CPUs that the thread is pinned to, empty if not pinned */
+    QList<int> cpus;
 
-    /** This shows the busy-state from a very early time */
-    bool busy = false;
+    /** Counters of the listener */
+    HttpServerMetrics *metrics = nullptr;
 
-    /** Configuration for SSL */
-    QSslConfiguration *sslConfiguration = nullptr;
+    /** Takes idle keep-alive connections */
+    HttpConnectionParker *parker = nullptr;
 
     /** Executes the threads own event loop */
     void run();
 
-    /**  Create SSL or TCP socket */
-    void createSocket();
+signals:
+
+    /**
+      Emitted in the thread of this handler when it has become idle and can take the next connection.
+      @param handler This handler
+    */
+    void released(HttpConnectionHandler *handler);
 
 public slots:
 
@@ -106,14 +116,14 @@ public slots:
 
 private slots:
 
-    /** Received from the socket when a read-timeout occured */
-    void readTimeout();
+    /** Received from the connection when the client has disconnected, releases this handler */
+    void connectionClosed();
 
-    /** Received from the socket when incoming data can be read */
-    void read();
+    /** Drain the connection in the thread of this handler */
+    void drainConnection();
 
-    /** Received from the socket when a connection has been closed */
-    void disconnected();
+    /** Received from the connection when it waits for the next request, parks it and releases this handler */
+    void parkConnection();
 
 };
 
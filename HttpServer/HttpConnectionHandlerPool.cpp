@@ -1,26 +1,36 @@
-#ifndef QT_NO_OPENSSL
-    #include <QSslSocket>
-    #include <QSslKey>
-    #include <QSslCertificate>
-    #include <QSslConfiguration>
-#endif
-
 #include "HttpConnectionHandlerPool.hpp"
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
 
-HttpConnectionHandlerPool::HttpConnectionHandlerPool(HttpServerSettings *settings, HttpRequestHandler *requestHandler)
-    : QObject()
+HttpConnectionHandlerPool::HttpConnectionHandlerPool(HttpServerSettings *settings, HttpRequestHandler *requestHandler, HttpPendingQueue *pendingQueue,
+                                                     HttpServerMetrics *metrics, HttpConnectionParker *parker, HttpClientLimiter *limiter)
+    : QObject(),
+      idleHandlers(settings->maxThreads)
 {
     this->settings = settings;
     this->requestHandler = requestHandler;
-    this->loadSslConfig();
-    this->cleanupTimer.start(this->settings->cleanupInterval);
-    QObject::connect(&this->cleanupTimer, &QTimer::timeout, this, &HttpConnectionHandlerPool::cleanup);
+    this->pendingQueue = pendingQueue;
+    this->metrics = metrics;
+    this->parker = parker;
+    this->limiter = limiter;
+    this->sslConfiguration = HttpConnection::createSslConfiguration(this->settings);
+
+    // The timer runs in the sizing thread and calls cleanup() there
+    this->cleanupTimer.setInterval(static_cast<int>(this->settings->cleanupInterval));
+    this->cleanupTimer.moveToThread(&this->sizingThread);
+    QObject::connect(&this->cleanupTimer, &QTimer::timeout, this, &HttpConnectionHandlerPool::cleanup, Qt::DirectConnection);
+    QObject::connect(&this->sizingThread, &QThread::started, &this->cleanupTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    QObject::connect(&this->sizingThread, &QThread::started, this, &HttpConnectionHandlerPool::cleanup, Qt::DirectConnection);
+    QObject::connect(&this->sizingThread, &QThread::finished, &this->cleanupTimer, &QTimer::stop, Qt::DirectConnection);
+    this->sizingThread.start();
 }
 
 HttpConnectionHandlerPool::~HttpConnectionHandlerPool()
 {
+    // stop resizing before the handlers are deleted
+    this->sizingThread.quit();
+    this->sizingThread.wait();
+
     // delete all connection handlers and wait until their threads are closed
 
     for (HttpConnectionHandler *handler : this->pool)
@@ -36,105 +46,200 @@ HttpConnectionHandlerPool::~HttpConnectionHandlerPool()
 HttpConnectionHandler *HttpConnectionHandlerPool::getConnectionHandler()
 {
     HttpConnectionHandler *freeHandler = nullptr;
-    this->mutex.lock();
 
-    // find a free handler in pool
-    for (HttpConnectionHandler *handler : this->pool)
+    // take an idle handler, new handlers are only started by the sizing thread
+    if (this->idleHandlers.dequeue(freeHandler))
     {
-        if (!handler->isBusy())
+        freeHandler->setBusy();
+
+        // start more handlers before the last spare one is taken
+        if (this->idleCount.fetchAndAddOrdered(-1) <= 1)
         {
-            freeHandler = handler;
-            freeHandler->setBusy();
-            break;
+            this->requestResize();
         }
+
+        return freeHandler;
     }
 
-    // create a new handler, if necessary
-    if (!freeHandler)
+    // Without a pending queue the connection would be rejected at once, so a handler is started
+    // here while the pool is below maxThreads, like the pool did before it had a sizing thread.
+    if (this->settings->maxPendingConnections == 0)
     {
-        if (static_cast<quint32>(this->pool.count()) < this->settings->maxThreads)
+        freeHandler = this->createHandler();
+        if (freeHandler)
         {
-            freeHandler = new HttpConnectionHandler(this->settings, this->requestHandler, this->sslConfiguration);
             freeHandler->setBusy();
-            this->pool.append(freeHandler);
+            this->requestResize();
+            return freeHandler;
         }
     }
 
-    this->mutex.unlock();
-    return freeHandler;
+    this->requestResize();
+    return nullptr;
 }
 
-void HttpConnectionHandlerPool::cleanup()
+void HttpConnectionHandlerPool::requestResize()
 {
-    quint32 idleCounter = 0;
+    if (static_cast<quint32>(this->poolSize.load()) >= this->settings->maxThreads)
+    {
+        return;
+    }
 
-    this->mutex.lock();
+    // Only one request at a time, the sizing thread resets the flag when it starts resizing
+    if (this->resizeRequested.testAndSetOrdered(0, 1))
+    {
+        // The timer lives in the sizing thread, so the call is queued into that thread
+        QTimer::singleShot(0, &this->cleanupTimer, [this]() { this->cleanup(); });
+    }
+}
 
-    for (HttpConnectionHandler *handler : pool)
+void HttpConnectionHandlerPool::spawnHandler()
+{
+    HttpConnectionHandler *handler = this->createHandler();
+    if (handler)
     {
-        if (!handler->isBusy())
+        this->release(handler);
+    }
+}
+
+HttpConnectionHandler *HttpConnectionHandlerPool::createHandler()
+{
+    // Reserve a place in the pool first, the sizing thread and the accepting thread may both create handlers
+    int size = this->poolSize.load();
+    do
+    {
+        if (static_cast<quint32>(size) >= this->settings->maxThreads)
         {
-            if (++idleCounter > this->settings->minThreads)
-            {
-                delete handler;
-                this->pool.removeOne(handler);
-                qDebug("HttpConnectionHandlerPool: Removed connection handler (%p), pool size is now %i",handler,pool.size());
-                break; // remove only one handler in each interval
-            }
+            return nullptr;
         }
     }
+    while (!this->poolSize.testAndSetOrdered(size, size + 1, size));
+
+    HttpConnectionHandler *handler = new HttpConnectionHandler(this->settings, this->requestHandler, this->sslConfiguration, this->metrics, this->parker, this->limiter);
+
+    // the handler emits this signal in its own thread, the queue is safe to use from there
+    QObject::connect(handler, &HttpConnectionHandler::released, this, &HttpConnectionHandlerPool::release, Qt::DirectConnection);
+
+    this->mutex.lock();
+    this->pool.append(handler);
+
+    // Checked under the lock, so that a concurrent drain() either sees this handler or sets the flag before
+    if (this->draining.loadAcquire())
+    {
+        handler->drain();
+    }
 
     this->mutex.unlock();
+
+    return handler;
+}
+
+int HttpConnectionHandlerPool::getPoolSize() const
+{
+    return this->poolSize.load();
+}
+
+void HttpConnectionHandlerPool::drain()
+{
+    QMutexLocker locker(&this->mutex);
+    this->draining.storeRelease(1);
+
+    for (HttpConnectionHandler *handler : this->pool)
+    {
+        handler->drain();
+    }
 }
 
-void HttpConnectionHandlerPool::loadSslConfig()
+int HttpConnectionHandlerPool::getConnectionCount() const
 {
-    // If certificate and key files are configured, then load them
-    QString sslKeyFileName = this->settings->sslKeyFile;
-    QString sslCertFileName = this->settings->sslCertFile;
+    return this->poolSize.load() - this->idleCount.load();
+}
+
+void HttpConnectionHandlerPool::servePending()
+{
+    if (!this->pendingQueue)
+    {
+        return;
+    }
+
+    HttpConnectionHandler *handler = nullptr;
+    tSocketDescriptor socketDescriptor;
 
-    if (!sslKeyFileName.isEmpty() && !sslCertFileName.isEmpty())
+    while (!this->pendingQueue->isEmpty() && this->idleHandlers.dequeue(handler))
     {
-        #ifdef QT_NO_OPENSSL
-            qWarning("HttpConnectionHandlerPool: SSL is not supported");
-        #else
-
-            /// TODO / IMPROVEMENT:
-            ///  all platforms: resolve environment variables in path
-            ///  unix: resolve home tilde to home path
-
-            // Load the SSL certificate
-            QFile certFile(sslCertFileName);
-            if (!certFile.open(QIODevice::ReadOnly))
-            {
-                qCritical("HttpConnectionHandlerPool: cannot open sslCertFile %s", qUtf8Printable(sslCertFileName));
-                return;
-            }
-
-            QSslCertificate certificate(&certFile, QSsl::Pem);
-            certFile.close();
-
-            // Load the key file
-            QFile keyFile(sslKeyFileName);
-            if (!keyFile.open(QIODevice::ReadOnly))
-            {
-                qCritical("HttpConnectionHandlerPool: cannot open sslKeyFile %s", qUtf8Printable(sslKeyFileName));
-                return;
-            }
-
-            QSslKey sslKey(&keyFile, QSsl::Rsa, QSsl::Pem);
-            keyFile.close();
-
-            // Create the SSL configuration
-            this->sslConfiguration = new QSslConfiguration();
-            this->sslConfiguration->setLocalCertificate(certificate);
-            this->sslConfiguration->setPrivateKey(sslKey);
-            this->sslConfiguration->setPeerVerifyMode(QSslSocket::VerifyNone);
-            this->sslConfiguration->setProtocol(QSsl::TlsV1SslV3);
-
-            qDebug("HttpConnectionHandlerPool: SSL settings loaded");
-         #endif
+        this->idleCount.deref();
+
+        // Another thread may have taken the last waiting connection in the meantime
+        if (!this->pendingQueue->take(socketDescriptor))
+        {
+            this->idleHandlers.enqueue(handler);
+            this->idleCount.ref();
+            break;
+        }
+
+        handler->setBusy();
+        handler->assignConnection(socketDescriptor);
     }
 }
 
+void HttpConnectionHandlerPool::release(HttpConnectionHandler *handler)
+{
+    // The queue has room for maxThreads handlers, so this cannot fail
+    this->idleHandlers.enqueue(handler);
+    this->idleCount.ref();
+
+    // Give the handler to the oldest waiting connection, if any
+    this->servePending();
+}
+
+void HttpConnectionHandlerPool::cleanup()
+{
+    this->resizeRequested.storeRelease(0);
+
+    const int poolSize = this->poolSize.load();
+    const int busy = qMax(poolSize - this->idleCount.load(), 0);
+
+    // Follow a rising load quickly and a falling load slowly
+    const double weight = busy > this->averageBusy ? 0.5 : 0.1;
+    this->averageBusy += weight * (busy - this->averageBusy);
+
+    const int spare = static_cast<int>(this->settings->spareThreads);
+    const int demand = qMax(static_cast<int>(this->averageBusy + 0.999), busy);
+    const int target = qBound(static_cast<int>(this->settings->minThreads), demand + spare, static_cast<int>(this->settings->maxThreads));
+
+    // Grow up to the target size at once, this is what keeps thread creation away from the accept path
+    if (poolSize < target)
+    {
+        for (int i = poolSize; i < target; ++i)
+        {
+            this->spawnHandler();
+        }
+
+        qDebug("HttpConnectionHandlerPool: grown to %i connection handlers (%i busy)", target, busy);
+        return;
+    }
+
+    // Shrink only above the target plus a band of spare handlers, by one handler in each interval
+    if (poolSize <= qMax(target + spare, static_cast<int>(this->settings->minThreads)))
+    {
+        return;
+    }
+
+    // A handler taken from the idle queue cannot be given to a connection anymore, so it is safe to delete.
+    HttpConnectionHandler *handler = nullptr;
+    if (!this->idleHandlers.dequeue(handler))
+    {
+        return;
+    }
+
+    this->idleCount.deref();
+
+    this->mutex.lock();
+    this->pool.removeOne(handler);
+    this->poolSize.deref();
+    delete handler;
+    qDebug("HttpConnectionHandlerPool: Removed connection handler (%p), pool size is now %i", handler, this->pool.size());
+    this->mutex.unlock();
+}
+
 QTWEBAPP_HTTPSERVER_NAMESPACE_END
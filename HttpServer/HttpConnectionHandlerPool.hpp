@@ -1,13 +1,18 @@
 #ifndef HTTPCONNECTIONHANDLERPOOL_HPP
 #define HTTPCONNECTIONHANDLERPOOL_HPP
 
+#include <QAtomicInt>
 #include <QList>
 #include <QTimer>
 #include <QObject>
 #include <QMutex>
+#include <QThread>
 
 #include "HttpGlobal.hpp"
 #include "HttpConnectionHandler.hpp"
+#include "HttpLockFreeQueue.hpp"
+#include "HttpPendingQueue.hpp"
+#include "HttpServerMetrics.hpp"
 #include "HttpServerSettings.hpp"
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
@@ -20,6 +25,7 @@ QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
   <code><pre>
   minThreads=4
   maxThreads=100
+  spareThreads=4
   cleanupInterval=60000
   readTimeout=60000
   ;sslKeyFile=ssl/my.key
@@ -27,10 +33,35 @@ QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
   maxRequestSize=16000
   maxMultiPartSize=1000000
   </pre></code>
-  After server start, the size of the thread pool is always 0. Threads
-  are started on demand when requests come in. The cleanup timer reduces
-  the number of idle threads slowly by closing one thread in each interval.
-  But the configured minimum number of threads are kept running.
+  The size of the pool is managed by a sizing thread of its own, so new threads are
+  never started in the thread that accepts the connections. Every cleanupInterval,
+  the sizing thread updates a moving average of the number of busy handlers and keeps
+  that many handlers plus spareThreads idle handlers running, but at least minThreads
+  and at most maxThreads. The average follows rising load quickly and falling load slowly.
+  When the pool runs out of idle handlers, the sizing thread is woken up at once and
+  the waiting connections are served from the pending queue as soon as the new handlers
+  are running. If the pending queue is disabled (maxPendingConnections=0), a handler is
+  started for the new connection at once instead, as long as the pool has less than
+  maxThreads handlers.
+  <p>
+  The pool only shrinks when it is larger than the target size plus another spareThreads
+  handlers, and then by one idle handler in each interval. This hysteresis prevents that
+  handlers are closed and started again when the load oscillates around the target.
+  <p>
+  Idle handlers are kept in a lock-free queue. Handlers put themselves back into
+  that queue when their connection has been closed, so getting a free handler does
+  not depend on the size of the pool and does not block other threads. If connections
+  are waiting in the pending queue, a handler that has become free takes the oldest
+  of them instead.
+  <p>
+  With parkIdleConnections, a handler does not stay busy while its keep-alive connection waits
+  for the next request. The connection is parked in a HttpConnectionParker and comes back
+  through the dispatcher to any free handler, so idle clients do not exhaust maxThreads.
+  Parking is off by default, because a connection may then be served by a different handler
+  thread for each of its requests.
+  <p>
+  The optional workerCpus setting pins every handler thread to that set of CPUs.
+  Handlers come and go with the load, so they are not pinned to single CPUs.
   <p>
   For SSL support, you need an OpenSSL certificate file and a key file.
   Both can be created with the command
@@ -58,16 +89,33 @@ public:
       Constructor.
       @param settings Configuration settings for the HTTP server. Must not be 0.
       @param requestHandler The handler that will process each received HTTP request.
+      @param pendingQueue Connections that wait for a free handler, may be `nullptr`.
+      @param metrics Counters of the listener, may be `nullptr`.
+      @param parker Takes idle keep-alive connections from the handlers, may be `nullptr`.
+      @param limiter Limits of the client addresses, may be `nullptr`.
       @warning The requestMapper gets deleted by the destructor of this pool
     */
-    HttpConnectionHandlerPool(HttpServerSettings *settings, HttpRequestHandler* requestHandler);
+    HttpConnectionHandlerPool(HttpServerSettings *settings, HttpRequestHandler* requestHandler, HttpPendingQueue *pendingQueue = nullptr,
+                              HttpServerMetrics *metrics = nullptr, HttpConnectionParker *parker = nullptr, HttpClientLimiter *limiter = nullptr);
 
     /** Destructor */
     virtual ~HttpConnectionHandlerPool();
 
-    /** Get a free connection handler, or 0 if not available. */
+    /** Get a free connection handler, or 0 if not available. This method is thread safe. */
     HttpConnectionHandler *getConnectionHandler();
 
+    /** Pass waiting connections from the pending queue to idle handlers. This method is thread safe. */
+    void servePending();
+
+    /** Number of handlers in the pool. This method is thread safe. */
+    int getPoolSize() const;
+
+    /** Close all connections as soon as they are idle, also in handlers that are started later. This method is thread safe. */
+    void drain();
+
+    /** Number of handlers that serve a connection. This method is thread safe. */
+    int getConnectionCount() const;
+
 private:
 
     /** Settings for this pool */
@@ -76,26 +124,71 @@ private:
     /** Will be assigned to each Connectionhandler during their creation */
     HttpRequestHandler *requestHandler = nullptr;
 
-    /** Pool of connection handlers */
+    /** Pool of connection handlers, guarded by the mutex */
     QList<HttpConnectionHandler*> pool;
 
-    /** Timer to clean-up unused connection handler */
+    /** Number of handlers in the pool, readable without the lock */
+    QAtomicInt poolSize;
+
+    /** Handlers that are not busy, ready to be taken without locking */
+    HttpLockFreeQueue<HttpConnectionHandler*> idleHandlers;
+
+    /** Number of handlers in idleHandlers */
+    QAtomicInt idleCount;
+
+    /** Connections that wait for a free handler */
+    HttpPendingQueue *pendingQueue = nullptr;
+
+    /** Counters of the listener */
+    HttpServerMetrics *metrics = nullptr;
+
+    /** Takes idle keep-alive connections from the handlers */
+    HttpConnectionParker *parker = nullptr;
+
+    /** Limits of the client addresses */
+    HttpClientLimiter *limiter = nullptr;
+
+    /** Starts and stops the handlers, so that this never happens in the accepting thread */
+    QThread sizingThread;
+
+    /** Timer to resize the pool, lives in the sizing thread */
     QTimer cleanupTimer;
 
-    /** Used to synchronize threads */
-    QMutex mutex;
+    /** Moving average of the number of busy handlers, only used in the sizing thread */
+    double averageBusy = 0.0;
+
+    /** Set while a resize has been requested but not started yet */
+    QAtomicInt resizeRequested;
+
+    /** Set by drain() */
+    QAtomicInt draining;
+
+    /** Used to synchronize threads that add or remove handlers */
+    mutable QMutex mutex;
 
     /** The SSL configuration (certificate, key and other settings) */
     QSslConfiguration *sslConfiguration = nullptr;
 
-    /** Load SSL configuration */
-    void loadSslConfig();
+    /** Wake up the sizing thread because the pool has run out of idle handlers. This method is thread safe. */
+    void requestResize();
+
+    /** Start a new handler and put it into the idle queue. Called in the sizing thread. */
+    void spawnHandler();
+
+    /** Start a new handler and add it to the pool, or return `nullptr` if the pool has maxThreads handlers. This method is thread safe. */
+    HttpConnectionHandler *createHandler();
 
 private slots:
 
-    /** Received from the clean-up timer.  */
+    /** Received from the clean-up timer in the sizing thread, grows or shrinks the pool */
     void cleanup();
 
+    /**
+      Received from a handler in its own thread when it has become idle.
+      @param handler The idle handler
+    */
+    void release(HttpConnectionHandler *handler);
+
 };
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,180 @@
+#include "HttpConnectionParker.hpp"
+
+#include <QSocketNotifier>
+
+#ifdef Q_OS_UNIX
+    #include <errno.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+struct HttpConnectionParker::ParkedConnection
+{
+    ParkedConnection(tSocketDescriptor socketDescriptor, HttpTimerWheel *timerWheel, std::function<void()> timeout)
+        : timer(timerWheel, std::move(timeout))
+    {
+        this->notifier = new QSocketNotifier(socketDescriptor, QSocketNotifier::Read);
+    }
+
+    ~ParkedConnection()
+    {
+        // The connection may be unparked from a signal of the notifier, so it is deleted later
+        this->notifier->setEnabled(false);
+        this->notifier->deleteLater();
+    }
+
+    QSocketNotifier *notifier = nullptr;
+    HttpTimerWheel::Timer timer;
+};
+
+HttpConnectionParker::HttpConnectionParker(HttpServerSettings *settings, HttpClientLimiter *limiter)
+    : QThread()
+{
+    this->settings = settings;
+    this->limiter = limiter;
+
+    // The channel and the wheel are children, so they move into the thread together with this parker
+    this->handoff = new HttpHandoffChannel(1024, this);
+    this->timerWheel = new HttpTimerWheel(100, 512, this);
+    QObject::connect(this->handoff, &HttpHandoffChannel::received, this, &HttpConnectionParker::handleConnection);
+
+    // execute signals in my own thread
+    this->moveToThread(this);
+
+    qDebug("HttpConnectionParker (%p): constructed", this);
+    this->start();
+}
+
+HttpConnectionParker::~HttpConnectionParker()
+{
+    this->quit();
+    this->wait();
+    qDebug("HttpConnectionParker (%p): destroyed", this);
+}
+
+void HttpConnectionParker::run()
+{
+    qDebug("HttpConnectionParker (%p): thread started", this);
+    this->handoff->attach();
+
+    try
+    {
+        this->exec();
+    }
+
+    catch (...)
+    {
+        qCritical("HttpConnectionParker (%p): an uncatched exception occured in the thread", this);
+    }
+
+    for (tSocketDescriptor socketDescriptor : this->connections.keys())
+    {
+        this->unpark(socketDescriptor, true);
+    }
+
+    this->handoff->detach();
+    qDebug("HttpConnectionParker (%p): thread stopped", this);
+}
+
+void HttpConnectionParker::park(tSocketDescriptor socketDescriptor)
+{
+    this->count.ref();
+
+    if (!this->handoff->push(socketDescriptor))
+    {
+        QMetaObject::invokeMethod(this, "handleConnection", Qt::QueuedConnection, Q_ARG(tSocketDescriptor, socketDescriptor));
+    }
+}
+
+void HttpConnectionParker::drain()
+{
+    QMetaObject::invokeMethod(this, "drainConnections", Qt::QueuedConnection);
+}
+
+int HttpConnectionParker::getCount() const
+{
+    return this->count.load();
+}
+
+void HttpConnectionParker::handleConnection(tSocketDescriptor socketDescriptor)
+{
+    ParkedConnection *connection = new ParkedConnection(socketDescriptor, this->timerWheel, [this, socketDescriptor]()
+    {
+        #ifdef QTWEBAPP_SUPERVERBOSE
+            qDebug("HttpConnectionParker (%p): idle timeout", this);
+        #endif
+
+        this->unpark(socketDescriptor, true);
+    });
+
+    QObject::connect(connection->notifier, &QSocketNotifier::activated, this, [this, socketDescriptor]() { this->readable(socketDescriptor); });
+    connection->timer.start(static_cast<int>(this->settings->readTimeout));
+    this->connections.insert(socketDescriptor, connection);
+
+    if (this->draining)
+    {
+        this->unpark(socketDescriptor, true);
+    }
+}
+
+void HttpConnectionParker::readable(tSocketDescriptor socketDescriptor)
+{
+#ifdef Q_OS_UNIX
+    // A connection that the client has closed is not worth a handler
+    char buffer;
+    const ssize_t received = ::recv(static_cast<int>(socketDescriptor), &buffer, 1, MSG_PEEK | MSG_DONTWAIT);
+
+    if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return;
+    }
+
+    if (received <= 0)
+    {
+        this->unpark(socketDescriptor, true);
+        return;
+    }
+#endif
+
+    this->unpark(socketDescriptor, false);
+    emit this->resumed(socketDescriptor);
+}
+
+void HttpConnectionParker::drainConnections()
+{
+    this->draining = true;
+
+    for (tSocketDescriptor socketDescriptor : this->connections.keys())
+    {
+        this->unpark(socketDescriptor, true);
+    }
+}
+
+void HttpConnectionParker::unpark(tSocketDescriptor socketDescriptor, bool close)
+{
+    ParkedConnection *connection = this->connections.take(socketDescriptor);
+    if (!connection)
+    {
+        return;
+    }
+
+    // The notifier must be disabled before the descriptor is closed
+    delete connection;
+    this->count.deref();
+
+    if (close)
+    {
+        if (this->limiter)
+        {
+            this->limiter->release(socketDescriptor);
+        }
+
+        #ifdef Q_OS_UNIX
+            ::close(static_cast<int>(socketDescriptor));
+        #endif
+    }
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
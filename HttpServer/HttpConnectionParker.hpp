@@ -0,0 +1,114 @@
+#ifndef HTTPCONNECTIONPARKER_HPP
+#define HTTPCONNECTIONPARKER_HPP
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QThread>
+
+#include "HttpGlobal.hpp"
+#include "HttpConnection.hpp"
+#include "HttpHandoffChannel.hpp"
+#include "HttpServerSettings.hpp"
+#include "HttpTimerWheel.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Watches idle keep-alive connections of the ThreadPerConnection engine, so that they do not
+  occupy a HttpConnectionHandler between two requests.
+  <p>
+  When a connection has sent its response and waits for the next request, the handler passes
+  the socket to the parker and becomes free for another connection. The parker watches all
+  parked sockets in a single thread. When the next request arrives, resumed() is emitted and
+  the dispatcher passes the socket to any free handler, like a new connection. Parked sockets
+  that stay idle for readTimeout milliseconds, or that are closed by the client, are closed here.
+  <p>
+  Only plain TCP connections are parked, because the state of an SSL session cannot be passed
+  to another socket object. Parking is supported on Unix only.
+  @see HttpServerSettings::parkIdleConnections
+*/
+
+class DECLSPEC HttpConnectionParker : public QThread
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpConnectionParker)
+
+public:
+
+    /**
+      Constructor, starts the thread.
+      @param settings Configuration settings of the HTTP webserver
+      @param limiter Is told when a parked connection is closed, may be `nullptr`
+    */
+    HttpConnectionParker(HttpServerSettings *settings, HttpClientLimiter *limiter = nullptr);
+
+    /** Destructor, closes all parked connections */
+    virtual ~HttpConnectionParker();
+
+    /**
+      Watch an idle connection. This method is thread safe.
+      @param socketDescriptor references the connection, the parker takes ownership.
+    */
+    void park(tSocketDescriptor socketDescriptor);
+
+    /** Close all parked connections and every connection that is parked later. This method is thread safe. */
+    void drain();
+
+    /** Number of parked connections. This method is thread safe. */
+    int getCount() const;
+
+signals:
+
+    /**
+      Emitted in the thread of the parker when a parked connection has received data.
+      @param socketDescriptor references the connection, the receiver takes ownership.
+    */
+    void resumed(tSocketDescriptor socketDescriptor);
+
+private:
+
+    struct ParkedConnection;
+
+    /** Configuration settings */
+    HttpServerSettings *settings = nullptr;
+
+    /** Limits of the client addresses */
+    HttpClientLimiter *limiter = nullptr;
+
+    /** Passes idle connections into the thread of this parker */
+    HttpHandoffChannel *handoff = nullptr;
+
+    /** Idle timeouts of the parked connections */
+    HttpTimerWheel *timerWheel = nullptr;
+
+    /** Parked connections, only accessed from the thread of this parker */
+    QHash<tSocketDescriptor, ParkedConnection*> connections;
+
+    /** Number of parked connections, including the ones that are not received yet */
+    QAtomicInt count;
+
+    /** Set by drain(), only used in the thread of this parker */
+    bool draining = false;
+
+    /** Executes the threads own event loop */
+    void run();
+
+    /** Stop watching a connection and optionally close it */
+    void unpark(tSocketDescriptor socketDescriptor, bool close);
+
+private slots:
+
+    /** Start watching a connection in the thread of this parker */
+    void handleConnection(tSocketDescriptor socketDescriptor);
+
+    /** Received from the notifier of a parked connection */
+    void readable(tSocketDescriptor socketDescriptor);
+
+    /** Close all parked connections in the thread of this parker */
+    void drainConnections();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPCONNECTIONPARKER_HPP
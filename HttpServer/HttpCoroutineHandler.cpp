@@ -0,0 +1,194 @@
+#include "HttpCoroutineHandler.hpp"
+
+#if defined(QTWEBAPP_COROUTINES) && defined(__cpp_impl_coroutine)
+
+#include <QTimer>
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+void HttpTask::promise_type::unhandled_exception() noexcept
+{
+    qCritical("HttpCoroutineHandler: An uncatched exception occured in the request handler");
+}
+
+HttpCoroutineContext::HttpCoroutineContext(const std::shared_ptr<State> &state)
+    : state(state)
+{
+}
+
+HttpCoroutineContext::HttpCoroutineContext(HttpCoroutineContext &&other) noexcept
+    : state(std::move(other.state))
+{
+}
+
+HttpCoroutineContext::~HttpCoroutineContext()
+{
+    // Only the context inside the coroutine frame has a state, it is destroyed when the coroutine returns
+    if (this->state)
+    {
+        this->state->finished = true;
+
+        // A deferred response is completed by the connection, otherwise service() is still running and does that
+        this->state->deferred.write(QByteArray(), true);
+    }
+}
+
+bool HttpCoroutineContext::isConnected() const
+{
+    return this->state->socket && this->state->socket->isOpen() &&
+           (this->state->deferred.isNull() || this->state->deferred.isConnected());
+}
+
+HttpResponse &HttpCoroutineContext::response()
+{
+    return *this->state->response;
+}
+
+bool HttpCoroutineContext::write(const QByteArray &data, bool lastPart)
+{
+    if (!this->isConnected())
+    {
+        return false;
+    }
+
+    this->state->response->write(data, lastPart);
+    return true;
+}
+
+HttpCoroutineContext::BodyAwaiter HttpCoroutineContext::readBody(int maxSize)
+{
+    return BodyAwaiter(this, maxSize);
+}
+
+HttpCoroutineContext::Awaiter HttpCoroutineContext::writable(qint64 watermark)
+{
+    State *state = this->state.get();
+    if (watermark < 0 && this->isConnected())
+    {
+        watermark = state->response->lowWatermark;
+    }
+
+    return Awaiter(this, -1, [state, watermark]() { return state->socket->bytesToWrite() <= watermark; });
+}
+
+HttpCoroutineContext::Awaiter HttpCoroutineContext::sleep(int msec)
+{
+    return Awaiter(this, msec, []() { return false; });
+}
+
+HttpCoroutineContext::Awaiter::Awaiter(HttpCoroutineContext *context, int timeout, std::function<bool()> condition)
+    : context(context),
+      timeout(timeout),
+      condition(std::move(condition))
+{
+}
+
+bool HttpCoroutineContext::Awaiter::await_ready() const
+{
+    return this->timeout < 0 && (!this->context->isConnected() || this->condition());
+}
+
+void HttpCoroutineContext::Awaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    // Send what has been written so far, the response may be corked
+    if (this->context->isConnected())
+    {
+        this->context->state->response->flush();
+    }
+
+    // The lambdas use raw pointers, the connections and the timer are removed together with the receiver
+    State *state = this->context->state.get();
+    HttpCoroutineContext *context = this->context;
+    std::function<bool()> condition = this->condition;
+    std::shared_ptr<QList<QMetaObject::Connection>> connections = std::make_shared<QList<QMetaObject::Connection>>();
+    std::shared_ptr<bool> resumed = std::make_shared<bool>(false);
+
+    auto wake = [context, condition, connections, resumed, handle](bool timeout)
+    {
+        if (*resumed || (!timeout && context->isConnected() && !condition()))
+        {
+            return;
+        }
+
+        *resumed = true;
+        for (const QMetaObject::Connection &connection : *connections)
+        {
+            QObject::disconnect(connection);
+        }
+
+        handle.resume();
+    };
+
+    if (state->socket)
+    {
+        connections->append(QObject::connect(state->socket, &QTcpSocket::bytesWritten, &state->receiver, [wake]() { wake(false); }));
+        connections->append(QObject::connect(state->socket, &QTcpSocket::disconnected, &state->receiver, [wake]() { wake(false); }));
+        connections->append(QObject::connect(state->socket, &QObject::destroyed, &state->receiver, [state, wake]()
+        {
+            state->socket = nullptr;
+            wake(false);
+        }));
+    }
+
+    if (this->timeout >= 0)
+    {
+        QTimer::singleShot(this->timeout, &state->receiver, [wake]() { wake(true); });
+    }
+
+    // The connection may have been closed before the signals were connected
+    if (!state->socket)
+    {
+        QTimer::singleShot(0, &state->receiver, [wake]() { wake(false); });
+    }
+}
+
+bool HttpCoroutineContext::Awaiter::await_resume() const
+{
+    return this->context->isConnected();
+}
+
+HttpCoroutineContext::BodyAwaiter::BodyAwaiter(HttpCoroutineContext *context, int maxSize)
+    : context(context),
+      maxSize(maxSize)
+{
+}
+
+QByteArray HttpCoroutineContext::BodyAwaiter::await_resume()
+{
+    State *state = this->context->state.get();
+    if (!this->context->isConnected())
+    {
+        return QByteArray();
+    }
+
+    const QByteArray body = state->request->getBody();
+    const QByteArray chunk = body.mid(state->bodyPosition, this->maxSize);
+    state->bodyPosition += chunk.size();
+    return chunk;
+}
+
+HttpCoroutineHandler::HttpCoroutineHandler(QObject *parent)
+    : HttpRequestHandler(parent)
+{
+}
+
+void HttpCoroutineHandler::service(HttpRequest &request, HttpResponse &response)
+{
+    std::shared_ptr<HttpCoroutineContext::State> state = std::make_shared<HttpCoroutineContext::State>();
+    state->request = &request;
+    state->response = &response;
+    state->socket = response.socket;
+
+    // The coroutine runs until it suspends for the first time or returns
+    this->serviceAsync(request, HttpCoroutineContext(state));
+
+    // If it has suspended, the connection waits for the deferred response
+    if (!state->finished)
+    {
+        state->deferred = response.defer();
+    }
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // QTWEBAPP_COROUTINES && __cpp_impl_coroutine
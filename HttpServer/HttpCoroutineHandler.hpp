@@ -0,0 +1,211 @@
+#ifndef HTTPCOROUTINEHANDLER_HPP
+#define HTTPCOROUTINEHANDLER_HPP
+
+#include "HttpGlobal.hpp"
+
+#if defined(QTWEBAPP_COROUTINES) && defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <functional>
+#include <memory>
+
+#include <QByteArray>
+#include <QObject>
+#include <QTcpSocket>
+
+#include "HttpDeferredResponse.hpp"
+#include "HttpRequest.hpp"
+#include "HttpRequestHandler.hpp"
+#include "HttpResponse.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Return type of HttpCoroutineHandler::serviceAsync(). The coroutine starts at once
+  and destroys itself when it returns, there is nothing to wait for.
+*/
+
+class DECLSPEC HttpTask
+{
+public:
+
+    struct promise_type
+    {
+        HttpTask get_return_object() noexcept { return HttpTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept;
+    };
+
+};
+
+/**
+  Access to the request and the response of a running HttpCoroutineHandler::serviceAsync().
+  <p>
+  All awaitables return false when the connection has been closed. The coroutine should
+  return then, because the request and the response have been deleted. The context is
+  move-only and belongs to the coroutine, the response is completed when the coroutine returns.
+*/
+
+class DECLSPEC HttpCoroutineContext
+{
+    Q_DISABLE_COPY(HttpCoroutineContext)
+
+public:
+
+    /** Move constructor, used to pass the context into the coroutine */
+    HttpCoroutineContext(HttpCoroutineContext &&other) noexcept;
+
+    /** Destructor, completes the response */
+    ~HttpCoroutineContext();
+
+    /** Returns true while the client is connected and the response can be written */
+    bool isConnected() const;
+
+    /** The response, only valid while isConnected() returns true */
+    HttpResponse &response();
+
+    /**
+      Write body data, like HttpResponse::write(). Use co_await writable() before,
+      so that the output buffer does not grow without limit.
+      @return false if the connection has been closed
+    */
+    bool write(const QByteArray &data, bool lastPart = false);
+
+    /** Awaitable that resumes the coroutine when the condition of its constructor becomes true */
+    class DECLSPEC Awaiter
+    {
+    public:
+        bool await_ready() const;
+        void await_suspend(std::coroutine_handle<> handle);
+        bool await_resume() const;
+
+    private:
+        friend class HttpCoroutineContext;
+        Awaiter(HttpCoroutineContext *context, int timeout, std::function<bool()> condition);
+        HttpCoroutineContext *context;
+        int timeout;
+        std::function<bool()> condition;
+    };
+
+    /** Awaitable that returns the next piece of the request body */
+    class DECLSPEC BodyAwaiter
+    {
+    public:
+        bool await_ready() const { return true; }
+        void await_suspend(std::coroutine_handle<>) {}
+        QByteArray await_resume();
+
+    private:
+        friend class HttpCoroutineContext;
+        explicit BodyAwaiter(HttpCoroutineContext *context, int maxSize);
+        HttpCoroutineContext *context;
+        int maxSize;
+    };
+
+    /**
+      co_await the next piece of the request body, at most maxSize bytes.
+      An empty array means that the body is complete.
+    */
+    BodyAwaiter readBody(int maxSize = 65536);
+
+    /**
+      co_await until the output buffer of the socket contains at most watermark bytes,
+      -1 waits for the writeLowWatermark of the settings.
+      @return false if the connection has been closed
+    */
+    Awaiter writable(qint64 watermark = -1);
+
+    /**
+      co_await a timer, the thread serves other connections meanwhile.
+      @return false if the connection has been closed
+    */
+    Awaiter sleep(int msec);
+
+private:
+
+    friend class HttpCoroutineHandler;
+
+    /** State that is shared with HttpCoroutineHandler::service() */
+    struct State
+    {
+        HttpRequest *request = nullptr;
+        HttpResponse *response = nullptr;
+        QTcpSocket *socket = nullptr; // nullptr when the socket has been deleted
+        HttpDeferredResponse deferred; // null as long as service() has not returned
+        QObject receiver; // context of the signal connections and timers, lives in the thread of the connection
+        int bodyPosition = 0;
+        bool finished = false; // set when the coroutine has returned
+    };
+
+    std::shared_ptr<State> state;
+
+    /** Constructor, used by HttpCoroutineHandler::service() */
+    explicit HttpCoroutineContext(const std::shared_ptr<State> &state);
+
+};
+
+/**
+  Request handler whose serviceAsync() is a C++20 coroutine. Instead of blocking the thread,
+  it can co_await the request body, the writability of the socket and timers:
+  <code><pre>
+    HttpTask MyHandler::serviceAsync(HttpRequest &request, HttpCoroutineContext context)
+    {
+        context.response().setHeader("Content-Type", "text/plain");
+
+        for (int i = 0; i < 100; ++i)
+        {
+            if (!co_await context.sleep(1000) || !co_await context.writable())
+            {
+                co_return;
+            }
+
+            context.write(QByteArray::number(i) + "\n");
+        }
+    }
+  </pre></code>
+  If the coroutine suspends, the response is deferred (see HttpResponse::defer()) and the
+  thread continues with other connections. With the EventLoop engine one HttpWorker thread
+  can therefore serve many slow clients or streaming responses. The coroutine is always
+  resumed in the thread of its connection, and the response is completed when it returns.
+  <p>
+  The request body is collected by HttpRequest before the handler is called, readBody()
+  returns it in pieces without suspending.
+  <p>
+  This class requires C++20 and is only available if QtWebApp is built with
+  <code>CONFIG += qtwebapp_coroutines</code>.
+*/
+
+class DECLSPEC HttpCoroutineHandler : public HttpRequestHandler
+{
+    Q_DISABLE_COPY(HttpCoroutineHandler)
+
+public:
+
+    /**
+     * Constructor.
+     * @param parent Parent object.
+     */
+    HttpCoroutineHandler(QObject *parent = nullptr);
+
+    /** Starts serviceAsync() */
+    void service(HttpRequest &request, HttpResponse &response) final;
+
+protected:
+
+    /**
+      Generate a response for an incoming HTTP request.
+      @param request The received HTTP request, only valid while context.isConnected() returns true
+      @param context Access to the response
+      @warning This method must be thread safe
+    */
+    virtual HttpTask serviceAsync(HttpRequest &request, HttpCoroutineContext context) = 0;
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // QTWEBAPP_COROUTINES && __cpp_impl_coroutine
+
+#endif // HTTPCOROUTINEHANDLER_HPP
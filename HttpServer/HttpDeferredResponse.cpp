@@ -0,0 +1,236 @@
+#include "HttpDeferredResponse.hpp"
+#include "HttpResponse.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpDeferredResponse::HttpDeferredResponse()
+{
+}
+
+HttpDeferredResponse::HttpDeferredResponse(QObject *connection, qint64 highWatermark, qint64 lowWatermark)
+    : dataPtr(new HttpDeferredResponseData())
+{
+    this->dataPtr->connection = connection;
+    this->dataPtr->highWatermark = highWatermark;
+    this->dataPtr->lowWatermark = lowWatermark;
+}
+
+bool HttpDeferredResponse::isNull() const
+{
+    return this->dataPtr.isNull();
+}
+
+void HttpDeferredResponse::setStatus(int statusCode, const QByteArray &description)
+{
+    if (this->dataPtr)
+    {
+        QMutexLocker locker(&this->dataPtr->mutex);
+        this->dataPtr->statusCode = statusCode;
+        this->dataPtr->statusText = description;
+    }
+}
+
+void HttpDeferredResponse::setHeader(const QByteArray &name, const QByteArray &value)
+{
+    if (this->dataPtr)
+    {
+        QMutexLocker locker(&this->dataPtr->mutex);
+        this->dataPtr->headers.append(qMakePair(name, value));
+    }
+}
+
+void HttpDeferredResponse::setHeader(const QByteArray &name, int value)
+{
+    this->setHeader(name, QByteArray::number(value));
+}
+
+void HttpDeferredResponse::setCookie(const HttpCookie &cookie)
+{
+    if (this->dataPtr)
+    {
+        QMutexLocker locker(&this->dataPtr->mutex);
+        this->dataPtr->cookies.append(cookie);
+    }
+}
+
+void HttpDeferredResponse::write(const QByteArray &data, bool lastPart)
+{
+    if (this->dataPtr)
+    {
+        QMutexLocker locker(&this->dataPtr->mutex);
+
+        if (this->dataPtr->lastPart)
+        {
+            qWarning("HttpDeferredResponse: write after the last part is ignored");
+            return;
+        }
+
+        this->dataPtr->chunks.append(data);
+        this->dataPtr->queuedBytes += data.size();
+        this->dataPtr->lastPart = lastPart;
+        this->wakeUp();
+    }
+}
+
+bool HttpDeferredResponse::isConnected() const
+{
+    if (this->dataPtr)
+    {
+        QMutexLocker locker(&this->dataPtr->mutex);
+        return this->dataPtr->connection != nullptr;
+    }
+
+    return false;
+}
+
+bool HttpDeferredResponse::isWritable() const
+{
+    if (!this->dataPtr)
+    {
+        return false;
+    }
+
+    QMutexLocker locker(&this->dataPtr->mutex);
+
+    if (this->dataPtr->queuedBytes + this->dataPtr->pendingBytes > this->dataPtr->highWatermark)
+    {
+        this->dataPtr->blocked = true;
+        return false;
+    }
+
+    return true;
+}
+
+void HttpDeferredResponse::setWritableCallback(const std::function<void()> &callback)
+{
+    if (this->dataPtr)
+    {
+        QMutexLocker locker(&this->dataPtr->mutex);
+        this->dataPtr->writableCallback = callback;
+    }
+}
+
+void HttpDeferredResponse::setPendingBytes(qint64 pendingBytes)
+{
+    if (!this->dataPtr)
+    {
+        return;
+    }
+
+    std::function<void()> callback;
+
+    this->dataPtr->mutex.lock();
+    this->dataPtr->pendingBytes = pendingBytes;
+
+    if (this->dataPtr->blocked && this->dataPtr->queuedBytes + pendingBytes <= this->dataPtr->lowWatermark)
+    {
+        this->dataPtr->blocked = false;
+        callback = this->dataPtr->writableCallback;
+    }
+
+    this->dataPtr->mutex.unlock();
+
+    // Called without the lock, so that the callback can write at once
+    if (callback)
+    {
+        callback();
+    }
+}
+
+void HttpDeferredResponse::wakeUp()
+{
+    // Only one call is queued for all writes that happen before the connection gets to it.
+    // The connection cannot be deleted meanwhile, because detach() needs the locked mutex.
+    if (this->dataPtr->connection && !this->dataPtr->wakeupPending)
+    {
+        this->dataPtr->wakeupPending = true;
+        QMetaObject::invokeMethod(this->dataPtr->connection, "deferredUpdate", Qt::QueuedConnection);
+    }
+}
+
+void HttpDeferredResponse::apply(HttpResponse &response)
+{
+    if (!this->dataPtr)
+    {
+        return;
+    }
+
+    // Take the collected calls, so that other threads are not blocked while writing to the socket
+    this->dataPtr->mutex.lock();
+    const int statusCode = this->dataPtr->statusCode;
+    const QByteArray statusText = this->dataPtr->statusText;
+    const QList<QPair<QByteArray, QByteArray>> headers = this->dataPtr->headers;
+    const QList<HttpCookie> cookies = this->dataPtr->cookies;
+    const QList<QByteArray> chunks = this->dataPtr->chunks;
+    const bool lastPart = this->dataPtr->lastPart;
+    this->dataPtr->statusCode = 0;
+    this->dataPtr->headers.clear();
+    this->dataPtr->cookies.clear();
+    this->dataPtr->chunks.clear();
+    this->dataPtr->queuedBytes = 0;
+    this->dataPtr->wakeupPending = false;
+    this->dataPtr->mutex.unlock();
+
+    if (response.hasSentLastPart())
+    {
+        return;
+    }
+
+    if (statusCode != 0 || !headers.isEmpty() || !cookies.isEmpty())
+    {
+        if (response.sentHeaders)
+        {
+            qWarning("HttpDeferredResponse: headers are ignored because they have already been sent");
+        }
+
+        else
+        {
+            if (statusCode != 0)
+            {
+                response.setStatus(statusCode, statusText);
+            }
+
+            for (const QPair<QByteArray, QByteArray> &header : headers)
+            {
+                response.setHeader(header.first, header.second);
+            }
+
+            for (const HttpCookie &cookie : cookies)
+            {
+                response.setCookie(cookie);
+            }
+        }
+    }
+
+    // Write everything in one piece if possible, so that the Content-Length can be set automatically
+    if (lastPart && !response.sentHeaders)
+    {
+        QByteArray body;
+        for (const QByteArray &chunk : chunks)
+        {
+            body.append(chunk);
+        }
+
+        response.write(body, true);
+        return;
+    }
+
+    for (int i = 0; i < chunks.size(); ++i)
+    {
+        response.write(chunks.at(i), lastPart && i == chunks.size() - 1);
+    }
+}
+
+void HttpDeferredResponse::detach()
+{
+    if (this->dataPtr)
+    {
+        QMutexLocker locker(&this->dataPtr->mutex);
+        this->dataPtr->connection = nullptr;
+        this->dataPtr->chunks.clear();
+        this->dataPtr->queuedBytes = 0;
+        this->dataPtr->writableCallback = nullptr;
+    }
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,162 @@
+#ifndef HTTPDEFERREDRESPONSE_HPP
+#define HTTPDEFERREDRESPONSE_HPP
+
+#include <functional>
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QSharedPointer>
+
+#include "HttpGlobal.hpp"
+#include "HttpCookie.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+class HttpResponse;
+
+/**
+  Handle to a response that is completed after HttpRequestHandler::service() has returned,
+  created by HttpResponse::defer().
+  <p>
+  All methods are thread safe, so the response can be completed by any thread, for example
+  by a callback of a database or a QtConcurrent job:
+  <code><pre>
+    void MyHandler::service(HttpRequest &request, HttpResponse &response)
+    {
+        HttpDeferredResponse deferred = response.defer();
+        QByteArray id = request.getParameter("id");
+
+        QtConcurrent::run([deferred, id]() mutable {
+            deferred.setHeader("Content-Type", "application/json");
+            deferred.write(loadFromBackend(id), true);
+        });
+    }
+  </pre></code>
+  The calls are collected and passed to the thread of the connection, which writes them to the
+  socket. Meanwhile that thread is free to serve other connections. Further requests of the same
+  connection are processed after the deferred response has been completed with lastPart=true.
+  <p>
+  write() never blocks. A producer that writes faster than the client receives should check
+  isWritable() and continue in the callback of setWritableCallback():
+  <code><pre>
+    deferred.setWritableCallback([producer]() { producer->resume(); });
+    while (producer->hasData() && deferred.isWritable())
+        deferred.write(producer->next());
+  </pre></code>
+  <p>
+  Copies of the handle share the same response. When the client disconnects or the response is
+  not completed within readTimeout, the connection is closed, isConnected() returns false and
+  all further calls are ignored.
+*/
+
+class DECLSPEC HttpDeferredResponse
+{
+public:
+
+    /** Creates a null handle, all calls are ignored */
+    HttpDeferredResponse();
+
+    /** Returns true if this handle does not reference a response */
+    bool isNull() const;
+
+    /**
+      Set status code and description. The default is 200,OK.
+      You must call this method before the first write().
+    */
+    void setStatus(int statusCode, const QByteArray &description = QByteArray());
+
+    /**
+      Set a HTTP response header.
+      You must call this method before the first write().
+    */
+    void setHeader(const QByteArray &name, const QByteArray &value);
+
+    /**
+      Set a HTTP response header.
+      You must call this method before the first write().
+    */
+    void setHeader(const QByteArray &name, int value);
+
+    /**
+      Set a cookie.
+      You must call this method before the first write().
+    */
+    void setCookie(const HttpCookie &cookie);
+
+    /**
+      Write body data, like HttpResponse::write().
+      @param data Data bytes of the body
+      @param lastPart Completes the response
+    */
+    void write(const QByteArray &data, bool lastPart = false);
+
+    /** Returns false when the connection has been closed, the response can be dropped then */
+    bool isConnected() const;
+
+    /**
+      Returns false while more than writeHighWatermark bytes wait in this handle and in the
+      output buffer of the socket. This method is thread safe.
+    */
+    bool isWritable() const;
+
+    /**
+      Set a function that is called when the pending output has dropped to writeLowWatermark bytes
+      after isWritable() has returned false. The function is called in the thread of the connection.
+    */
+    void setWritableCallback(const std::function<void()> &callback);
+
+private:
+
+    friend class HttpResponse;
+
+    /** The shared state of all copies of a handle */
+    struct HttpDeferredResponseData
+    {
+        QMutex mutex;
+        QObject *connection = nullptr; // nullptr when the connection is closed
+        bool wakeupPending = false;
+        int statusCode = 0; // 0 = not changed
+        QByteArray statusText;
+        QList<QPair<QByteArray, QByteArray>> headers;
+        QList<HttpCookie> cookies;
+        QList<QByteArray> chunks;
+        bool lastPart = false;
+        qint64 queuedBytes = 0; // size of the chunks
+        qint64 pendingBytes = 0; // output buffer of the socket, as seen by the connection
+        qint64 highWatermark = 0;
+        qint64 lowWatermark = 0;
+        bool blocked = false; // set when isWritable() has returned false
+        std::function<void()> writableCallback;
+    };
+
+    /** Shared state, nullptr for a null handle */
+    QSharedPointer<HttpDeferredResponseData> dataPtr;
+
+    /**
+      Constructor, used by HttpResponse::defer().
+      @param connection Receives a queued call of deferredUpdate() when data has been written
+      @param highWatermark Pending output above which isWritable() returns false
+      @param lowWatermark Pending output at which the writable callback is called
+    */
+    HttpDeferredResponse(QObject *connection, qint64 highWatermark, qint64 lowWatermark);
+
+    /** Update the output buffer size of the socket and call the writable callback if due, called in the thread of the connection */
+    void setPendingBytes(qint64 pendingBytes);
+
+    /** Wake up the connection, the mutex must be locked */
+    void wakeUp();
+
+    /** Pass the collected calls to the response, called in the thread of the connection */
+    void apply(HttpResponse &response);
+
+    /** Disconnect all copies of this handle from the connection */
+    void detach();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPDEFERREDRESPONSE_HPP
@@ -0,0 +1,472 @@
+#include "HttpEventDispatcher.hpp"
+
+#include <QCoreApplication>
+#include <QVarLengthArray>
+
+#ifdef Q_OS_LINUX
+    #include <errno.h>
+    #include <string.h>
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+#ifdef Q_OS_LINUX
+
+/** Number of events that one epoll_wait() returns at most */
+static const int maxEvents = 256;
+
+#endif
+
+HttpEventDispatcher::HttpEventDispatcher(QObject *parent)
+    : QAbstractEventDispatcher(parent)
+{
+    this->clock.start();
+}
+
+HttpEventDispatcher *HttpEventDispatcher::create(QObject *parent)
+{
+#ifdef Q_OS_LINUX
+    const int epollDescriptor = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epollDescriptor == -1)
+    {
+        qWarning("HttpEventDispatcher: cannot create epoll instance: %s", strerror(errno));
+        return nullptr;
+    }
+
+    const int eventDescriptor = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = eventDescriptor;
+
+    if (eventDescriptor == -1 || ::epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, eventDescriptor, &event) == -1)
+    {
+        qWarning("HttpEventDispatcher: cannot create eventfd: %s", strerror(errno));
+        if (eventDescriptor != -1)
+        {
+            ::close(eventDescriptor);
+        }
+
+        ::close(epollDescriptor);
+        return nullptr;
+    }
+
+    HttpEventDispatcher *dispatcher = new HttpEventDispatcher(parent);
+    dispatcher->epollDescriptor = epollDescriptor;
+    dispatcher->eventDescriptor = eventDescriptor;
+    return dispatcher;
+#else
+    Q_UNUSED(parent)
+    return nullptr;
+#endif
+}
+
+HttpEventDispatcher::~HttpEventDispatcher()
+{
+#ifdef Q_OS_LINUX
+    ::close(this->eventDescriptor);
+    ::close(this->epollDescriptor);
+#endif
+}
+
+bool HttpEventDispatcher::processEvents(QEventLoop::ProcessEventsFlags flags)
+{
+    this->interrupted.storeRelease(0);
+    emit this->awake();
+    QCoreApplication::sendPostedEvents();
+
+    const bool includeTimers = !(flags & QEventLoop::X11ExcludeTimers);
+    const bool includeNotifiers = !(flags & QEventLoop::ExcludeSocketNotifiers);
+    const bool wait = (flags & QEventLoop::WaitForMoreEvents) && !this->interrupted.loadAcquire();
+
+    if (wait)
+    {
+        emit this->aboutToBlock();
+    }
+
+    if (this->interrupted.loadAcquire())
+    {
+        return false;
+    }
+
+    // Events that are posted while the thread waits call wakeUp(), which ends the wait
+    int timeout = 0;
+    if (wait)
+    {
+        timeout = includeTimers ? this->timeUntilNextTimer() : -1;
+    }
+
+    int activated = 0;
+
+#ifdef Q_OS_LINUX
+    epoll_event events[maxEvents];
+    int count = ::epoll_wait(this->epollDescriptor, events, maxEvents, timeout);
+    if (count == -1)
+    {
+        if (errno != EINTR)
+        {
+            qWarning("HttpEventDispatcher: epoll_wait failed: %s", strerror(errno));
+        }
+
+        count = 0;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (events[i].data.fd == this->eventDescriptor)
+        {
+            // Clear the flag after reading, so that a wakeUp() in between writes again
+            quint64 value;
+            if (::read(this->eventDescriptor, &value, sizeof(value)) == -1 && errno != EAGAIN)
+            {
+                qWarning("HttpEventDispatcher: cannot read eventfd: %s", strerror(errno));
+            }
+
+            this->woken.storeRelease(0);
+            ++activated;
+        }
+
+        else if (includeNotifiers)
+        {
+            activated += this->activateSocketNotifiers(events[i].data.fd, events[i].events);
+        }
+    }
+#else
+    Q_UNUSED(includeNotifiers)
+    Q_UNUSED(timeout)
+#endif
+
+    if (includeTimers)
+    {
+        activated += this->activateTimers();
+    }
+
+    return activated > 0;
+}
+
+void HttpEventDispatcher::registerSocketNotifier(QSocketNotifier *notifier)
+{
+    Q_ASSERT(notifier != nullptr);
+
+    const int socketDescriptor = static_cast<int>(notifier->socket());
+    const bool registered = this->descriptors.contains(socketDescriptor);
+    Descriptor &descriptor = this->descriptors[socketDescriptor];
+
+    QSocketNotifier **slot = nullptr;
+    switch (notifier->type())
+    {
+        case QSocketNotifier::Read:
+            slot = &descriptor.read;
+            break;
+
+        case QSocketNotifier::Write:
+            slot = &descriptor.write;
+            break;
+
+        case QSocketNotifier::Exception:
+            slot = &descriptor.exception;
+            break;
+    }
+
+    if (*slot && *slot != notifier)
+    {
+        qWarning("HttpEventDispatcher: multiple socket notifiers of the same type for socket %i", socketDescriptor);
+    }
+
+    *slot = notifier;
+    this->updateDescriptor(socketDescriptor, registered);
+}
+
+void HttpEventDispatcher::unregisterSocketNotifier(QSocketNotifier *notifier)
+{
+    Q_ASSERT(notifier != nullptr);
+
+    const int socketDescriptor = static_cast<int>(notifier->socket());
+    auto it = this->descriptors.find(socketDescriptor);
+    if (it == this->descriptors.end())
+    {
+        return;
+    }
+
+    if (it->read == notifier)
+    {
+        it->read = nullptr;
+    }
+
+    if (it->write == notifier)
+    {
+        it->write = nullptr;
+    }
+
+    if (it->exception == notifier)
+    {
+        it->exception = nullptr;
+    }
+
+    this->updateDescriptor(socketDescriptor, true);
+}
+
+void HttpEventDispatcher::updateDescriptor(int socketDescriptor, bool registered)
+{
+    const Descriptor descriptor = this->descriptors.value(socketDescriptor);
+
+    if (!descriptor.read && !descriptor.write && !descriptor.exception)
+    {
+        this->descriptors.remove(socketDescriptor);
+
+#ifdef Q_OS_LINUX
+        // Fails if the descriptor has been closed already, then the kernel has removed it
+        if (registered)
+        {
+            ::epoll_ctl(this->epollDescriptor, EPOLL_CTL_DEL, socketDescriptor, nullptr);
+        }
+#endif
+
+        return;
+    }
+
+#ifdef Q_OS_LINUX
+    // Level-triggered, like the poll() of the default dispatcher
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = (descriptor.read ? EPOLLIN : 0U) | (descriptor.write ? EPOLLOUT : 0U) | (descriptor.exception ? EPOLLPRI : 0U);
+    event.data.fd = socketDescriptor;
+
+    // A descriptor that has been closed and reused is not registered anymore, a new one may be
+    int result = ::epoll_ctl(this->epollDescriptor, registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, socketDescriptor, &event);
+    if (result == -1 && registered && errno == ENOENT)
+    {
+        result = ::epoll_ctl(this->epollDescriptor, EPOLL_CTL_ADD, socketDescriptor, &event);
+    }
+
+    else if (result == -1 && !registered && errno == EEXIST)
+    {
+        result = ::epoll_ctl(this->epollDescriptor, EPOLL_CTL_MOD, socketDescriptor, &event);
+    }
+
+    if (result == -1)
+    {
+        qWarning("HttpEventDispatcher: cannot watch socket %i: %s", socketDescriptor, strerror(errno));
+    }
+#else
+    Q_UNUSED(registered)
+#endif
+}
+
+int HttpEventDispatcher::activateSocketNotifiers(int socketDescriptor, quint32 events)
+{
+    int activated = 0;
+
+#ifdef Q_OS_LINUX
+    if (!this->descriptors.contains(socketDescriptor))
+    {
+        // The notifiers have been disabled by an earlier activation, or the descriptor has been
+        // closed while a duplicate is open, which keeps it registered in the kernel
+        ::epoll_ctl(this->epollDescriptor, EPOLL_CTL_DEL, socketDescriptor, nullptr);
+        return 0;
+    }
+
+    // Each notifier is looked up again, an activation may disable the others
+    QEvent event(QEvent::SockAct);
+
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+    {
+        if (QSocketNotifier *notifier = this->descriptors.value(socketDescriptor).read)
+        {
+            QCoreApplication::sendEvent(notifier, &event);
+            ++activated;
+        }
+    }
+
+    if (events & (EPOLLOUT | EPOLLERR))
+    {
+        if (QSocketNotifier *notifier = this->descriptors.value(socketDescriptor).write)
+        {
+            QCoreApplication::sendEvent(notifier, &event);
+            ++activated;
+        }
+    }
+
+    if (events & EPOLLPRI)
+    {
+        if (QSocketNotifier *notifier = this->descriptors.value(socketDescriptor).exception)
+        {
+            QCoreApplication::sendEvent(notifier, &event);
+            ++activated;
+        }
+    }
+#else
+    Q_UNUSED(socketDescriptor)
+    Q_UNUSED(events)
+#endif
+
+    return activated;
+}
+
+void HttpEventDispatcher::registerTimer(int timerId, int interval, Qt::TimerType timerType, QObject *object)
+{
+    Q_ASSERT(timerId > 0 && interval >= 0 && object != nullptr);
+    this->timers.append(Timer{timerId, interval, timerType, object, this->clock.elapsed() + interval});
+}
+
+bool HttpEventDispatcher::unregisterTimer(int timerId)
+{
+    for (int i = 0; i < this->timers.size(); ++i)
+    {
+        if (this->timers.at(i).id == timerId)
+        {
+            this->timers.removeAt(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool HttpEventDispatcher::unregisterTimers(QObject *object)
+{
+    bool found = false;
+
+    for (int i = this->timers.size() - 1; i >= 0; --i)
+    {
+        if (this->timers.at(i).object == object)
+        {
+            this->timers.removeAt(i);
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+QList<QAbstractEventDispatcher::TimerInfo> HttpEventDispatcher::registeredTimers(QObject *object) const
+{
+    QList<TimerInfo> list;
+
+    for (const Timer &timer : this->timers)
+    {
+        if (timer.object == object)
+        {
+            list.append(TimerInfo(timer.id, timer.interval, timer.type));
+        }
+    }
+
+    return list;
+}
+
+int HttpEventDispatcher::remainingTime(int timerId)
+{
+    for (const Timer &timer : this->timers)
+    {
+        if (timer.id == timerId)
+        {
+            return static_cast<int>(qMax(timer.deadline - this->clock.elapsed(), Q_INT64_C(0)));
+        }
+    }
+
+    return -1;
+}
+
+int HttpEventDispatcher::timeUntilNextTimer() const
+{
+    if (this->timers.isEmpty())
+    {
+        return -1;
+    }
+
+    qint64 next = this->timers.first().deadline;
+    for (const Timer &timer : this->timers)
+    {
+        next = qMin(next, timer.deadline);
+    }
+
+    return static_cast<int>(qBound(Q_INT64_C(0), next - this->clock.elapsed(), Q_INT64_C(0x7fffffff)));
+}
+
+int HttpEventDispatcher::activateTimers()
+{
+    const qint64 now = this->clock.elapsed();
+
+    // Collect the due timers first, an activation may register or unregister timers
+    QVarLengthArray<int, 16> due;
+    for (const Timer &timer : this->timers)
+    {
+        if (timer.deadline <= now)
+        {
+            due.append(timer.id);
+        }
+    }
+
+    int activated = 0;
+
+    for (int timerId : due)
+    {
+        QObject *object = nullptr;
+
+        for (Timer &timer : this->timers)
+        {
+            if (timer.id == timerId)
+            {
+                // A timer that is late skips the activations it has missed
+                timer.deadline += timer.interval;
+                if (timer.deadline < now)
+                {
+                    timer.deadline = now + timer.interval;
+                }
+
+                object = timer.object;
+                break;
+            }
+        }
+
+        // An earlier activation may have unregistered the timer
+        if (object)
+        {
+            QTimerEvent event(timerId);
+            QCoreApplication::sendEvent(object, &event);
+            ++activated;
+        }
+    }
+
+    return activated;
+}
+
+void HttpEventDispatcher::wakeUp()
+{
+#ifdef Q_OS_LINUX
+    // Only the first call writes until the thread has woken up
+    if (this->woken.testAndSetAcquire(0, 1))
+    {
+        const quint64 value = 1;
+        if (::write(this->eventDescriptor, &value, sizeof(value)) == -1)
+        {
+            qWarning("HttpEventDispatcher: cannot write eventfd: %s", strerror(errno));
+        }
+    }
+#endif
+}
+
+void HttpEventDispatcher::interrupt()
+{
+    this->interrupted.storeRelease(1);
+    this->wakeUp();
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+
+bool HttpEventDispatcher::hasPendingEvents()
+{
+    // Events that other threads have posted since the last wakeup
+    return this->woken.loadAcquire() != 0;
+}
+
+void HttpEventDispatcher::flush()
+{
+}
+
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,130 @@
+#ifndef HTTPEVENTDISPATCHER_HPP
+#define HTTPEVENTDISPATCHER_HPP
+
+#include <QAbstractEventDispatcher>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QSocketNotifier>
+
+#include "HttpGlobal.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Event dispatcher of a HttpWorker thread, based on Linux epoll.
+  <p>
+  The default dispatcher of Qt 5 builds a poll() set of all socket notifiers of the thread
+  and scans it on every wakeup, so each event costs time in proportion to the number of
+  connections. A worker of the EventLoop engine carries thousands of mostly idle keep-alive
+  connections, so this dispatcher keeps the notifiers registered in an epoll instance and
+  only looks at the sockets that are ready. Adding, changing and removing a notifier is one
+  epoll_ctl() call.
+  <p>
+  Timers are kept in a plain list that is scanned on each wakeup, because the connections of
+  a worker share one HttpTimerWheel and there are only a few timers per thread. Posted events
+  and wakeUp() from other threads are signalled through an eventfd.
+  <p>
+  The dispatcher is only available on Linux, create() returns `nullptr` otherwise, so that the
+  thread keeps the default dispatcher of Qt.
+  @see HttpWorker which installs the dispatcher on its thread
+*/
+
+class DECLSPEC HttpEventDispatcher : public QAbstractEventDispatcher
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpEventDispatcher)
+
+public:
+
+    /**
+      Create a dispatcher, to be installed with QThread::setEventDispatcher() before the thread starts.
+      @param parent Parent object
+      @return `nullptr` if epoll is not supported or the dispatcher cannot be created.
+    */
+    static HttpEventDispatcher *create(QObject *parent = nullptr);
+
+    /** Destructor */
+    virtual ~HttpEventDispatcher();
+
+    /** Implementation of QAbstractEventDispatcher */
+    virtual bool processEvents(QEventLoop::ProcessEventsFlags flags);
+    virtual void registerSocketNotifier(QSocketNotifier *notifier);
+    virtual void unregisterSocketNotifier(QSocketNotifier *notifier);
+    virtual void registerTimer(int timerId, int interval, Qt::TimerType timerType, QObject *object);
+    virtual bool unregisterTimer(int timerId);
+    virtual bool unregisterTimers(QObject *object);
+    virtual QList<TimerInfo> registeredTimers(QObject *object) const;
+    virtual int remainingTime(int timerId);
+    virtual void wakeUp();
+    virtual void interrupt();
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    virtual bool hasPendingEvents();
+    virtual void flush();
+#endif
+
+private:
+
+    /** Socket notifiers of one file descriptor */
+    struct Descriptor
+    {
+        QSocketNotifier *read = nullptr;
+        QSocketNotifier *write = nullptr;
+        QSocketNotifier *exception = nullptr;
+    };
+
+    /** A registered timer */
+    struct Timer
+    {
+        int id;
+        int interval;
+        Qt::TimerType type;
+        QObject *object;
+
+        /** Time of the next activation, on the clock of the dispatcher */
+        qint64 deadline;
+    };
+
+    /** Constructor, use create() */
+    explicit HttpEventDispatcher(QObject *parent);
+
+    /** The epoll instance */
+    int epollDescriptor = -1;
+
+    /** Signals wakeUp() to the epoll instance */
+    int eventDescriptor = -1;
+
+    /** Registered socket notifiers, key is the file descriptor */
+    QHash<int, Descriptor> descriptors;
+
+    /** Registered timers */
+    QList<Timer> timers;
+
+    /** Monotonic clock of the timers */
+    QElapsedTimer clock;
+
+    /** Set by wakeUp() until the eventfd has been read, so that only the first wakeUp() writes to it */
+    QAtomicInt woken;
+
+    /** Set by interrupt(), processEvents() returns without waiting */
+    QAtomicInt interrupted;
+
+    /** Add, change or remove a file descriptor in the epoll instance, after its notifiers have changed */
+    void updateDescriptor(int socketDescriptor, bool registered);
+
+    /** Milliseconds until the next timer is due, -1 if there is no timer */
+    int timeUntilNextTimer() const;
+
+    /** Send the events of all timers that are due. Returns the number of activated timers. */
+    int activateTimers();
+
+    /** Send the events of the ready socket notifiers of a file descriptor. Returns the number of activated notifiers. */
+    int activateSocketNotifiers(int socketDescriptor, quint32 events);
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPEVENTDISPATCHER_HPP
@@ -0,0 +1,143 @@
+#include "HttpHandoffChannel.hpp"
+
+#ifdef Q_OS_UNIX
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+    #include <sys/eventfd.h>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpHandoffChannel::HttpHandoffChannel(int capacity, QObject *parent)
+    : QObject(parent),
+      queue(static_cast<std::size_t>(qMax(capacity, 1)))
+{
+#if defined(Q_OS_LINUX)
+    this->eventReadDescriptor = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    this->eventWriteDescriptor = this->eventReadDescriptor;
+#elif defined(Q_OS_UNIX)
+    int pipeDescriptors[2];
+    if (::pipe(pipeDescriptors) == 0)
+    {
+        for (int descriptor : pipeDescriptors)
+        {
+            ::fcntl(descriptor, F_SETFL, ::fcntl(descriptor, F_GETFL) | O_NONBLOCK);
+            ::fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+        }
+
+        this->eventReadDescriptor = pipeDescriptors[0];
+        this->eventWriteDescriptor = pipeDescriptors[1];
+    }
+#endif
+}
+
+HttpHandoffChannel::~HttpHandoffChannel()
+{
+    delete this->notifier;
+    this->notifier = nullptr;
+
+#ifdef Q_OS_UNIX
+    // Nobody will receive these connections anymore
+    tSocketDescriptor socketDescriptor;
+    while (this->queue.dequeue(socketDescriptor))
+    {
+        ::close(static_cast<int>(socketDescriptor));
+    }
+
+    if (this->eventWriteDescriptor != -1 && this->eventWriteDescriptor != this->eventReadDescriptor)
+    {
+        ::close(this->eventWriteDescriptor);
+    }
+
+    if (this->eventReadDescriptor != -1)
+    {
+        ::close(this->eventReadDescriptor);
+    }
+#endif
+}
+
+void HttpHandoffChannel::attach()
+{
+    if (this->eventReadDescriptor == -1 || this->notifier)
+    {
+        return;
+    }
+
+    this->notifier = new QSocketNotifier(this->eventReadDescriptor, QSocketNotifier::Read, this);
+    QObject::connect(this->notifier, &QSocketNotifier::activated, this, &HttpHandoffChannel::drain);
+
+    // Descriptors may have arrived before the notifier existed
+    this->drain();
+}
+
+void HttpHandoffChannel::detach()
+{
+    delete this->notifier;
+    this->notifier = nullptr;
+}
+
+bool HttpHandoffChannel::push(tSocketDescriptor socketDescriptor)
+{
+    if (!this->queue.enqueue(socketDescriptor))
+    {
+        return false;
+    }
+
+    // Only the first producer after a drain has to wake up the receiver
+    if (this->wakeupPending.fetchAndStoreOrdered(1) == 0)
+    {
+        this->wakeup();
+    }
+
+    return true;
+}
+
+void HttpHandoffChannel::wakeup()
+{
+#ifdef Q_OS_UNIX
+    if (this->eventWriteDescriptor != -1)
+    {
+        #ifdef Q_OS_LINUX
+            const quint64 value = 1;
+        #else
+            const char value = 1;
+        #endif
+
+        while (::write(this->eventWriteDescriptor, &value, sizeof(value)) == -1 && errno == EINTR)
+        {
+        }
+
+        return;
+    }
+#endif
+
+    QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+}
+
+void HttpHandoffChannel::drain()
+{
+#ifdef Q_OS_UNIX
+    // Reset the wakeup event before the queue is read, so no later push can be missed
+    if (this->eventReadDescriptor != -1)
+    {
+        char buffer[64];
+        while (::read(this->eventReadDescriptor, buffer, sizeof(buffer)) > 0)
+        {
+        }
+    }
+#endif
+
+    this->wakeupPending.fetchAndStoreOrdered(0);
+
+    tSocketDescriptor socketDescriptor;
+    while (this->queue.dequeue(socketDescriptor))
+    {
+        emit this->received(socketDescriptor);
+    }
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
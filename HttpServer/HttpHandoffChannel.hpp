@@ -0,0 +1,95 @@
+#ifndef HTTPHANDOFFCHANNEL_HPP
+#define HTTPHANDOFFCHANNEL_HPP
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QSocketNotifier>
+
+#include "HttpGlobal.hpp"
+#include "HttpConnection.hpp"
+#include "HttpLockFreeQueue.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Passes accepted socket descriptors to the thread of a connection handler or worker
+  without the Qt event queue.
+  <p>
+  The descriptors are put into a lock-free ring and the receiving thread is woken up
+  through an eventfd (a pipe on other Unix systems) that is watched by a socket notifier.
+  A push() therefore costs no heap allocation and no slot lookup by name, and the
+  receiver is only woken up once for all descriptors that arrive while it is busy.
+  On Windows the wakeup falls back to a queued call.
+  <p>
+  push() may be called from any thread. The channel must live in the receiving thread,
+  and attach() must be called in that thread before the event loop starts.
+*/
+
+class DECLSPEC HttpHandoffChannel : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpHandoffChannel)
+
+public:
+
+    /**
+      Constructor.
+      @param capacity Number of descriptors that can wait in the channel
+      @param parent Parent object.
+    */
+    HttpHandoffChannel(int capacity, QObject *parent = nullptr);
+
+    /** Destructor, closes the descriptors that have not been received */
+    virtual ~HttpHandoffChannel();
+
+    /** Start watching for descriptors, must be called in the receiving thread */
+    void attach();
+
+    /** Stop watching for descriptors, must be called in the receiving thread */
+    void detach();
+
+    /**
+      Pass a descriptor to the receiving thread. This method is thread safe.
+      @param socketDescriptor references the accepted connection.
+      @return false if the channel is full, the caller keeps ownership of the descriptor then.
+    */
+    bool push(tSocketDescriptor socketDescriptor);
+
+signals:
+
+    /**
+      Emitted in the receiving thread for each descriptor.
+      @param socketDescriptor references the accepted connection.
+    */
+    void received(tSocketDescriptor socketDescriptor);
+
+private:
+
+    /** The descriptors in flight */
+    HttpLockFreeQueue<tSocketDescriptor> queue;
+
+    /** 1 while a wakeup is outstanding, so producers do not signal twice */
+    QAtomicInt wakeupPending;
+
+    /** Read end of the wakeup event, -1 if not available */
+    int eventReadDescriptor = -1;
+
+    /** Write end of the wakeup event, the same as the read end for an eventfd */
+    int eventWriteDescriptor = -1;
+
+    /** Watches the wakeup event, only used in the receiving thread */
+    QSocketNotifier *notifier = nullptr;
+
+    /** Wake up the receiving thread */
+    void wakeup();
+
+private slots:
+
+    /** Emit received() for all descriptors in the channel */
+    void drain();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPHANDOFFCHANNEL_HPP
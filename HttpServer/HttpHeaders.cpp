@@ -0,0 +1,222 @@
+#include "HttpHeaders.hpp"
+
+#include <string.h>
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+namespace {
+
+/** Names of the Ids in lower-case, in the order of the enum */
+const char *const names[HttpHeaders::IdCount] =
+{
+    "",
+    "accept",
+    "accept-charset",
+    "accept-encoding",
+    "accept-language",
+    "access-control-request-headers",
+    "access-control-request-method",
+    "authorization",
+    "cache-control",
+    "connection",
+    "content-disposition",
+    "content-encoding",
+    "content-length",
+    "content-type",
+    "cookie",
+    "date",
+    "expect",
+    "forwarded",
+    "from",
+    "host",
+    "if-match",
+    "if-modified-since",
+    "if-none-match",
+    "if-range",
+    "if-unmodified-since",
+    "keep-alive",
+    "max-forwards",
+    "origin",
+    "pragma",
+    "proxy-authorization",
+    "range",
+    "referer",
+    "sec-websocket-key",
+    "sec-websocket-version",
+    "te",
+    "trailer",
+    "transfer-encoding",
+    "upgrade",
+    "upgrade-insecure-requests",
+    "user-agent",
+    "via",
+    "x-forwarded-for",
+    "x-forwarded-host",
+    "x-forwarded-proto",
+    "x-real-ip",
+    "x-requested-with"
+};
+
+/** Hash table from names to Ids with linear probing, built once */
+struct NameTable
+{
+    static const uint slotCount = 128;
+
+    quint8 slots[slotCount];
+    int sizes[HttpHeaders::IdCount];
+
+    NameTable()
+    {
+        memset(this->slots, HttpHeaders::Unknown, sizeof(this->slots));
+
+        for (int id = 1; id < HttpHeaders::IdCount; ++id)
+        {
+            uint hash = 0;
+            this->sizes[id] = static_cast<int>(qstrlen(names[id]));
+            for (int i = 0; i < this->sizes[id]; ++i)
+            {
+                hash = HttpHeaders::hash(hash, names[id][i]);
+            }
+
+            uint slot = hash % slotCount;
+            while (this->slots[slot] != HttpHeaders::Unknown)
+            {
+                slot = (slot + 1) % slotCount;
+            }
+
+            this->slots[slot] = static_cast<quint8>(id);
+        }
+    }
+};
+
+const NameTable &nameTable()
+{
+    static const NameTable instance;
+    return instance;
+}
+
+}
+
+HttpHeaders::HttpHeaders()
+{
+    this->clear();
+}
+
+void HttpHeaders::append(const Field &field)
+{
+    if (field.id != Unknown)
+    {
+        this->lastIndex[field.id] = this->fields.size();
+    }
+
+    this->fields.append(field);
+}
+
+void HttpHeaders::remove(Id id)
+{
+    if (this->lastIndex[id] == -1)
+    {
+        return;
+    }
+
+    // Compact the fields and rebuild the positions
+    const QVarLengthArray<Field, 16> previous = this->fields;
+    this->clear();
+    for (const Field &field : previous)
+    {
+        if (field.id != id)
+        {
+            this->append(field);
+        }
+    }
+}
+
+void HttpHeaders::clear()
+{
+    this->fields.clear();
+    for (int &index : this->lastIndex)
+    {
+        index = -1;
+    }
+}
+
+int HttpHeaders::size() const
+{
+    return this->fields.size();
+}
+
+const HttpHeaders::Field &HttpHeaders::at(int index) const
+{
+    return this->fields.at(index);
+}
+
+HttpHeaders::Field &HttpHeaders::last()
+{
+    return this->fields.last();
+}
+
+int HttpHeaders::lastIndexOf(Id id) const
+{
+    return this->lastIndex[id];
+}
+
+int HttpHeaders::lastIndexOf(const QByteArray &head, const QByteArray &name, int from) const
+{
+    const Id id = toId(name);
+    if (id != Unknown && from < 0)
+    {
+        return this->lastIndex[id];
+    }
+
+    for (int i = (from < 0 ? this->fields.size() : from) - 1; i >= 0; --i)
+    {
+        const Field &field = this->fields.at(i);
+
+        // Known names are compared by their Id
+        if (id != Unknown ? field.id == id :
+            field.id == Unknown && field.name.size == name.size() &&
+            qstrnicmp(head.constData() + field.name.offset, name.constData(), static_cast<uint>(name.size())) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+HttpHeaders::Id HttpHeaders::toId(const char *name, int size, uint hash)
+{
+    const NameTable &table = nameTable();
+
+    uint slot = hash % NameTable::slotCount;
+    while (table.slots[slot] != Unknown)
+    {
+        const int id = table.slots[slot];
+        if (table.sizes[id] == size && qstrnicmp(name, names[id], static_cast<uint>(size)) == 0)
+        {
+            return static_cast<Id>(id);
+        }
+
+        slot = (slot + 1) % NameTable::slotCount;
+    }
+
+    return Unknown;
+}
+
+HttpHeaders::Id HttpHeaders::toId(const QByteArray &name)
+{
+    uint hash = 0;
+    for (const char c : name)
+    {
+        hash = HttpHeaders::hash(hash, c);
+    }
+
+    return toId(name.constData(), name.size(), hash);
+}
+
+const char *HttpHeaders::toName(Id id)
+{
+    return id < IdCount ? names[id] : names[Unknown];
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,153 @@
+#ifndef HTTPHEADERS_HPP
+#define HTTPHEADERS_HPP
+
+#include <QByteArray>
+#include <QVarLengthArray>
+
+#include "HttpGlobal.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Compact storage for the header fields of a request, filled by HttpRequestParser.
+  <p>
+  Names and values are spans into the received head. The usual number of fields is stored
+  inline without allocation. Well-known names are resolved to an Id once while parsing, and
+  the position of the last field of each Id is kept in an array, so that e.g. Connection or
+  Content-Length is found without comparing names and without allocating memory.
+  Other names are found by comparing them with all fields, ignoring case.
+*/
+
+class DECLSPEC HttpHeaders
+{
+public:
+
+    /** Well-known header names */
+    enum Id : quint8
+    {
+        Unknown = 0,
+        Accept,
+        AcceptCharset,
+        AcceptEncoding,
+        AcceptLanguage,
+        AccessControlRequestHeaders,
+        AccessControlRequestMethod,
+        Authorization,
+        CacheControl,
+        Connection,
+        ContentDisposition,
+        ContentEncoding,
+        ContentLength,
+        ContentType,
+        Cookie,
+        Date,
+        Expect,
+        Forwarded,
+        From,
+        Host,
+        IfMatch,
+        IfModifiedSince,
+        IfNoneMatch,
+        IfRange,
+        IfUnmodifiedSince,
+        KeepAlive,
+        MaxForwards,
+        Origin,
+        Pragma,
+        ProxyAuthorization,
+        Range,
+        Referer,
+        SecWebSocketKey,
+        SecWebSocketVersion,
+        TE,
+        Trailer,
+        TransferEncoding,
+        Upgrade,
+        UpgradeInsecureRequests,
+        UserAgent,
+        Via,
+        XForwardedFor,
+        XForwardedHost,
+        XForwardedProto,
+        XRealIp,
+        XRequestedWith,
+        IdCount
+    };
+
+    /** Part of the head */
+    struct Span
+    {
+        int offset;
+        int size;
+    };
+
+    /** Header field */
+    struct Field
+    {
+        Span name;
+        Span value;
+        Id id;
+    };
+
+    /** Constructor */
+    HttpHeaders();
+
+    /** Add a field */
+    void append(const Field &field);
+
+    /** Remove all fields with the given Id */
+    void remove(Id id);
+
+    /** Remove all fields */
+    void clear();
+
+    /** Number of fields */
+    int size() const;
+
+    /** Field at the given position, in the order of the request */
+    const Field &at(int index) const;
+
+    /** The field that has been added last */
+    Field &last();
+
+    /** Position of the last field with the given Id, or -1 */
+    int lastIndexOf(Id id) const;
+
+    /**
+      Position of the last field with the given name before the position from, or -1.
+      @param head Buffer that the spans point into
+      @param name Name, not case-sensitive
+      @param from Position after the field to start with, -1 for the end
+    */
+    int lastIndexOf(const QByteArray &head, const QByteArray &name, int from = -1) const;
+
+    /** Step of the hash of a name, which ignores the case of ASCII letters */
+    static uint hash(uint hash, char c);
+
+    /** Get the Id of a name with the given hash, not case-sensitive */
+    static Id toId(const char *name, int size, uint hash);
+
+    /** Get the Id of a name, not case-sensitive */
+    static Id toId(const QByteArray &name);
+
+    /** Get the name of an Id in lower-case, an empty string for Unknown */
+    static const char *toName(Id id);
+
+private:
+
+    /** Fields in the order of the request */
+    QVarLengthArray<Field, 16> fields;
+
+    /** Position of the last field of each Id, -1 if there is none */
+    int lastIndex[IdCount];
+
+};
+
+inline uint HttpHeaders::hash(uint hash, char c)
+{
+    return hash * 31 + (static_cast<uchar>(c) | 0x20);
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPHEADERS_HPP
@@ -1,13 +1,14 @@
 #include "HttpListener.hpp"
 #include "HttpConnectionHandler.hpp"
 #include "HttpConnectionHandlerPool.hpp"
+#include "HttpSocketOptions.hpp"
 
 #include <QCoreApplication>
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
 
 HttpListener::HttpListener(HttpServerSettings *settings, HttpRequestHandler* requestHandler, QObject *parent)
-    : QTcpServer(parent)
+    : QTcpServer(parent), limiter(settings, &this->metrics)
 {
     Q_ASSERT(requestHandler != nullptr);
     this->settings = settings;
@@ -16,6 +17,27 @@ HttpListener::HttpListener(HttpServerSettings *settings, HttpRequestHandler* req
     // Reqister type of socketDescriptor for signal/slot handling
     qRegisterMetaType<tSocketDescriptor>("tSocketDescriptor");
 
+    this->drainTimer.setInterval(100);
+    QObject::connect(&this->drainTimer, &QTimer::timeout, this, [this]()
+    {
+        if (this->getConnectionCount() == 0)
+        {
+            this->drainTimer.stop();
+            qDebug("HttpListener: drained");
+            emit this->drained();
+        }
+    });
+
+    if (this->limiter.isEnabled())
+    {
+        this->decayTimer.setInterval(static_cast<int>(qMax(this->settings->cleanupInterval, 1U)));
+        QObject::connect(&this->decayTimer, &QTimer::timeout, this, [this]()
+        {
+            this->limiter.decay();
+        });
+        this->decayTimer.start();
+    }
+
     // Start listening
     this->listen();
 }
@@ -28,66 +50,167 @@ HttpListener::~HttpListener()
 
 void HttpListener::listen()
 {
-    if (!this->pool)
+    QHostAddress address = QString(this->settings->host).isEmpty() ? QHostAddress::Any : QHostAddress(this->settings->host);
+    quint32 acceptorCount = qMax(this->settings->acceptorThreads, 1U);
+
+    QList<qintptr> inheritedSockets = this->settings->inheritedSockets;
+    this->settings->inheritedSockets.clear();
+
+    if (!inheritedSockets.isEmpty())
     {
-        this->pool = new HttpConnectionHandlerPool(this->settings, this->requestHandler);
+        // Take over the sockets of the previous process, they are already bound and listening.
+        // All of them are used, because closing one would reset the connections in its accept queue.
+        acceptorCount = qMax(acceptorCount, static_cast<quint32>(inheritedSockets.size()));
+
+        const qintptr inheritedSocket = inheritedSockets.takeFirst();
+        if (!this->setSocketDescriptor(inheritedSocket))
+        {
+            qWarning("HttpListener: Cannot use the inherited socket, binding a new one");
+            HttpAcceptor::closeSocket(inheritedSocket);
+        }
     }
 
-    QTcpServer::listen(QString(this->settings->host).isEmpty() ? QHostAddress::Any : QHostAddress(this->settings->host), this->settings->port);
+    if (acceptorCount > 1 && !this->isListening())
+    {
+        // All acceptors bind their own socket to the same port, the kernel balances the connections between them
+        tSocketDescriptor socketDescriptor = HttpAcceptor::createListeningSocket(address, this->settings->port);
+
+        if (socketDescriptor == -1 || !this->setSocketDescriptor(socketDescriptor))
+        {
+            qWarning("HttpListener: Cannot use SO_REUSEPORT, falling back to a single acceptor");
+            HttpAcceptor::closeSocket(socketDescriptor);
+            acceptorCount = 1;
+        }
+    }
+
+    if (!this->dispatcher)
+    {
+        if (acceptorCount > 1)
+        {
+            this->shardSettings = HttpAcceptor::shardSettings(*this->settings, acceptorCount);
+            this->dispatcher = new HttpConnectionDispatcher(&this->shardSettings, this->requestHandler, &this->metrics, &this->limiter);
+        }
+
+        else
+        {
+            this->dispatcher = new HttpConnectionDispatcher(this->settings, this->requestHandler, &this->metrics, &this->limiter);
+        }
+    }
+
+    if (acceptorCount == 1 && !this->isListening())
+    {
+        QTcpServer::listen(address, this->settings->port);
+    }
 
     if (!this->isListening())
     {
         qCritical("HttpListener: Cannot bind on port %i: %s", this->settings->port, qUtf8Printable(this->errorString()));
+        return;
     }
 
-    else
+    HttpSocketOptions::applyToListeningSocket(this->socketDescriptor(), *this->settings);
+
+    for (quint32 i = 1; i < acceptorCount; ++i)
     {
-        qDebug("HttpListener: Listening on port %s:%i", qUtf8Printable(this->settings->host), this->settings->port);
+        // Use the actual port, in case that the configured port is 0
+        tSocketDescriptor socketDescriptor = inheritedSockets.isEmpty() ? HttpAcceptor::createListeningSocket(address, this->serverPort())
+                                                                        : inheritedSockets.takeFirst();
+
+        if (socketDescriptor == -1)
+        {
+            qCritical("HttpListener: Cannot open acceptor %u on port %i", i, this->serverPort());
+            break;
+        }
+
+        HttpSocketOptions::applyToListeningSocket(socketDescriptor, *this->settings);
+        this->acceptors.append(new HttpAcceptor(HttpAcceptor::shardSettings(*this->settings, acceptorCount, i), this->requestHandler, socketDescriptor, &this->metrics, &this->limiter));
     }
+
+    qDebug("HttpListener: Listening on port %s:%i with %i acceptor(s)", qUtf8Printable(this->settings->host), this->settings->port, this->acceptors.size() + 1);
 }
 
 void HttpListener::close()
 {
     QTcpServer::close();
+    this->drainTimer.stop();
+
+    for (HttpAcceptor *acceptor : this->acceptors)
+    {
+        delete acceptor;
+    }
+
+    this->acceptors.clear();
     qDebug("HttpListener: closed");
 
-    if (this->pool)
+    if (this->dispatcher)
     {
-        delete this->pool;
-        this->pool = nullptr;
+        delete this->dispatcher;
+        this->dispatcher = nullptr;
     }
 }
 
-void HttpListener::incomingConnection(tSocketDescriptor socketDescriptor)
+void HttpListener::drain()
 {
-#ifdef QTWEBAPP_SUPERVERBOSE
-    qDebug("HttpListener: New connection");
-#endif
+    qDebug("HttpListener: draining");
+    this->pauseAccepting();
 
-    HttpConnectionHandler *freeHandler = nullptr;
+    for (HttpAcceptor *acceptor : this->acceptors)
+    {
+        acceptor->drain();
+    }
+
+    if (this->dispatcher)
+    {
+        this->dispatcher->drain();
+    }
+
+    this->drainTimer.start();
+}
 
-    if (this->pool)
+QList<tSocketDescriptor> HttpListener::getListeningSockets() const
+{
+    QList<tSocketDescriptor> sockets;
+
+    if (this->isListening())
     {
-        freeHandler = this->pool->getConnectionHandler();
+        sockets.append(this->socketDescriptor());
     }
 
-    // Let the handler process the new connection.
-    if (freeHandler)
+    for (HttpAcceptor *acceptor : this->acceptors)
     {
-        // The descriptor is passed via event queue because the handler lives in another thread
-        QMetaObject::invokeMethod(freeHandler, "handleConnection", Qt::QueuedConnection, Q_ARG(tSocketDescriptor, socketDescriptor));
+        if (acceptor->getSocketDescriptor() != -1)
+        {
+            sockets.append(acceptor->getSocketDescriptor());
+        }
     }
 
-    else
+    return sockets;
+}
+
+int HttpListener::getConnectionCount() const
+{
+    int count = this->dispatcher ? this->dispatcher->getConnectionCount() : 0;
+
+    for (HttpAcceptor *acceptor : this->acceptors)
     {
-        // Reject the connection
-        qDebug("HttpListener: Too many incoming connections");
-        QTcpSocket *socket = new QTcpSocket(this);
-        socket->setSocketDescriptor(socketDescriptor);
-        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
-        socket->write("HTTP/1.1 503 Too Many Connections\nConnection: close\n\nToo Many Connections\n");
-        socket->disconnectFromHost();
+        count += acceptor->getConnectionCount();
     }
+
+    return count;
+}
+
+const HttpServerMetrics &HttpListener::getMetrics() const
+{
+    return this->metrics;
+}
+
+void HttpListener::incomingConnection(tSocketDescriptor socketDescriptor)
+{
+#ifdef QTWEBAPP_SUPERVERBOSE
+    qDebug("HttpListener: New connection");
+#endif
+
+    this->dispatcher->dispatch(socketDescriptor);
 }
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_END
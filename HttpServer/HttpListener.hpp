@@ -3,11 +3,18 @@
 
 #include <QTcpServer>
 #include <QBasicTimer>
+#include <QList>
+#include <QTimer>
 
 #include "HttpGlobal.hpp"
+#include "HttpAcceptor.hpp"
+#include "HttpClientLimiter.hpp"
 #include "HttpConnectionHandler.hpp"
 #include "HttpConnectionHandlerPool.hpp"
+#include "HttpConnectionDispatcher.hpp"
+#include "HttpWorkerPool.hpp"
 #include "HttpRequestHandler.hpp"
+#include "HttpServerMetrics.hpp"
 #include "HttpServerSettings.hpp"
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
@@ -20,19 +27,92 @@ QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
   <code><pre>
   ;host=192.168.0.100
   port=8080
+  ;connectionEngine=EventLoop
+  ;workerThreads=0
+  ;maxConnections=10000
+  ;maxClientConnections=0
+  ;clientConnectionRate=0
+  ;clientConnectionBurst=0
+  ;clientRequestRate=0
+  ;clientRequestBurst=0
+  ;acceptorThreads=1
+  ;maxPendingConnections=128
+  ;maxPendingTime=1000
   minThreads=1
   maxThreads=10
+  ;spareThreads=4
+  ;acceptorCpus=0-1
+  ;workerCpus=2-15
+  ;steerConnections=false
+  ;tcpNoDelay=true
+  ;tcpCork=true
+  ;deferAccept=0
+  ;fastOpenQueue=0
   cleanupInterval=1000
   readTimeout=60000
+  ;parkIdleConnections=false
+  ;ioUring=true
   ;sslKeyFile=ssl/my.key
   ;sslCertFile=ssl/my.cert
+  ;maxBufferedBytes=0
   maxRequestSize=16000
   maxMultiPartSize=1000000
   </pre></code>
   The optional host parameter binds the listener to one network interface.
   The listener handles all network interfaces if no host is configured.
   The port number specifies the incoming TCP port that this listener listens to.
-  @see HttpConnectionHandlerPool for description of config settings minThreads, maxThreads, cleanupInterval and ssl settings
+  <p>
+  The connectionEngine selects how connections are served. The default ThreadPerConnection engine
+  uses one thread per connection, so maxThreads is also the maximum number of concurrent connections.
+  The EventLoop engine uses a fixed number of worker threads that serve up to maxConnections
+  connections together. Both engines call HttpRequestHandler::service() in the same way.
+  <p>
+  With acceptorThreads greater than 1, the listener opens that many sockets on the same port
+  with SO_REUSEPORT. The listener itself accepts on the first one, each other socket gets its own
+  HttpAcceptor thread. Every acceptor feeds its own shard of handlers or workers, and the limits
+  maxThreads, minThreads, spareThreads, workerThreads, maxConnections and maxPendingConnections
+  are divided evenly between the shards.
+  <p>
+  acceptorCpus and workerCpus pin the server threads to CPUs, which keeps their caches warm and
+  their memory on one NUMA node. Each HttpAcceptor thread takes one CPU of acceptorCpus, the
+  listener itself accepts in the thread of the application and is not pinned. The runtime placement
+  of all threads is part of getMetrics(). HttpThreadPlacement::parseCpuList() converts the lists of
+  the config file, like "0-1,4", into the settings.
+  <p>
+  tcpNoDelay and tcpCork form the socket option profile of the connections: responses are
+  collected in full segments while they are written and sent without delay when they are complete.
+  deferAccept lets the kernel hold back connections until the client has sent data, fastOpenQueue
+  enables TCP Fast Open. See HttpSocketOptions for the platform support.
+  <p>
+  ioUring lets the workers of the EventLoop engine and the HttpAcceptor threads do their I/O
+  through io_uring (see HttpUring). It needs a library built with <code>CONFIG += qtwebapp_uring</code>
+  and Linux 6.0, otherwise the socket notifiers of Qt are used as before.
+  <p>
+  For an upgrade without dropping connections, a QtService application passes the listening sockets
+  of the listener and of all acceptors to its successor and drains its own connections:
+  <code><pre>
+  // old process, before listening for upgrade commands
+  QList<int> descriptors;
+  for (tSocketDescriptor descriptor : listener->getListeningSockets())
+      descriptors.append(int(descriptor));
+  setUpgradeDescriptors(descriptors);
+
+  // old process, in the override of QtServiceBase::handOver()
+  QObject::connect(listener, &HttpListener::drained, qApp, &QCoreApplication::quit);
+  listener->drain();
+
+  // new process, before creating the listener
+  for (int descriptor : inheritedDescriptors())
+      settings.inheritedSockets.append(descriptor);
+  </pre></code>
+  The new process accepts on the inherited sockets at once, so no connection attempt is refused
+  or reset while the old process finishes its requests. It uses every inherited socket, even if
+  it has been configured with fewer acceptorThreads.
+  @see HttpClientLimiter for description of config settings maxClientConnections, clientConnectionRate, clientConnectionBurst, clientRequestRate and clientRequestBurst
+  @see HttpConnectionHandlerPool for description of config settings minThreads, maxThreads, spareThreads, cleanupInterval, parkIdleConnections and ssl settings
+  @see HttpWorkerPool for description of config settings workerThreads, maxConnections, workerCpus and steerConnections
+  @see HttpPendingQueue for description of config settings maxPendingConnections and maxPendingTime
+  @see HttpConnection for description of the memory budget maxBufferedBytes
   @see HttpConnectionHandler for description of the readTimeout
   @see HttpRequest for description of config settings maxRequestSize and maxMultiPartSize
 */
@@ -68,6 +148,26 @@ public:
     */
     void close();
 
+    /**
+      Stop accepting and close all connections as soon as they are idle. Busy connections finish
+      their current request and are closed afterwards. drained() is emitted when no connection is
+      left. The listening socket of the listener itself stays open for a successor process, it is
+      closed by close().
+    */
+    void drain();
+
+    /**
+      Listening sockets of this listener and all of its acceptors, which are passed to a successor
+      process on upgrade. The listener's own socket comes first. Call this before drain().
+    */
+    QList<tSocketDescriptor> getListeningSockets() const;
+
+    /** Number of open and waiting connections of this listener and all of its acceptors */
+    int getConnectionCount() const;
+
+    /** Runtime counters of this listener and all of its acceptors */
+    const HttpServerMetrics &getMetrics() const;
+
 protected:
 
     /** Serves new incoming connection requests */
@@ -77,11 +177,29 @@ private:
 
     HttpServerSettings *settings = nullptr;
 
+    /** Settings of the shard of this listener, used if there are multiple acceptors */
+    HttpServerSettings shardSettings;
+
     /** Point to the reuqest handler which processes all HTTP requests */
     HttpRequestHandler *requestHandler = nullptr;
 
-    /** Pool of connection handlers */
-    HttpConnectionHandlerPool *pool = nullptr;
+    /** Passes the connections accepted by this listener to the connection engine */
+    HttpConnectionDispatcher *dispatcher = nullptr;
+
+    /** Additional acceptors on the same port, each with its own thread */
+    QList<HttpAcceptor*> acceptors;
+
+    /** Runtime counters, shared with the acceptors */
+    HttpServerMetrics metrics;
+
+    /** Limits of the client addresses, shared with the acceptors */
+    HttpClientLimiter limiter;
+
+    /** Removes idle clients from the limiter */
+    QTimer decayTimer;
+
+    /** Polls the number of connections while draining */
+    QTimer drainTimer;
 
 signals:
 
@@ -92,6 +210,9 @@ signals:
 
     void handleConnection(tSocketDescriptor socketDescriptor);
 
+    /** Emitted after drain() when all connections are closed */
+    void drained();
+
 };
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,158 @@
+#ifndef HTTPLOCKFREEQUEUE_HPP
+#define HTTPLOCKFREEQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "HttpGlobal.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Bounded lock-free multi-producer/multi-consumer queue (Dmitry Vyukov's algorithm).
+  <p>
+  Every slot carries a sequence number that tells producers and consumers whether the
+  slot is free or filled for their turn, so enqueue() and dequeue() need one compare-and-swap
+  on the shared position in the common case and never block. The capacity is rounded up to
+  the next power of two.
+  <p>
+  T should be cheap to copy, the queue is used for pointers.
+*/
+template <typename T>
+class HttpLockFreeQueue
+{
+    Q_DISABLE_COPY(HttpLockFreeQueue)
+
+public:
+
+    /**
+      Constructor.
+      @param capacity Maximum number of elements in the queue
+    */
+    explicit HttpLockFreeQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+
+        this->mask = size - 1;
+        this->cells.reset(new Cell[size]);
+
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            this->cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+      Append an element. This method is thread safe.
+      @return false if the queue is full
+    */
+    bool enqueue(const T &value)
+    {
+        std::size_t position = this->enqueuePosition.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        for (;;)
+        {
+            cell = &this->cells[position & this->mask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (diff == 0)
+            {
+                if (this->enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+
+            else if (diff < 0)
+            {
+                return false;
+            }
+
+            else
+            {
+                position = this->enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+      Remove the oldest element. This method is thread safe.
+      @return false if the queue is empty
+    */
+    bool dequeue(T &value)
+    {
+        std::size_t position = this->dequeuePosition.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        for (;;)
+        {
+            cell = &this->cells[position & this->mask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+            if (diff == 0)
+            {
+                if (this->dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+
+            else if (diff < 0)
+            {
+                return false;
+            }
+
+            else
+            {
+                position = this->dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = cell->data;
+        cell->sequence.store(position + this->mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Maximum number of elements */
+    std::size_t capacity() const
+    {
+        return this->mask + 1;
+    }
+
+private:
+
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    /** Ring of slots, the size is a power of two */
+    std::unique_ptr<Cell[]> cells;
+
+    /** Size of the ring minus one */
+    std::size_t mask = 0;
+
+    /** Next position to write, on its own cache line to avoid false sharing with the readers */
+    alignas(64) std::atomic<std::size_t> enqueuePosition{0};
+
+    /** Next position to read */
+    alignas(64) std::atomic<std::size_t> dequeuePosition{0};
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPLOCKFREEQUEUE_HPP
@@ -0,0 +1,271 @@
+#include "HttpMultipartParser.hpp"
+
+#include <string.h>
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+namespace {
+
+/** Get the quoted value of a parameter of a header line, e.g. name="value" */
+QByteArray headerParameter(const QByteArray &line, const QByteArray &name)
+{
+    const QByteArray key = name + "=\"";
+
+    for (int start = line.indexOf(key); start > 0; start = line.indexOf(key, start + 1))
+    {
+        // Only whole parameter names, "name" must not match "filename"
+        if (line.at(start - 1) != ' ' && line.at(start - 1) != ';')
+        {
+            continue;
+        }
+
+        const int end = line.indexOf('"', start + key.size());
+        if (end >= 0)
+        {
+            return line.mid(start + key.size(), end - start - key.size());
+        }
+    }
+
+    return QByteArray();
+}
+
+}
+
+HttpMultipartParser::HttpMultipartParser(const QByteArray &boundary, Handler *handler)
+{
+    Q_ASSERT(handler != nullptr);
+    this->handler = handler;
+    this->delimiter = "\r\n--" + boundary;
+
+    const int size = this->delimiter.size();
+    for (int &distance : this->skip)
+    {
+        distance = size;
+    }
+
+    for (int i = 0; i < size - 1; ++i)
+    {
+        this->skip[static_cast<uchar>(this->delimiter.at(i))] = size - 1 - i;
+    }
+
+    // The first delimiter may be at the very start of the body, without the line break
+    this->pendingSize = 2;
+}
+
+bool HttpMultipartParser::parse(const char *data, int size)
+{
+    int offset = 0;
+
+    while (offset < size && this->state != Failed)
+    {
+        const char c = data[offset];
+
+        switch (this->state)
+        {
+            case Preamble:
+            case PartData:
+                offset += this->parseData(data + offset, size - offset);
+                break;
+
+            case AfterDelimiter:
+                if (c == '-')
+                {
+                    this->state = FinalDelimiter;
+                }
+
+                else if (c == '\r')
+                {
+                    this->state = DelimiterLineEnd;
+                }
+
+                else if (c == '\n')
+                {
+                    this->state = PartHeaders;
+                }
+
+                // Transport padding
+                else if (c != ' ' && c != '\t')
+                {
+                    this->state = Failed;
+                }
+
+                ++offset;
+                break;
+
+            case FinalDelimiter:
+                this->state = c == '-' ? Epilogue : Failed;
+                ++offset;
+                break;
+
+            case DelimiterLineEnd:
+                this->state = c == '\n' ? PartHeaders : Failed;
+                ++offset;
+                break;
+
+            case PartHeaders:
+                offset += this->parseHeaders(data + offset, size - offset);
+                break;
+
+            default:
+                // The epilogue is ignored
+                return true;
+        }
+    }
+
+    return this->state != Failed;
+}
+
+bool HttpMultipartParser::isComplete() const
+{
+    return this->state == Epilogue;
+}
+
+int HttpMultipartParser::parseData(const char *data, int size)
+{
+    const int delimiterSize = this->delimiter.size();
+
+    // Continue a delimiter that has started at the end of the previous data
+    if (this->pendingSize > 0)
+    {
+        const int compareSize = qMin(delimiterSize - this->pendingSize, size);
+        if (memcmp(data, this->delimiter.constData() + this->pendingSize, static_cast<size_t>(compareSize)) == 0)
+        {
+            this->pendingSize += compareSize;
+            if (this->pendingSize == delimiterSize)
+            {
+                this->pendingSize = 0;
+                if (this->state == PartData)
+                {
+                    this->handler->partFinished();
+                }
+
+                this->state = AfterDelimiter;
+            }
+
+            return compareSize;
+        }
+
+        // The held back bytes are data. A boundary contains no CR, so no other delimiter can start in them.
+        this->emitData(this->delimiter.constData(), this->pendingSize);
+        this->pendingSize = 0;
+    }
+
+    const int found = this->findDelimiter(data, 0, size);
+    if (found >= 0)
+    {
+        this->emitData(data, found);
+        if (this->state == PartData)
+        {
+            this->handler->partFinished();
+        }
+
+        this->state = AfterDelimiter;
+        return found + delimiterSize;
+    }
+
+    // Hold back the end of the data if it may be the start of a delimiter
+    int dataSize = size;
+    for (int start = qMax(0, size - delimiterSize + 1); start < size; ++start)
+    {
+        if (data[start] == '\r' && memcmp(data + start, this->delimiter.constData(), static_cast<size_t>(size - start)) == 0)
+        {
+            this->pendingSize = size - start;
+            dataSize = start;
+            break;
+        }
+    }
+
+    this->emitData(data, dataSize);
+    return size;
+}
+
+int HttpMultipartParser::parseHeaders(const char *data, int size)
+{
+    const char *lineEnd = static_cast<const char*>(memchr(data, '\n', static_cast<size_t>(size)));
+    const int consumed = lineEnd ? static_cast<int>(lineEnd - data) + 1 : size;
+
+    this->headerSize += consumed;
+    if (this->headerSize > maxHeaderSize)
+    {
+        qWarning("HttpMultipartParser: headers of part are too large");
+        this->state = Failed;
+        return consumed;
+    }
+
+    this->headerLine.append(data, lineEnd ? consumed - 1 : size);
+    if (!lineEnd)
+    {
+        return consumed;
+    }
+
+    const QByteArray line = this->headerLine.trimmed();
+    this->headerLine.clear();
+
+    if (!line.isEmpty())
+    {
+        this->parseHeaderLine(line);
+        return consumed;
+    }
+
+    // An empty line ends the headers
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        qDebug("HttpMultipartParser: multipart field=%s, filename=%s", this->fieldName.constData(), this->fileName.constData());
+    #endif
+
+    this->handler->partStarted(this->fieldName, this->fileName);
+    this->fieldName.clear();
+    this->fileName.clear();
+    this->headerSize = 0;
+    this->state = PartData;
+    return consumed;
+}
+
+void HttpMultipartParser::parseHeaderLine(const QByteArray &line)
+{
+    static const char contentDisposition[] = "content-disposition:";
+    static const int contentDispositionSize = sizeof(contentDisposition) - 1;
+
+    if (line.size() < contentDispositionSize ||
+        qstrnicmp(line.constData(), contentDisposition, contentDispositionSize) != 0)
+    {
+        return;
+    }
+
+    if (!line.contains("form-data"))
+    {
+        qDebug("HttpMultipartParser: ignoring unsupported content part %s", line.constData());
+        return;
+    }
+
+    this->fieldName = headerParameter(line, "name");
+    this->fileName = headerParameter(line, "filename");
+}
+
+void HttpMultipartParser::emitData(const char *data, int size)
+{
+    if (this->state == PartData && size > 0)
+    {
+        this->handler->partData(data, size);
+    }
+}
+
+int HttpMultipartParser::findDelimiter(const char *data, int from, int to) const
+{
+    const char *pattern = this->delimiter.constData();
+    const int size = this->delimiter.size();
+
+    for (int position = from; position + size <= to; )
+    {
+        const uchar last = static_cast<uchar>(data[position + size - 1]);
+        if (last == static_cast<uchar>(pattern[size - 1]) && memcmp(data + position, pattern, static_cast<size_t>(size - 1)) == 0)
+        {
+            return position;
+        }
+
+        position += this->skip[last];
+    }
+
+    return -1;
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,128 @@
+#ifndef HTTPMULTIPARTPARSER_HPP
+#define HTTPMULTIPARTPARSER_HPP
+
+#include <QByteArray>
+
+#include "HttpGlobal.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Incremental parser for a multipart/form-data body.
+  <p>
+  The parser is fed with the body as it arrives and passes the parts to a Handler, which
+  writes each part once to its final destination. The delimiters between the parts are
+  found with a Boyer-Moore-Horspool search, which skips most bytes of the data without
+  looking at them. Only the last bytes of the received data are held back while they
+  might be the start of a delimiter.
+  <p>
+  Of the headers of a part, only the name and the file name of the Content-Disposition
+  are used. Parts without a name are passed with an empty name.
+*/
+
+class DECLSPEC HttpMultipartParser
+{
+    Q_DISABLE_COPY(HttpMultipartParser)
+
+public:
+
+    /** Receives the parts of the body */
+    class Handler
+    {
+    public:
+
+        virtual ~Handler() = default;
+
+        /**
+          A part starts.
+          @param fieldName Name of the form field
+          @param fileName Name of the uploaded file, empty if the part is a normal field
+        */
+        virtual void partStarted(const QByteArray &fieldName, const QByteArray &fileName) = 0;
+
+        /** Data of the current part, the buffer is only valid during the call */
+        virtual void partData(const char *data, int size) = 0;
+
+        /** The current part is complete */
+        virtual void partFinished() = 0;
+    };
+
+    /**
+      Constructor.
+      @param boundary Boundary from the Content-Type of the request
+      @param handler Receives the parts
+    */
+    HttpMultipartParser(const QByteArray &boundary, Handler *handler);
+
+    /**
+      Parse the next piece of the body.
+      @return false if the body is malformed
+    */
+    bool parse(const char *data, int size);
+
+    /** Returns true if the final delimiter has been received */
+    bool isComplete() const;
+
+private:
+
+    /** States of the parser */
+    enum State : quint8
+    {
+        Preamble = 0,
+        AfterDelimiter,
+        FinalDelimiter,
+        DelimiterLineEnd,
+        PartHeaders,
+        PartData,
+        Epilogue,
+        Failed
+    };
+
+    /** Maximum size of the headers of a part */
+    static const int maxHeaderSize = 65536;
+
+    /** Current state */
+    State state = Preamble;
+
+    /** CRLF, two dashes and the boundary */
+    QByteArray delimiter;
+
+    /** Distance to shift the search window for each byte value, for the Boyer-Moore-Horspool search */
+    int skip[256];
+
+    /** End of the received data that matches the start of the delimiter */
+    int pendingSize = 0;
+
+    /** Current header line of a part */
+    QByteArray headerLine;
+
+    /** Size of all header lines of the current part */
+    int headerSize = 0;
+
+    /** Name and file name of the current part */
+    QByteArray fieldName;
+    QByteArray fileName;
+
+    /** Receives the parts */
+    Handler *handler = nullptr;
+
+    /** Search the delimiter in the data of a part or in the preamble, returns the consumed bytes */
+    int parseData(const char *data, int size);
+
+    /** Collect the header lines of a part, returns the consumed bytes */
+    int parseHeaders(const char *data, int size);
+
+    /** Pass data of the current part to the handler, the preamble is dropped */
+    void emitData(const char *data, int size);
+
+    /** Position of the delimiter in the data, or -1 */
+    int findDelimiter(const char *data, int from, int to) const;
+
+    /** Evaluate a header line of a part */
+    void parseHeaderLine(const QByteArray &line);
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPMULTIPARTPARSER_HPP
@@ -0,0 +1,103 @@
+#include "HttpPendingQueue.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpPendingQueue::HttpPendingQueue(HttpServerSettings *settings, HttpServerMetrics *metrics)
+{
+    this->settings = settings;
+    this->metrics = metrics;
+}
+
+bool HttpPendingQueue::enqueue(tSocketDescriptor socketDescriptor)
+{
+    QMutexLocker locker(&this->mutex);
+
+    if (static_cast<quint32>(this->connections.size()) >= this->settings->maxPendingConnections)
+    {
+        return false;
+    }
+
+    PendingConnection connection;
+    connection.socketDescriptor = socketDescriptor;
+    connection.waitTimer.start();
+    this->connections.enqueue(connection);
+
+    this->count.ref();
+    this->metrics->addPendingConnection();
+    return true;
+}
+
+bool HttpPendingQueue::take(tSocketDescriptor &socketDescriptor)
+{
+    if (this->isEmpty())
+    {
+        return false;
+    }
+
+    QMutexLocker locker(&this->mutex);
+
+    if (this->connections.isEmpty())
+    {
+        return false;
+    }
+
+    PendingConnection connection = this->connections.dequeue();
+    socketDescriptor = connection.socketDescriptor;
+
+    this->count.deref();
+    this->metrics->removePendingConnection(static_cast<quint64>(connection.waitTimer.elapsed()), false);
+    return true;
+}
+
+QList<tSocketDescriptor> HttpPendingQueue::takeExpired()
+{
+    QList<tSocketDescriptor> expired;
+
+    if (this->isEmpty())
+    {
+        return expired;
+    }
+
+    QMutexLocker locker(&this->mutex);
+
+    // The queue is ordered by age, so only the head can be expired
+    while (!this->connections.isEmpty() && this->connections.head().waitTimer.hasExpired(this->settings->maxPendingTime))
+    {
+        PendingConnection connection = this->connections.dequeue();
+        expired.append(connection.socketDescriptor);
+
+        this->count.deref();
+        this->metrics->removePendingConnection(static_cast<quint64>(connection.waitTimer.elapsed()), true);
+    }
+
+    return expired;
+}
+
+QList<tSocketDescriptor> HttpPendingQueue::takeAll()
+{
+    QList<tSocketDescriptor> all;
+    QMutexLocker locker(&this->mutex);
+
+    while (!this->connections.isEmpty())
+    {
+        PendingConnection connection = this->connections.dequeue();
+        all.append(connection.socketDescriptor);
+
+        this->count.deref();
+        this->metrics->removePendingConnection(static_cast<quint64>(connection.waitTimer.elapsed()), false);
+    }
+
+    return all;
+}
+
+bool HttpPendingQueue::isEmpty() const
+{
+    return this->count.load() == 0;
+}
+
+int HttpPendingQueue::getCount() const
+{
+    return this->count.load();
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,107 @@
+#ifndef HTTPPENDINGQUEUE_HPP
+#define HTTPPENDINGQUEUE_HPP
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QQueue>
+
+#include "HttpGlobal.hpp"
+#include "HttpConnection.hpp"
+#include "HttpServerMetrics.hpp"
+#include "HttpServerSettings.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Bounded queue of accepted connections that wait for a free connection handler or worker.
+  <p>
+  Example for the configuration settings:
+  <code><pre>
+  maxPendingConnections=128
+  maxPendingTime=1000
+  </pre></code>
+  When all handlers or workers are busy, the dispatcher puts new connections into this queue
+  instead of rejecting them. Handlers and workers take the oldest connection as soon as they
+  become free. Connections that have waited longer than maxPendingTime milliseconds and
+  connections that do not fit into the queue are rejected with "503 Too Many Connections".
+  maxPendingConnections=0 disables the queue.
+  <p>
+  All methods are thread safe. isEmpty() does not lock, so it is cheap to call on every
+  release of a handler.
+  @see HttpServerMetrics for the queue depth and the waiting times
+*/
+
+class DECLSPEC HttpPendingQueue
+{
+    Q_DISABLE_COPY(HttpPendingQueue)
+
+public:
+
+    /**
+      Constructor.
+      @param settings Configuration settings for the HTTP server. Must not be 0.
+      @param metrics Receives the queue depth and waiting times. Must not be 0.
+    */
+    HttpPendingQueue(HttpServerSettings *settings, HttpServerMetrics *metrics);
+
+    /**
+      Add a connection to the end of the queue.
+      @param socketDescriptor references the accepted connection.
+      @return false if the queue is full or disabled.
+    */
+    bool enqueue(tSocketDescriptor socketDescriptor);
+
+    /**
+      Take the oldest connection from the queue.
+      @param socketDescriptor receives the connection
+      @return false if the queue is empty.
+    */
+    bool take(tSocketDescriptor &socketDescriptor);
+
+    /**
+      Remove all connections that have waited longer than maxPendingTime.
+      @return the expired connections, the caller must reject them.
+    */
+    QList<tSocketDescriptor> takeExpired();
+
+    /**
+      Remove all connections.
+      @return the connections, the caller must reject them.
+    */
+    QList<tSocketDescriptor> takeAll();
+
+    /** Returns true, if no connection is waiting. */
+    bool isEmpty() const;
+
+    /** Number of waiting connections */
+    int getCount() const;
+
+private:
+
+    struct PendingConnection {
+        tSocketDescriptor socketDescriptor;
+        QElapsedTimer waitTimer;
+    };
+
+    /** Configuration settings */
+    HttpServerSettings *settings = nullptr;
+
+    /** Receives the queue depth and waiting times */
+    HttpServerMetrics *metrics = nullptr;
+
+    /** The waiting connections, oldest first */
+    QQueue<PendingConnection> connections;
+
+    /** Number of waiting connections, readable without the lock */
+    QAtomicInt count;
+
+    /** Used to synchronize threads */
+    QMutex mutex;
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPPENDINGQUEUE_HPP
@@ -1,150 +1,211 @@
 #include "HttpRequest.hpp"
+#include "HttpChunkedDecoder.hpp"
 #include "HttpCookie.hpp"
+#include "HttpRequestHandler.hpp"
+#include "HttpScanner.hpp"
 
 #include <QList>
 #include <QDir>
 
+#include <string.h>
+
 QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
 
-HttpRequest::HttpRequest(HttpServerSettings *settings)
+namespace {
+
+/** Value of a hexadecimal digit, -1 for other characters */
+inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+}
+
+HttpRequest::HttpRequest(HttpServerSettings *settings, const QHostAddress &peerAddress, HttpRequestHandler *streamHandler, QObject *connection)
 {
     this->status = WaitForRequest;
     this->currentSize = 0;
     this->expectedBodySize = 0;
     this->maxSize = settings->maxRequestSize;
     this->maxMultiPartSize = settings->maxMultiPartSize;
+    this->peerAddress = peerAddress;
+    this->streamHandler = streamHandler;
+    this->connection = connection;
 }
 
-void HttpRequest::readRequest(QTcpSocket *socket)
+int HttpRequest::readHead(QByteArray &buffer)
 {
     #ifdef QTWEBAPP_SUPERVERBOSE
-        qDebug("HttpRequest: read request");
+        qDebug("HttpRequest: read head");
     #endif
 
-    int toRead = this->maxSize - this->currentSize + 1; // allow one byte more to be able to detect overflow
-    this->lineBuffer.append(socket->readLine(toRead));
-    this->currentSize += this->lineBuffer.size();
-
-    if (!this->lineBuffer.contains('\r') && !this->lineBuffer.contains('\n'))
+    switch (this->parser.parse(buffer, this->maxSize))
     {
-        #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: collecting more parts until line break");
-        #endif
+        case HttpRequestParser::Incomplete:
+            #ifdef QTWEBAPP_SUPERVERBOSE
+                qDebug("HttpRequest: collecting more parts until end of head");
+            #endif
 
-        return;
-    }
+            if (this->parser.hasRequestLine())
+            {
+                this->status = WaitForHeader;
+            }
 
-    QByteArray newData = this->lineBuffer.trimmed();
-    this->lineBuffer.clear();
+            return 0;
 
-    if (!newData.isEmpty())
-    {
-        QList<QByteArray> list = newData.split(' ');
-        if (list.count() != 3 || !list.at(2).contains("HTTP"))
-        {
-            qWarning("HttpRequest: received broken HTTP request, invalid first line");
+        case HttpRequestParser::Invalid:
+            qWarning("HttpRequest: received broken HTTP request");
             this->status = Abort;
-        }
+            return 0;
 
-        else
-        {
-            this->method = list.at(0).trimmed();
-            this->path = list.at(1);
-            this->version = list.at(2);
-            this->peerAddress = socket->peerAddress();
-            this->status = WaitForHeader;
-        }
+        case HttpRequestParser::TooLarge:
+            qWarning("HttpRequest: received too many bytes");
+            this->status = Abort;
+            return 0;
+
+        case HttpRequestParser::Complete:
+            break;
     }
-}
 
-void HttpRequest::readHeader(QTcpSocket *socket)
-{
-    #ifdef QTWEBAPP_SUPERVERBOSE
-        qDebug("HttpRequest: read header");
-    #endif
+    // The spans of the parser point into the buffer, which is shared instead of copied.
+    // If most of it is body already, only the head is copied, so that the body is not kept twice.
+    const int headSize = this->parser.getSize();
+    this->head = buffer.size() > 2 * headSize ? buffer.left(headSize) : buffer;
+    this->currentSize = headSize;
 
-    int toRead = this->maxSize - this->currentSize + 1; // allow one byte more to be able to detect overflow
-    this->lineBuffer.append(socket->readLine(toRead));
-    this->currentSize += this->lineBuffer.size();
+    this->method = HttpRequestParser::toByteArray(this->head, this->parser.getMethod());
 
-    if (!this->lineBuffer.contains('\r') && !this->lineBuffer.contains('\n'))
+    // The query is decoded on first access to the parameters
+    HttpHeaders::Span target = this->parser.getTarget();
+    const char *questionMark = static_cast<const char*>(memchr(this->head.constData() + target.offset, '?', static_cast<size_t>(target.size)));
+    if (questionMark)
     {
-        #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: collecting more parts until line break");
-        #endif
-
-        return;
+        const int pathSize = static_cast<int>(questionMark - this->head.constData()) - target.offset;
+        this->query = {target.offset + pathSize + 1, target.size - pathSize - 1};
+        target.size = pathSize;
     }
 
-    QByteArray newData = this->lineBuffer.trimmed();
-    this->lineBuffer.clear();
+    this->path = HttpRequestParser::toByteArray(this->head, target);
+    this->version = HttpRequestParser::toByteArray(this->head, this->parser.getVersion());
+    this->headers = this->parser.takeHeaders();
 
-    int colon = newData.indexOf(':');
-    if (colon > 0)
+    // Cookies are decoded on first access, like getHeaders() the last cookie header comes first
+    for (int i = this->headers.lastIndexOf(HttpHeaders::Cookie); i >= 0; --i)
     {
-        // Received a line with a colon - a header
-        this->currentHeader = newData.left(colon).toLower();
-        QByteArray value = newData.mid(colon + 1).trimmed();
-        this->headers.insert(this->currentHeader, value);
-
-        #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: received header %s: %s",currentHeader.data(),value.data());
-        #endif
+        if (this->headers.at(i).id == HttpHeaders::Cookie)
+        {
+            this->cookieHeaders.append(this->headers.at(i).value);
+        }
     }
 
-    else if (!newData.isEmpty())
-    {
-        // received another line - belongs to the previous header
-        #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: read additional line of header");
-        #endif
+    this->headers.remove(HttpHeaders::Cookie);
 
-        // Received additional line of previous header
-        if (this->headers.contains(currentHeader))
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        for (int i = 0; i < this->headers.size(); ++i)
         {
-            this->headers.insert(this->currentHeader, this->headers.value(this->currentHeader) + " " + newData);
+            const HttpHeaders::Field &field = this->headers.at(i);
+            qDebug("HttpRequest: received header %s: %s",
+                   HttpRequestParser::toByteArray(this->head, field.name).constData(),
+                   HttpRequestParser::toByteArray(this->head, field.value).constData());
         }
-    }
+    #endif
 
-    else
+    // Check for multipart/form-data
+    const QByteArray contentType = this->getHeaderView(HttpHeaders::ContentType);
+    if (contentType.startsWith("multipart/form-data"))
     {
-        // received an empty line - end of headers reached
-        #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: headers completed");
-        #endif
-
-        // Empty line received, that means all headers have been received
-        // Check for multipart/form-data
-        QByteArray contentType = this->headers.value("content-type");
-        if (contentType.startsWith("multipart/form-data"))
+        int posi = contentType.indexOf("boundary=");
+        if (posi >= 0)
         {
-            int posi = contentType.indexOf("boundary=");
-            if (posi >= 0)
+            this->boundary = contentType.mid(posi + 9);
+            if (this->boundary.startsWith('"') && this->boundary.endsWith('"'))
             {
-                this->boundary = contentType.mid(posi + 9);
-                if (this->boundary.startsWith('"') && this->boundary.endsWith('"'))
-                {
-                   this->boundary = this->boundary.mid(1, this->boundary.length() - 2);
-                }
+               this->boundary = this->boundary.mid(1, this->boundary.length() - 2);
             }
         }
+    }
 
-        QByteArray contentLength = headers.value("content-length");
-        if (!contentLength.isEmpty())
+    const QByteArray contentLength = this->getHeaderView(HttpHeaders::ContentLength);
+    if (!contentLength.isEmpty())
+    {
+        this->expectedBodySize = contentLength.toInt();
+    }
+
+    // A chunked body is decoded while it arrives, its size is not known in advance
+    if (this->headers.lastIndexOf(HttpHeaders::TransferEncoding) >= 0)
+    {
+        if (!this->isChunkedOnly())
         {
-            this->expectedBodySize = contentLength.toInt();
+            qWarning("HttpRequest: unsupported transfer encoding");
+            this->status = Abort;
         }
 
-        if (this->expectedBodySize == 0)
+        // Both headers are a request smuggling attempt or a broken client
+        else if (!contentLength.isEmpty())
+        {
+            qWarning("HttpRequest: received broken HTTP request, content length with chunked transfer encoding");
+            this->status = Abort;
+        }
+
+        else
         {
             #ifdef QTWEBAPP_SUPERVERBOSE
-                qDebug("HttpRequest: expect no body");
+                qDebug("HttpRequest: expect chunked body");
             #endif
 
-            this->status = Complete;
+            this->chunked = true;
+            this->status = WaitForBody;
         }
+    }
+
+    else if (this->expectedBodySize == 0)
+    {
+        #ifdef QTWEBAPP_SUPERVERBOSE
+            qDebug("HttpRequest: expect no body");
+        #endif
+
+        this->status = Complete;
+    }
+
+    else if (this->expectedBodySize < 0)
+    {
+        qWarning("HttpRequest: received broken HTTP request, invalid content length");
+        this->status = Abort;
+    }
 
-        else if (this->boundary.isEmpty() && this->expectedBodySize + this->currentSize > this->maxSize)
+    else
+    {
+        this->status = WaitForBody;
+    }
+
+    // The request handler may take the body while it arrives, then the body is not limited here
+    if (this->status == WaitForBody && this->streamHandler && this->streamHandler->streamBody(*this))
+    {
+        #ifdef QTWEBAPP_SUPERVERBOSE
+            qDebug("HttpRequest: stream body");
+        #endif
+
+        this->bodyStreamed = true;
+    }
+
+    else if (this->status == WaitForBody && !this->chunked)
+    {
+        if (this->boundary.isEmpty() && this->expectedBodySize + this->currentSize > this->maxSize)
         {
             qWarning("HttpRequest: expected body is too large");
             this->status = Abort;
@@ -155,124 +216,280 @@ void HttpRequest::readHeader(QTcpSocket *socket)
             qWarning("HttpRequest: expected multipart body is too large");
             this->status = Abort;
         }
+    }
 
-        else
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        if (this->status == WaitForBody && !this->chunked)
         {
-            #ifdef QTWEBAPP_SUPERVERBOSE
-                qDebug("HttpRequest: expect %i bytes body",expectedBodySize);
-            #endif
-
-            this->status = WaitForBody;
+            qDebug("HttpRequest: expect %i bytes body", this->expectedBodySize);
         }
-    }
+    #endif
+
+    return headSize;
 }
 
-void HttpRequest::readBody(QTcpSocket *socket)
+int HttpRequest::readBody(const QByteArray &buffer, int offset)
 {
-    Q_ASSERT(this->expectedBodySize != 0);
+    Q_ASSERT(this->chunked || this->expectedBodySize != 0);
 
-    if (this->boundary.isEmpty())
+    const int available = buffer.size() - offset;
+    if (available <= 0)
     {
-        // normal body, no multipart
-        #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: receive body");
-        #endif
+        return 0;
+    }
 
-        int toRead = this->expectedBodySize - this->bodyData.size();
-        QByteArray newData = socket->read(toRead);
-        this->currentSize += newData.size();
-        this->bodyData.append(newData);
+    if (this->chunked)
+    {
+        return this->readChunkedBody(buffer.constData() + offset, available);
+    }
 
-        if (this->bodyData.size() >= this->expectedBodySize)
-        {
-            this->status = Complete;
-        }
+    const int toRead = qMin(this->expectedBodySize - this->bodySize, available);
+    if (!this->bodyStreamed && this->boundary.isEmpty() && offset == 0 && toRead == buffer.size() && this->bodyData.isEmpty())
+    {
+        // The whole buffer is body, share it instead of copying
+        this->bodyData = buffer;
+        this->bodySize = toRead;
+        this->currentSize += toRead;
     }
 
     else
     {
-        // multipart body, store into temp file
-        #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: receiving multipart body");
-        #endif
+        this->writeBody(buffer.constData() + offset, toRead);
+    }
+
+    if (this->status == WaitForBody && this->bodySize >= this->expectedBodySize)
+    {
+        this->finishBody();
+    }
+
+    return toRead;
+}
+
+int HttpRequest::readChunkedBody(const char *data, int size)
+{
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        qDebug("HttpRequest: receive chunked body");
+    #endif
+
+    int offset = 0;
 
-        // Create an object for the temporary file, if not already present
-        if (!this->tempFile)
+    // A paused body stops after the current chunk, the rest stays in the buffer
+    while (offset < size && this->status == WaitForBody && !this->bodyPaused.loadAcquire())
+    {
+        int consumed = 0;
+        HttpHeaders::Span piece;
+        const HttpChunkedDecoder::Result result = this->chunkedDecoder.decode(data + offset, size - offset, consumed, piece);
+
+        // The chunk sizes and the trailer count like the head, unless the body is streamed
+        if (!this->bodyStreamed)
         {
-            this->tempFile = new QTemporaryFile;
+            this->currentSize += consumed - piece.size;
         }
 
-        if (!tempFile->isOpen())
+        if (piece.size > 0)
         {
-            tempFile->open();
+            this->writeBody(data + offset + piece.offset, piece.size);
         }
 
-        // Transfer data in 64kb blocks
-        int fileSize = this->tempFile->size();
-        int toRead = this->expectedBodySize - fileSize;
+        offset += consumed;
 
-        if (toRead > 65536)
+        if (result == HttpChunkedDecoder::Invalid)
         {
-            toRead = 65536;
+            qWarning("HttpRequest: received broken chunked body");
+            this->status = Abort;
         }
 
-        fileSize += this->tempFile->write(socket->read(toRead));
-        if (fileSize >= this->maxMultiPartSize)
+        else if (result == HttpChunkedDecoder::Complete && this->status == WaitForBody)
         {
-            qWarning("HttpRequest: received too many multipart bytes");
-            this->status = Abort;
+            this->finishBody();
         }
+    }
 
-        else if (fileSize >= this->expectedBodySize)
+    return offset;
+}
+
+void HttpRequest::writeBody(const char *data, int size)
+{
+    this->bodySize += size;
+
+    if (this->bodyStreamed)
+    {
+        // streamed body, passed on without copying
+        if (this->bodyCallback)
         {
+            this->bodyCallback(QByteArray::fromRawData(data, size), false);
+        }
+
+        return;
+    }
+
+    if (this->boundary.isEmpty())
+    {
+        // normal body, no multipart
         #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: received whole multipart body");
+            qDebug("HttpRequest: receive body");
         #endif
 
-            this->tempFile->flush();
-            if (this->tempFile->error())
-            {
-                qCritical("HttpRequest: Error writing temp file for multipart body");
-            }
+        // Check the limit before storing, a chunked body announces no size and may arrive in large pieces
+        if (this->currentSize + size > this->maxSize)
+        {
+            qWarning("HttpRequest: received too many bytes");
+            this->status = Abort;
+            return;
+        }
 
-            this->parseMultiPartFile();
-            this->tempFile->close();
-            this->status = Complete;
+        if (this->bodyData.isEmpty() && this->expectedBodySize > 0)
+        {
+            this->bodyData.reserve(this->expectedBodySize);
         }
+
+        this->bodyData.append(data, size);
+        this->currentSize += size;
+        return;
+    }
+
+    // multipart body, parsed while it arrives
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        qDebug("HttpRequest: receiving multipart body");
+    #endif
+
+    if (!this->multipartParser)
+    {
+        this->multipartParser = new HttpMultipartParser(this->boundary, this);
+    }
+
+    if (!this->multipartParser->parse(data, size))
+    {
+        qWarning("HttpRequest: received broken multipart body");
+        this->status = Abort;
+    }
+
+    else if (this->bodySize >= this->maxMultiPartSize)
+    {
+        qWarning("HttpRequest: received too many multipart bytes");
+        this->status = Abort;
     }
 }
 
-void HttpRequest::decodeRequestParams()
+void HttpRequest::finishBody()
 {
     #ifdef QTWEBAPP_SUPERVERBOSE
-        qDebug("HttpRequest: extract and decode request parameters");
+        if (this->multipartParser)
+        {
+            qDebug("HttpRequest: received whole multipart body");
+        }
     #endif
 
-    // Get URL parameters
-    QByteArray rawParameters;
-    int questionMark = this->path.indexOf('?');
-    if (questionMark >= 0)
+    // A multipart body that ends before its final delimiter is truncated or malformed
+    if (this->multipartParser && !this->multipartParser->isComplete())
     {
-        rawParameters = this->path.mid(questionMark + 1);
-        this->path = this->path.left(questionMark);
+        qWarning("HttpRequest: multipart body ends without the final boundary");
+        this->status = Abort;
+        return;
     }
 
+    this->status = Complete;
+
+    if (this->bodyStreamed && this->bodyCallback)
+    {
+        this->bodyCallback(QByteArray(), true);
+    }
+}
+
+void HttpRequest::partStarted(const QByteArray &fieldName, const QByteArray &fileName)
+{
+    this->partFieldName = fieldName;
+    this->partFileName = fileName;
+    this->partValue.clear();
+
+    if (!fieldName.isEmpty() && !fileName.isEmpty())
+    {
+        // this is a file, it is written directly into the uploaded file
+        this->partFile = new QTemporaryFile();
+        this->partFile->open();
+    }
+}
+
+void HttpRequest::partData(const char *data, int size)
+{
+    if (this->partFieldName.isEmpty())
+    {
+        return;
+    }
+
+    if (!this->partFile)
+    {
+        // this is a form field.
+        this->currentSize += size;
+        this->partValue.append(data, size);
+        return;
+    }
+
+    if (this->partFile->write(data, size) != size)
+    {
+        qCritical("HttpRequest: error writing temp file, %s", qUtf8Printable(this->partFile->errorString()));
+    }
+}
+
+void HttpRequest::partFinished()
+{
+    if (this->partFieldName.isEmpty())
+    {
+        return;
+    }
+
+    if (!this->partFile)
+    {
+        // last field was a form field
+        this->parameters.insert(this->partFieldName, this->partValue);
+        qDebug("HttpRequest: set parameter %s=%s", this->partFieldName.constData(), this->partValue.constData());
+        this->partValue.clear();
+        return;
+    }
+
+    // last field was a file
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        qDebug("HttpRequest: finishing writing to uploaded file");
+    #endif
+
+    this->partFile->flush();
+    this->partFile->seek(0);
+    this->parameters.insert(this->partFieldName, this->partFileName);
+    qDebug("HttpRequest: set parameter %s=%s", this->partFieldName.constData(), this->partFileName.constData());
+
+    // A file of an earlier part with the same name is replaced
+    delete this->uploadedFiles.value(this->partFieldName);
+    this->uploadedFiles.insert(this->partFieldName, this->partFile);
+    qDebug("HttpRequest: uploaded file size is %lli", this->partFile->size());
+    this->partFile = nullptr;
+}
+
+void HttpRequest::decodeParameters() const
+{
+    if (this->parametersDecoded)
+    {
+        return;
+    }
+
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        qDebug("HttpRequest: decode request parameters");
+    #endif
+
+    this->parametersDecoded = true;
+
+    // Get URL parameters
+    this->decodeParameterList(QByteArray::fromRawData(this->head.constData() + this->query.offset, this->query.size));
+
     // Get request body parameters
-    QByteArray contentType = this->headers.value("content-type");
+    const QByteArray contentType = this->getHeaderView(HttpHeaders::ContentType);
     if (!this->bodyData.isEmpty() && (contentType.isEmpty() || contentType.startsWith("application/x-www-form-urlencoded")))
     {
-        if (!rawParameters.isEmpty())
-        {
-            rawParameters.append('&');
-            rawParameters.append(this->bodyData);
-        }
-
-        else
-        {
-            rawParameters = this->bodyData;
-        }
+        this->decodeParameterList(this->bodyData);
     }
+}
 
+void HttpRequest::decodeParameterList(const QByteArray &rawParameters) const
+{
     // Split the parameters into pairs of value and name
     QList<QByteArray> list = rawParameters.split('&');
     for (auto&& part : list)
@@ -293,15 +510,22 @@ void HttpRequest::decodeRequestParams()
     }
 }
 
-void HttpRequest::extractCookies()
+void HttpRequest::decodeCookies() const
 {
+    if (this->cookiesDecoded)
+    {
+        return;
+    }
+
     #ifdef QTWEBAPP_SUPERVERBOSE
-        qDebug("HttpRequest: extract cookies");
+        qDebug("HttpRequest: decode cookies");
     #endif
 
-    for (const QByteArray &cookieStr : this->headers.values("cookie"))
+    this->cookiesDecoded = true;
+
+    for (const HttpHeaders::Span &cookieHeader : this->cookieHeaders)
     {
-        QList<QByteArray> list = HttpCookie::splitCSV(cookieStr);
+        QList<QByteArray> list = HttpCookie::splitCSV(HttpRequestParser::toByteArray(this->head, cookieHeader));
         for (auto&& part : list)
         {
             #ifdef QTWEBAPP_SUPERVERBOSE
@@ -328,26 +552,31 @@ void HttpRequest::extractCookies()
             this->cookies.insert(name, value);
         }
     }
-
-    this->headers.remove("cookie");
 }
 
-void HttpRequest::readFromSocket(QTcpSocket *socket)
+int HttpRequest::readFromBuffer(QByteArray &buffer)
 {
     Q_ASSERT(this->status != Complete);
 
+    int consumed = 0;
+
     switch (this->status)
     {
         case WaitForRequest:
-            this->readRequest(socket);
-            break;
-
         case WaitForHeader:
-            this->readHeader(socket);
-            break;
+            consumed = this->readHead(buffer);
+
+            // A streamed body waits until the request handler has set its callback
+            if (this->status != WaitForBody || this->bodyStreamed)
+            {
+                break;
+            }
+
+            // The rest of the buffer may contain the start of the body
+            // fall through
 
         case WaitForBody:
-            this->readBody(socket);
+            consumed += this->readBody(buffer, consumed);
             break;
 
         default: break;
@@ -360,13 +589,33 @@ void HttpRequest::readFromSocket(QTcpSocket *socket)
         this->status = Abort;
     }
 
-    if (this->status == Complete)
+    return consumed;
+}
+
+void HttpRequest::readFromSocket(QTcpSocket *socket)
+{
+    if (this->status == Complete || this->status == Abort)
+    {
+        return;
+    }
+
+    if (this->peerAddress.isNull())
     {
-        // Extract and decode request parameters from url and body
-        this->decodeRequestParams();
+        this->peerAddress = socket->peerAddress();
+    }
+
+    this->socketBuffer.append(socket->readAll());
+
+    const int consumed = this->readFromBuffer(this->socketBuffer);
+    if (consumed == this->socketBuffer.size())
+    {
+        this->socketBuffer.clear();
+    }
 
-        // Extract cookies from headers
-        this->extractCookies();
+    else if (consumed > 0)
+    {
+        // Only the rest is copied, the request may still share the consumed part
+        this->socketBuffer = this->socketBuffer.mid(consumed);
     }
 }
 
@@ -375,6 +624,17 @@ HttpRequest::RequestStatus HttpRequest::getStatus() const
     return this->status;
 }
 
+int HttpRequest::getReservedSize() const
+{
+    // The announced body is reserved before it arrives, a chunked body is not announced
+    if (this->status == WaitForBody && this->boundary.isEmpty() && !this->chunked && !this->bodyStreamed)
+    {
+        return this->currentSize - this->bodySize + this->expectedBodySize;
+    }
+
+    return this->currentSize;
+}
+
 QByteArray HttpRequest::getMethod() const
 {
     return this->method;
@@ -397,31 +657,107 @@ QByteArray HttpRequest::getVersion() const
 
 QByteArray HttpRequest::getHeader(const QByteArray &name) const
 {
-    return this->headers.value(name.toLower());
+    const int index = this->headers.lastIndexOf(this->head, name);
+    return index < 0 ? QByteArray() : HttpRequestParser::toByteArray(this->head, this->headers.at(index).value);
+}
+
+QByteArray HttpRequest::getHeader(HttpHeaders::Id id) const
+{
+    const int index = this->headers.lastIndexOf(id);
+    return index < 0 ? QByteArray() : HttpRequestParser::toByteArray(this->head, this->headers.at(index).value);
+}
+
+bool HttpRequest::hasHeaderValue(HttpHeaders::Id id, const char *value) const
+{
+    const int index = this->headers.lastIndexOf(id);
+    return index >= 0 && HttpRequestParser::equals(this->head, this->headers.at(index).value, QByteArray::fromRawData(value, static_cast<int>(qstrlen(value))));
+}
+
+bool HttpRequest::isChunkedOnly() const
+{
+    // All fields together form one list of codings, a single field may contain several of them
+    int codings = 0;
+    bool chunked = true;
+
+    for (int i = 0; i < this->headers.size(); ++i)
+    {
+        const HttpHeaders::Field &field = this->headers.at(i);
+        if (field.id != HttpHeaders::TransferEncoding)
+        {
+            continue;
+        }
+
+        for (const QByteArray &coding : HttpRequestParser::toByteArray(this->head, field.value).split(','))
+        {
+            const QByteArray trimmed = coding.trimmed();
+            if (!trimmed.isEmpty())
+            {
+                ++codings;
+                chunked = chunked && qstricmp(trimmed.constData(), "chunked") == 0;
+            }
+        }
+    }
+
+    return codings == 1 && chunked;
+}
+
+QByteArray HttpRequest::getHeaderView(HttpHeaders::Id id) const
+{
+    const int index = this->headers.lastIndexOf(id);
+    if (index < 0)
+    {
+        return QByteArray();
+    }
+
+    const HttpHeaders::Span &value = this->headers.at(index).value;
+    return QByteArray::fromRawData(this->head.constData() + value.offset, value.size);
 }
 
 QList<QByteArray> HttpRequest::getHeaders(const QByteArray &name) const
 {
-    return this->headers.values(name.toLower());
+    // The last one first, like QMultiMap::values()
+    QList<QByteArray> values;
+    for (int index = this->headers.lastIndexOf(this->head, name); index >= 0; index = this->headers.lastIndexOf(this->head, name, index))
+    {
+        values.append(HttpRequestParser::toByteArray(this->head, this->headers.at(index).value));
+    }
+
+    return values;
 }
 
 QMultiMap<QByteArray, QByteArray> HttpRequest::getHeaderMap() const
 {
-    return this->headers;
+    QMultiMap<QByteArray, QByteArray> map;
+    for (int i = 0; i < this->headers.size(); ++i)
+    {
+        const HttpHeaders::Field &field = this->headers.at(i);
+
+        // The lower-case names of well-known headers are static
+        const QByteArray name = field.id != HttpHeaders::Unknown ?
+            QByteArray::fromRawData(HttpHeaders::toName(field.id), static_cast<int>(qstrlen(HttpHeaders::toName(field.id)))) :
+            HttpRequestParser::toByteArray(this->head, field.name).toLower();
+
+        map.insert(name, HttpRequestParser::toByteArray(this->head, field.value));
+    }
+
+    return map;
 }
 
 QByteArray HttpRequest::getParameter(const QByteArray &name) const
 {
+    this->decodeParameters();
     return this->parameters.value(name);
 }
 
 QList<QByteArray> HttpRequest::getParameters(const QByteArray &name) const
 {
+    this->decodeParameters();
     return this->parameters.values(name);
 }
 
 QMultiMap<QByteArray, QByteArray> HttpRequest::getParameterMap() const
 {
+    this->decodeParameters();
     return this->parameters;
 }
 
@@ -430,165 +766,99 @@ QByteArray HttpRequest::getBody() const
     return this->bodyData;
 }
 
-QByteArray HttpRequest::urlDecode(const QByteArray &source)
+bool HttpRequest::isBodyStreamed() const
+{
+    return this->bodyStreamed;
+}
+
+void HttpRequest::setBodyCallback(const BodyCallback &callback)
 {
-    QByteArray buffer(source);
-    buffer.replace('+', ' ');
-    int percentChar = buffer.indexOf('%');
+    this->bodyCallback = callback;
+}
 
-    while (percentChar >= 0)
+void HttpRequest::pauseBody()
+{
+    if (this->bodyStreamed && this->status == WaitForBody)
     {
-        bool ok;
-        char byte = buffer.mid(percentChar + 1, 2).toInt(&ok, 16);
-        if (ok)
-        {
-            buffer.replace(percentChar, 3, static_cast<char*>(&byte), 1);
-        }
-        percentChar = buffer.indexOf('%', percentChar + 1);
+        this->bodyPaused.storeRelease(1);
     }
-
-    return buffer;
 }
 
-void HttpRequest::parseMultiPartFile()
+void HttpRequest::resumeBody()
 {
-    qDebug("HttpRequest: parsing multipart temp file");
-    this->tempFile->seek(0);
+    // Only the call that clears the flag resumes the connection
+    if (!this->bodyPaused.testAndSetOrdered(1, 0))
+    {
+        return;
+    }
 
-    bool finished = false;
-    while (!this->tempFile->atEnd() && !finished && !this->tempFile->error())
+    // The connection continues reading when it gets back to its event loop
+    if (this->connection)
     {
-        #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: reading multpart headers");
-        #endif
+        QMetaObject::invokeMethod(this->connection, "resumeStreamedBody", Qt::QueuedConnection);
+    }
+}
 
-        QByteArray fieldName;
-        QByteArray fileName;
+bool HttpRequest::isBodyPaused() const
+{
+    return this->bodyPaused.loadAcquire() != 0;
+}
 
-        while (!this->tempFile->atEnd() && !finished && !this->tempFile->error())
-        {
-            QByteArray line = this->tempFile->readLine(65536).trimmed();
-            if (line.startsWith("Content-Disposition:"))
-            {
-                if (line.contains("form-data"))
-                {
-                    int start = line.indexOf(" name=\"");
-                    int end = line.indexOf("\"", start + 7);
-
-                    if (start >= 0 && end >= start)
-                    {
-                        fieldName = line.mid(start + 7, end - start - 7);
-                    }
-
-                    start = line.indexOf(" filename=\"");
-                    end = line.indexOf("\"", start + 11);
-
-                    if (start >= 0 && end >= start)
-                    {
-                        fileName = line.mid(start + 11, end - start - 11);
-                    }
-
-                    #ifdef QTWEBAPP_SUPERVERBOSE
-                        qDebug("HttpRequest: multipart field=%s, filename=%s", fieldName.constData(), fileName.constData());
-                    #endif
-                }
-
-                else
-                {
-                    qDebug("HttpRequest: ignoring unsupported content part %s", line.constData());
-                }
-            }
+QByteArray HttpRequest::urlDecode(const QByteArray &source)
+{
+    // Without escapes, the source can be shared
+    if (HttpScanner::findUrlEscape(source.constData(), 0, source.size()) == source.size())
+    {
+        return source;
+    }
 
-            else if (line.isEmpty())
-            {
-                break;
-            }
-        }
+    QByteArray buffer(source.size(), Qt::Uninitialized);
+    buffer.truncate(urlDecode(source.constData(), source.size(), buffer.data()));
+    return buffer;
+}
 
-        #ifdef QTWEBAPP_SUPERVERBOSE
-            qDebug("HttpRequest: reading multpart data");
-        #endif
+int HttpRequest::urlDecode(const char *source, int size, char *target)
+{
+    int written = 0;
+    int i = 0;
 
-        QTemporaryFile *uploadedFile = nullptr;
-        QByteArray fieldValue;
+    while (i < size)
+    {
+        // Copy the characters up to the next escape at once
+        const int escape = HttpScanner::findUrlEscape(source, i, size);
+        memmove(target + written, source + i, static_cast<size_t>(escape - i));
+        written += escape - i;
+        i = escape;
 
-        while (!this->tempFile->atEnd() && !finished && !this->tempFile->error())
+        if (i == size)
         {
-            QByteArray line = this->tempFile->readLine(65536);
-            if (line.startsWith("--" + this->boundary))
-            {
-                // Boundary found. Until now we have collected 2 bytes too much,
-                // so remove them from the last result
-                if (fileName.isEmpty() && !fieldName.isEmpty())
-                {
-                    // last field was a form field
-                    fieldValue.remove(fieldValue.size() - 2, 2);
-                    this->parameters.insert(fieldName, fieldValue);
-
-                    qDebug("HttpRequest: set parameter %s=%s", fieldName.constData(), fieldValue.constData());
-                }
-
-                else if (!fileName.isEmpty() && !fieldName.isEmpty())
-                {
-                    // last field was a file
-                    #ifdef QTWEBAPP_SUPERVERBOSE
-                        qDebug("HttpRequest: finishing writing to uploaded file");
-                    #endif
-
-                    uploadedFile->resize(uploadedFile->size() - 2);
-                    uploadedFile->flush();
-                    uploadedFile->seek(0);
-                    this->parameters.insert(fieldName, fileName);
-                    qDebug("HttpRequest: set parameter %s=%s", fieldName.constData(), fileName.constData());
-                    this->uploadedFiles.insert(fieldName, uploadedFile);
-                    qDebug("HttpRequest: uploaded file size is %lli", uploadedFile->size());
-                }
-
-                if (line.contains(this->boundary + "--"))
-                {
-                    finished = true;
-                }
+            break;
+        }
 
-                break;
-            }
+        if (source[i] == '+')
+        {
+            target[written++] = ' ';
+            ++i;
+            continue;
+        }
 
-            else
-            {
-                if (fileName.isEmpty() && !fieldName.isEmpty())
-                {
-                    // this is a form field.
-                    this->currentSize += line.size();
-                    fieldValue.append(line);
-                }
-
-                else if (!fileName.isEmpty() && !fieldName.isEmpty())
-                {
-                    // this is a file
-                    if (!uploadedFile)
-                    {
-                        uploadedFile = new QTemporaryFile();
-                        uploadedFile->open();
-                    }
-
-                    uploadedFile->write(line);
-
-                    if (uploadedFile->error())
-                    {
-                        qCritical("HttpRequest: error writing temp file, %s", qUtf8Printable(uploadedFile->errorString()));
-                    }
-                }
-            }
+        const int high = i + 2 < size ? hexValue(source[i + 1]) : -1;
+        const int low = i + 2 < size ? hexValue(source[i + 2]) : -1;
+
+        if (high >= 0 && low >= 0)
+        {
+            target[written++] = static_cast<char>(high << 4 | low);
+            i += 3;
         }
-    }
 
-    if (this->tempFile->error())
-    {
-        qCritical("HttpRequest: cannot read temp file, %s", qUtf8Printable(this->tempFile->errorString()));
+        else
+        {
+            target[written++] = '%';
+            ++i;
+        }
     }
 
-    #ifdef QTWEBAPP_SUPERVERBOSE
-        qDebug("HttpRequest: finished parsing multipart temp file");
-    #endif
+    return written;
 }
 
 HttpRequest::~HttpRequest()
@@ -605,15 +875,9 @@ HttpRequest::~HttpRequest()
         delete file;
     }
 
-    if (this->tempFile)
-    {
-        if (this->tempFile->isOpen())
-        {
-            this->tempFile->close();
-        }
-
-        delete tempFile;
-    }
+    // An upload that has not been finished
+    delete this->partFile;
+    delete this->multipartParser;
 }
 
 QTemporaryFile *HttpRequest::getUploadedFile(const QByteArray &fieldName) const
@@ -623,12 +887,14 @@ QTemporaryFile *HttpRequest::getUploadedFile(const QByteArray &fieldName) const
 
 QByteArray HttpRequest::getCookie(const QByteArray &name) const
 {
+    this->decodeCookies();
     return this->cookies.value(name);
 }
 
 /** Get the map of cookies */
 QMap<QByteArray, QByteArray> &HttpRequest::getCookieMap()
 {
+    this->decodeCookies();
     return this->cookies;
 }
 
@@ -1,6 +1,9 @@
 #ifndef HTTPREQUEST_HPP
 #define HTTPREQUEST_HPP
 
+#include <functional>
+
+#include <QAtomicInt>
 #include <QByteArray>
 #include <QHostAddress>
 #include <QTcpSocket>
@@ -8,16 +11,28 @@
 #include <QMultiMap>
 #include <QTemporaryFile>
 #include <QUuid>
+#include <QVarLengthArray>
 
+#include "HttpChunkedDecoder.hpp"
 #include "HttpGlobal.hpp"
+#include "HttpHeaders.hpp"
+#include "HttpMultipartParser.hpp"
+#include "HttpRequestParser.hpp"
 #include "HttpServerSettings.hpp"
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
 
+class HttpRequestHandler;
+
 /**
-  This object represents a single HTTP request. It reads the request
-  from a TCP socket and provides getters for the individual parts
-  of the request.
+  This object represents a single HTTP request. It takes the request
+  from the receive buffer of the connection and provides getters for
+  the individual parts of the request.
+  <p>
+  The head of the request is parsed by a HttpRequestParser without
+  copying, the request keeps the received bytes and the getters copy
+  only the parts that they return. Parameters and cookies are decoded
+  on first access, so requests that do not use them do not pay for it.
   <p>
   The follwing config settings are required:
   <code><pre>
@@ -29,9 +44,20 @@ QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
   multipart/form-data requests (also known as file-upload), the maximum
   size of the body must not exceed maxMultiPartSize.
   The body is always a little larger than the file itself.
+  <p>
+  Bodies with "Transfer-Encoding: chunked" are decoded while they arrive,
+  and the limits are checked against the decoded size as it grows.
+  Any other transfer coding, also in a further Transfer-Encoding field,
+  and a Content-Length next to it abort the request.
+  <p>
+  A request handler can take the body while it arrives instead, see
+  HttpRequestHandler::streamBody(). Such a body is passed to the callback
+  of setBodyCallback() piece by piece and is neither stored nor limited
+  by maxRequestSize or maxMultiPartSize, so the memory of the request
+  stays the same for any size of the body.
 */
 
-class DECLSPEC HttpRequest
+class DECLSPEC HttpRequest : private HttpMultipartParser::Handler
 {
     Q_DISABLE_COPY(HttpRequest)
     friend class HttpSessionStore;
@@ -50,18 +76,39 @@ public:
     /**
       Constructor.
       @param settings Configuration settings
+      @param peerAddress Address of the client
+      @param streamHandler Is asked whether the body is streamed, may be `nullptr`
+      @param connection Receives a queued call of resumeStreamedBody() from resumeBody(), may be `nullptr`
     */
-    HttpRequest(HttpServerSettings *settings);
+    HttpRequest(HttpServerSettings *settings, const QHostAddress &peerAddress = QHostAddress(),
+                HttpRequestHandler *streamHandler = nullptr, QObject *connection = nullptr);
 
     /**
       Destructor.
     */
     virtual ~HttpRequest();
 
+    /**
+      Read the HTTP request from the receive buffer of the connection.
+      This method is called by the connection handler whenever data has
+      been received, until the status is RequestStatus::complete or
+      RequestStatus::abort.
+      <p>
+      The buffer must start with the data that has not been consumed by
+      the previous call. Bytes that follow the request, e.g. a pipelined
+      request, are not consumed.
+      @param buffer Received data, folded header lines are modified in place.
+      @return Number of bytes at the start of the buffer that have been consumed
+    */
+    int readFromBuffer(QByteArray &buffer);
+
     /**
       Read the HTTP request from a socket.
-      This method is called by the connection handler repeatedly
-      until the status is RequestStatus::complete or RequestStatus::abort.
+      This method is kept for code that reads requests without a HttpConnection,
+      it passes all available data of the socket to readFromBuffer(). Data that
+      follows the request, e.g. a pipelined request, is read from the socket but
+      not used, so use readFromBuffer() with your own buffer to support pipelining.
+      If the request has been constructed without a peer address, it is taken from the socket.
       @param socket Source of the data
     */
     void readFromSocket(QTcpSocket *socket);
@@ -72,6 +119,13 @@ public:
     */
     RequestStatus getStatus() const;
 
+    /**
+      Get the number of bytes that this request holds in memory, or will hold when its body
+      has been received completely. Uploaded files of multipart bodies are not included, they
+      are written to temporary files.
+    */
+    int getReservedSize() const;
+
     /** Get the method of the HTTP request  (e.g. "GET") */
     QByteArray getMethod() const;
 
@@ -92,6 +146,24 @@ public:
     */
     QByteArray getHeader(const QByteArray &name) const;
 
+    /**
+      Get the value of a well-known HTTP request header, which is faster
+      than looking it up by name.
+      @param id Id of the header
+      @return If the header occurs multiple times, only the last
+      one is returned.
+    */
+    QByteArray getHeader(HttpHeaders::Id id) const;
+
+    /**
+      Compare the value of a well-known HTTP request header without
+      copying it.
+      @param id Id of the header
+      @param value Expected value, not case-sensitive
+      @return true if the last header with this id has the value
+    */
+    bool hasHeaderValue(HttpHeaders::Id id, const char *value) const;
+
     /**
       Get the values of a HTTP request header.
       @param name Name of the header, not case-senitive.
@@ -124,6 +196,44 @@ public:
     /** Get the HTTP request body.  */
     QByteArray getBody() const;
 
+    /**
+      Receives a streamed body.
+      @param data Next piece of the body, only valid during the call
+      @param lastPart Set in the last call, which has no data
+    */
+    typedef std::function<void(const QByteArray &data, bool lastPart)> BodyCallback;
+
+    /**
+      Returns true if the body is passed to a callback while it arrives, instead of being
+      stored for getBody(). Parameters and uploaded files of such a body are not decoded.
+      @see HttpRequestHandler::streamBody()
+    */
+    bool isBodyStreamed() const;
+
+    /**
+      Set the function that receives a streamed body, usually in HttpRequestHandler::service().
+      The function is called in the thread of the connection. Without a callback, the
+      body is skipped.
+    */
+    void setBodyCallback(const BodyCallback &callback);
+
+    /**
+      Stop passing the streamed body to the callback, e.g. while the consumer is busy.
+      The connection stops reading, so TCP flow control slows the client down.
+      Must be called in the thread of the connection, for example in the callback.
+    */
+    void pauseBody();
+
+    /**
+      Continue a streamed body after pauseBody(). This method is thread safe, so a consumer in
+      another thread can resume the body when it has caught up. The request must still exist,
+      which is the case until the response has been completed.
+    */
+    void resumeBody();
+
+    /** Returns true while the streamed body is paused */
+    bool isBodyPaused() const;
+
     /**
       Decode an URL parameter.
       E.g. replace "%23" by '#' and replace '+' by ' '.
@@ -132,6 +242,16 @@ public:
     */
     static QByteArray urlDecode(const QByteArray &source);
 
+    /**
+      Decode an URL parameter into a buffer in one pass, without allocating memory.
+      Invalid escapes are copied unchanged.
+      @param source The url encoded string
+      @param size Size of the source in bytes
+      @param target Buffer of at least size bytes, may be the same as source to decode in place
+      @return Size of the decoded string
+    */
+    static int urlDecode(const char *source, int size, char *target);
+
     /**
       Get an uploaded file. The file is already open. It will
       be closed and deleted by the destructor of this HttpRequest
@@ -160,17 +280,35 @@ public:
 
 private:
 
-    /** Request headers */
-    QMultiMap<QByteArray, QByteArray> headers;
+    /** Received head of the request, which may be followed by other data */
+    QByteArray head;
+
+    /** Parser for the head */
+    HttpRequestParser parser;
+
+    /** Request headers, as spans into the head */
+    HttpHeaders headers;
+
+    /** Parameters of the request, decoded on first access */
+    mutable QMultiMap<QByteArray, QByteArray> parameters;
 
-    /** Parameters of the request */
-    QMultiMap<QByteArray, QByteArray> parameters;
+    /** Whether the query and the body have been decoded into the parameters */
+    mutable bool parametersDecoded = false;
+
+    /** Query of the URL in the head, without the question mark */
+    HttpHeaders::Span query = {0, 0};
 
     /** Uploaded files of the request, key is the field name. */
     QMap<QByteArray, QTemporaryFile*> uploadedFiles;
 
-    /** Received cookies */
-    QMap<QByteArray, QByteArray> cookies;
+    /** Received cookies, decoded on first access */
+    mutable QMap<QByteArray, QByteArray> cookies;
+
+    /** Whether the cookie headers have been decoded */
+    mutable bool cookiesDecoded = false;
+
+    /** Values of the cookie headers in the head, the last one first */
+    QVarLengthArray<HttpHeaders::Span, 2> cookieHeaders;
 
     /** Storage for raw body data */
     QByteArray bodyData;
@@ -193,6 +331,9 @@ private:
     /** Address of the connected peer. */
     QHostAddress peerAddress;
 
+    /** Data that readFromSocket() has read and readFromBuffer() has not consumed yet */
+    QByteArray socketBuffer;
+
     /** Maximum size of requests in bytes. */
     int maxSize;
 
@@ -202,38 +343,83 @@ private:
     /** Current size */
     int currentSize;
 
-    /** Expected size of body */
+    /** Expected size of body, 0 for a chunked body */
     int expectedBodySize;
 
-    /** Name of the current header, or empty if no header is being processed */
-    QByteArray currentHeader;
+    /** Size of the body that has been received so far, after decoding */
+    int bodySize = 0;
+
+    /** Whether the body has "Transfer-Encoding: chunked" */
+    bool chunked = false;
+
+    /** Is asked whether the body is streamed */
+    HttpRequestHandler *streamHandler = nullptr;
+
+    /** Connection that is resumed by resumeBody() */
+    QObject *connection = nullptr;
+
+    /** Whether the body is passed to bodyCallback instead of being stored */
+    bool bodyStreamed = false;
+
+    /** Set by pauseBody(), cleared by resumeBody() in any thread */
+    QAtomicInt bodyPaused;
+
+    /** Receives a streamed body */
+    BodyCallback bodyCallback;
+
+    /** Decoder for a chunked body */
+    HttpChunkedDecoder chunkedDecoder;
 
     /** Boundary of multipart/form-data body. Empty if there is no such header */
     QByteArray boundary;
 
-    /** Temp file, that is used to store the multipart/form-data body */
-    QTemporaryFile *tempFile = nullptr;
+    /** Parser for a multipart/form-data body, created when the body starts */
+    HttpMultipartParser *multipartParser = nullptr;
+
+    /** Name and file name of the current part of a multipart body */
+    QByteArray partFieldName;
+    QByteArray partFileName;
+
+    /** Value of the current part, if it is a form field */
+    QByteArray partValue;
+
+    /** File of the current part, if it is an upload */
+    QTemporaryFile *partFile = nullptr;
+
+    /** Implementation of HttpMultipartParser::Handler */
+    void partStarted(const QByteArray &fieldName, const QByteArray &fileName);
+    void partData(const char *data, int size);
+    void partFinished();
+
+    /** Sub-procedure of readFromBuffer(), parse the request line and the headers. Returns the consumed bytes. */
+    int readHead(QByteArray &buffer);
+
+    /** Sub-procedure of readFromBuffer(), read the request body after offset. Returns the consumed bytes. */
+    int readBody(const QByteArray &buffer, int offset);
+
+    /** Sub-procedure of readBody(), decode a chunked body. Returns the consumed bytes. */
+    int readChunkedBody(const char *data, int size);
 
-    /** Parse the multipart body, that has been stored in the temp file. */
-    void parseMultiPartFile();
+    /** Store a piece of the body in bodyData, pass it to the multipart parser or to the body callback */
+    void writeBody(const char *data, int size);
 
-    /** Sub-procedure of readFromSocket(), read the first line of a request. */
-    void readRequest(QTcpSocket *socket);
+    /** Called when the whole body has been received */
+    void finishBody();
 
-    /** Sub-procedure of readFromSocket(), read header lines. */
-    void readHeader(QTcpSocket *socket);
+    /** Whether the Transfer-Encoding fields together name exactly one coding, "chunked" */
+    bool isChunkedOnly() const;
 
-    /** Sub-procedure of readFromSocket(), read the request body. */
-    void readBody(QTcpSocket *socket);
+    /** Value of a well-known header that refers to the head, it must not outlive this request */
+    QByteArray getHeaderView(HttpHeaders::Id id) const;
 
-    /** Sub-procedure of readFromSocket(), extract and decode request parameters. */
-    void decodeRequestParams();
+    /** Decode the parameters from the query and the body, if not done yet */
+    void decodeParameters() const;
 
-    /** Sub-procedure of readFromSocket(), extract cookies from headers */
-    void extractCookies();
+    /** Sub-procedure of decodeParameters(), decode a list of URL encoded parameters */
+    void decodeParameterList(const QByteArray &rawParameters) const;
 
-    /** Buffer for collecting characters of request and header lines */
-    QByteArray lineBuffer;
+    /** Decode the cookies from the cookie headers, if not done yet */
+    void decodeCookies() const;
 
 };
 
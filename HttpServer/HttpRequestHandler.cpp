@@ -20,4 +20,10 @@ void HttpRequestHandler::service(HttpRequest &request, HttpResponse &response)
     response.write("501 Not Implemented", true);
 }
 
+bool HttpRequestHandler::streamBody(const HttpRequest &request)
+{
+    Q_UNUSED(request)
+    return false;
+}
+
 QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -38,11 +38,44 @@ public:
     /**
       Generate a response for an incoming HTTP request.
       @param request The received HTTP request
-      @param response Must be used to return the response
+      @param response Must be used to return the response, or HttpResponse::defer() to return it later
       @warning This method must be thread safe
     */
     virtual void service(HttpRequest &request, HttpResponse &response);
 
+    /**
+      Decide whether the body of a request is streamed. Called when the head of a request with
+      a body has been received, the default implementation returns false.
+      <p>
+      For a streamed body, service() is called before the body has been read. It sets a
+      callback with HttpRequest::setBodyCallback(), which receives the body while it arrives,
+      and defers the response until the callback has received the last part:
+      <code><pre>
+        bool MyHandler::streamBody(const HttpRequest &request)
+        {
+            return request.getPath() == "/import";
+        }
+
+        void MyHandler::service(HttpRequest &request, HttpResponse &response)
+        {
+            HttpDeferredResponse deferred = response.defer();
+            QSharedPointer<Importer> importer(new Importer);
+
+            request.setBodyCallback([deferred, importer](const QByteArray &data, bool lastPart) mutable {
+                importer->add(data);
+                if (lastPart)
+                    deferred.write(importer->result(), true);
+            });
+        }
+      </pre></code>
+      The callback can slow the client down with HttpRequest::pauseBody(), a consumer in another
+      thread may call HttpRequest::resumeBody() when it is ready for more data. If the response
+      is completed before the whole body has been received, the connection is closed.
+      @param request The request, only the head is available
+      @warning This method must be thread safe
+    */
+    virtual bool streamBody(const HttpRequest &request);
+
 };
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_END
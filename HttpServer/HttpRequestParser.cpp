@@ -0,0 +1,349 @@
+#include "HttpRequestParser.hpp"
+#include "HttpScanner.hpp"
+
+#include <string.h>
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+namespace {
+
+/** Returns true for the characters of a token (RFC 7230 section 3.2.6), which are used in methods and field names */
+inline bool isTokenChar(char c)
+{
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+    {
+        return true;
+    }
+
+    switch (c)
+    {
+        case '!': case '#': case '$': case '%': case '&': case '\'': case '*': case '+':
+        case '-': case '.': case '^': case '_': case '`': case '|': case '~':
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+inline bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+}
+
+HttpRequestParser::HttpRequestParser()
+{
+}
+
+void HttpRequestParser::reset()
+{
+    this->state = RequestLineStart;
+    this->position = 0;
+    this->size = 0;
+    this->method = {0, 0};
+    this->target = {0, 0};
+    this->version = {0, 0};
+    this->nameOffset = 0;
+    this->nameHash = 0;
+    this->headers.clear();
+}
+
+HttpRequestParser::Result HttpRequestParser::parse(QByteArray &buffer, int maxSize)
+{
+    if (this->state == Done)
+    {
+        return Complete;
+    }
+
+    if (this->state == Failed)
+    {
+        return Invalid;
+    }
+
+    // Bytes beyond the maximum size are not looked at, they cannot belong to a valid head
+    const int end = qMin(buffer.size(), maxSize);
+    const char *data = buffer.constData();
+    int i = this->position;
+
+    while (i < end)
+    {
+        switch (this->state)
+        {
+            case RequestLineStart:
+                // Ignore empty lines before the request line
+                while (i < end && (data[i] == '\r' || data[i] == '\n'))
+                {
+                    ++i;
+                }
+
+                if (i == end)
+                {
+                    break;
+                }
+
+                this->method.offset = i;
+                this->state = Method;
+                // fall through
+
+            case Method:
+                while (i < end && isTokenChar(data[i]))
+                {
+                    ++i;
+                }
+
+                if (i == end)
+                {
+                    break;
+                }
+
+                if (data[i] != ' ' || i == this->method.offset)
+                {
+                    return this->fail();
+                }
+
+                this->method.size = i - this->method.offset;
+                this->target.offset = ++i;
+                this->state = Target;
+                // fall through
+
+            case Target:
+                i = HttpScanner::findTargetEnd(data, i, end);
+
+                if (i == end)
+                {
+                    break;
+                }
+
+                if (data[i] != ' ' || i == this->target.offset)
+                {
+                    return this->fail();
+                }
+
+                this->target.size = i - this->target.offset;
+                this->version.offset = ++i;
+                this->state = Version;
+                // fall through
+
+            case Version:
+                i = HttpScanner::findLineEnd(data, i, end);
+
+                if (i == end)
+                {
+                    break;
+                }
+
+                this->version.size = i - this->version.offset;
+                while (this->version.size > 0 && isWhitespace(data[this->version.offset + this->version.size - 1]))
+                {
+                    --this->version.size;
+                }
+
+                if (this->version.size < 6 || qstrncmp(data + this->version.offset, "HTTP/", 5) != 0 ||
+                    memchr(data + this->version.offset, ' ', static_cast<size_t>(this->version.size)) != nullptr)
+                {
+                    return this->fail();
+                }
+
+                this->state = data[i++] == '\r' ? RequestLineEnd : FieldStart;
+                break;
+
+            case RequestLineEnd:
+            case FieldLineEnd:
+                if (data[i] != '\n')
+                {
+                    return this->fail();
+                }
+
+                ++i;
+                this->state = FieldStart;
+                break;
+
+            case FieldStart:
+                if (data[i] == '\n')
+                {
+                    return this->finish(i + 1);
+                }
+
+                if (data[i] == '\r')
+                {
+                    ++i;
+                    this->state = HeadEnd;
+                    break;
+                }
+
+                if (isWhitespace(data[i]))
+                {
+                    // Obsolete line folding continues the value of the previous field
+                    if (this->headers.size() == 0)
+                    {
+                        return this->fail();
+                    }
+
+                    Field &field = this->headers.last();
+                    char *mutableData = buffer.data();
+                    for (int j = field.value.offset + field.value.size; j < i; ++j)
+                    {
+                        mutableData[j] = ' ';
+                    }
+
+                    data = mutableData;
+                    this->state = field.value.size == 0 ? FieldValueStart : FieldValue;
+                    break;
+                }
+
+                this->nameOffset = i;
+                this->nameHash = 0;
+                this->state = FieldName;
+                // fall through
+
+            case FieldName:
+            {
+                while (i < end && isTokenChar(data[i]))
+                {
+                    this->nameHash = HttpHeaders::hash(this->nameHash, data[i]);
+                    ++i;
+                }
+
+                if (i == end)
+                {
+                    break;
+                }
+
+                // Whitespace between the name and the colon is not allowed
+                if (data[i] != ':' || i == this->nameOffset)
+                {
+                    return this->fail();
+                }
+
+                const int nameSize = i - this->nameOffset;
+                const HttpHeaders::Id id = HttpHeaders::toId(data + this->nameOffset, nameSize, this->nameHash);
+                this->headers.append(Field{{this->nameOffset, nameSize}, {i + 1, 0}, id});
+                ++i;
+                this->state = FieldValueStart;
+            }
+            // fall through
+
+            case FieldValueStart:
+                while (i < end && isWhitespace(data[i]))
+                {
+                    ++i;
+                }
+
+                if (i == end)
+                {
+                    break;
+                }
+
+                this->headers.last().value.offset = i;
+                this->state = FieldValue;
+                // fall through
+
+            case FieldValue:
+            {
+                i = HttpScanner::findLineEnd(data, i, end);
+
+                if (i == end)
+                {
+                    break;
+                }
+
+                Span &value = this->headers.last().value;
+                value.size = i - value.offset;
+                while (value.size > 0 && isWhitespace(data[value.offset + value.size - 1]))
+                {
+                    --value.size;
+                }
+
+                this->state = data[i++] == '\r' ? FieldLineEnd : FieldStart;
+                break;
+            }
+
+            case HeadEnd:
+                if (data[i] != '\n')
+                {
+                    return this->fail();
+                }
+
+                return this->finish(i + 1);
+
+            default:
+                break;
+        }
+    }
+
+    this->position = i;
+
+    if (buffer.size() > maxSize)
+    {
+        this->state = Failed;
+        return TooLarge;
+    }
+
+    return Incomplete;
+}
+
+HttpRequestParser::Result HttpRequestParser::finish(int end)
+{
+    this->position = end;
+    this->size = end;
+    this->state = Done;
+    return Complete;
+}
+
+HttpRequestParser::Result HttpRequestParser::fail()
+{
+    this->state = Failed;
+    return Invalid;
+}
+
+bool HttpRequestParser::hasRequestLine() const
+{
+    return this->state >= RequestLineEnd && this->state != Failed;
+}
+
+int HttpRequestParser::getSize() const
+{
+    return this->size;
+}
+
+const HttpRequestParser::Span &HttpRequestParser::getMethod() const
+{
+    return this->method;
+}
+
+const HttpRequestParser::Span &HttpRequestParser::getTarget() const
+{
+    return this->target;
+}
+
+const HttpRequestParser::Span &HttpRequestParser::getVersion() const
+{
+    return this->version;
+}
+
+const HttpHeaders &HttpRequestParser::getHeaders() const
+{
+    return this->headers;
+}
+
+HttpHeaders HttpRequestParser::takeHeaders()
+{
+    HttpHeaders result = this->headers;
+    this->headers.clear();
+    return result;
+}
+
+QByteArray HttpRequestParser::toByteArray(const QByteArray &buffer, const Span &span)
+{
+    return QByteArray(buffer.constData() + span.offset, span.size);
+}
+
+bool HttpRequestParser::equals(const QByteArray &buffer, const Span &span, const QByteArray &string)
+{
+    return span.size == string.size() &&
+           qstrnicmp(buffer.constData() + span.offset, string.constData(), static_cast<uint>(span.size)) == 0;
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
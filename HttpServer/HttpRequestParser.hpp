@@ -0,0 +1,140 @@
+#ifndef HTTPREQUESTPARSER_HPP
+#define HTTPREQUESTPARSER_HPP
+
+#include <QByteArray>
+
+#include "HttpGlobal.hpp"
+#include "HttpHeaders.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Incremental parser for the head of a HTTP/1.1 request, which consists of the request line
+  and the header fields.
+  <p>
+  The parser works directly on the receive buffer of the connection and copies nothing: method,
+  target, version and the names and values of the header fields are recorded as spans (offset
+  and size) into the buffer. When more data has been appended to the buffer, parse() continues
+  where it stopped, so each byte is looked at once, no matter how the head is split into packets.
+  <p>
+  Lines may end with CRLF or LF, and empty lines before the request line are ignored. Obsolete
+  line folding is replaced by spaces in the buffer, so that a folded value is still one span.
+  Values are trimmed of leading and trailing whitespace, names are kept as received and
+  resolved to a HttpHeaders::Id with a hash that is computed while they are scanned.
+  <p>
+  The target and the values, which make up most of a head, are scanned with the SIMD
+  kernels of HttpScanner.
+*/
+
+class DECLSPEC HttpRequestParser
+{
+public:
+
+    /** Part of the buffer */
+    typedef HttpHeaders::Span Span;
+
+    /** Header field */
+    typedef HttpHeaders::Field Field;
+
+    /** Return values of parse() */
+    enum Result : quint8
+    {
+        Incomplete = 0, // more data is needed
+        Complete,       // the head is complete, see getSize()
+        Invalid,        // the head is malformed
+        TooLarge        // the head exceeds the maximum size
+    };
+
+    /** Constructor */
+    HttpRequestParser();
+
+    /**
+      Continue parsing. The buffer must contain the same data as in the previous call,
+      optionally followed by more data.
+      @param buffer Receive buffer, starting with the request. Folded lines are modified.
+      @param maxSize Maximum size of the head in bytes
+    */
+    Result parse(QByteArray &buffer, int maxSize);
+
+    /** Start again with a new request */
+    void reset();
+
+    /** Returns true if the request line has been parsed */
+    bool hasRequestLine() const;
+
+    /** Size of the head in bytes, including the empty line at its end */
+    int getSize() const;
+
+    /** Request method */
+    const Span &getMethod() const;
+
+    /** Request target, which is the path and the query */
+    const Span &getTarget() const;
+
+    /** Protocol version, e.g. "HTTP/1.1" */
+    const Span &getVersion() const;
+
+    /** Header fields in the order of the request */
+    const HttpHeaders &getHeaders() const;
+
+    /** Take the header fields, the parser must be reset before it is used again */
+    HttpHeaders takeHeaders();
+
+    /** Copy a span into a new byte array */
+    static QByteArray toByteArray(const QByteArray &buffer, const Span &span);
+
+    /** Compare a span with a string, ignoring the case of ASCII letters */
+    static bool equals(const QByteArray &buffer, const Span &span, const QByteArray &string);
+
+private:
+
+    /** States of the parser */
+    enum State : quint8
+    {
+        RequestLineStart = 0,
+        Method,
+        Target,
+        Version,
+        RequestLineEnd,
+        FieldStart,
+        FieldName,
+        FieldValueStart,
+        FieldValue,
+        FieldLineEnd,
+        HeadEnd,
+        Done,
+        Failed
+    };
+
+    /** Finish the head, which ends before the given position */
+    Result finish(int end);
+
+    /** Stop parsing a malformed head */
+    Result fail();
+
+    /** Current state */
+    State state = RequestLineStart;
+
+    /** Position of the next byte to look at */
+    int position = 0;
+
+    /** Size of the complete head */
+    int size = 0;
+
+    /** Parts of the request line */
+    Span method = {0, 0};
+    Span target = {0, 0};
+    Span version = {0, 0};
+
+    /** Start and hash of the name of the current field */
+    int nameOffset = 0;
+    uint nameHash = 0;
+
+    /** Header fields */
+    HttpHeaders headers;
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPREQUESTPARSER_HPP
@@ -1,15 +1,39 @@
 #include "HttpResponse.hpp"
+#include "HttpSocketOptions.hpp"
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
 
-HttpResponse::HttpResponse(QTcpSocket *socket)
+HttpResponse::HttpResponse(QTcpSocket *socket, QObject *connection, const HttpServerSettings *settings)
 {
+    const HttpServerSettings defaults;
+    if (!settings)
+    {
+        settings = &defaults;
+    }
+
     this->socket = socket;
+    this->connection = connection;
     this->statusCode = 200;
     this->statusText = "OK";
     this->sentHeaders = false;
     this->sentLastPart = false;
     this->chunkedMode = false;
+    // Corking is part of the socket option profile of a listener, a socket of the application is left alone
+    this->cork = (settings != &defaults) && settings->tcpCork;
+    this->corked = false;
+    this->highWatermark = static_cast<qint64>(settings->writeHighWatermark);
+    this->lowWatermark = qMin(static_cast<qint64>(settings->writeLowWatermark), this->highWatermark);
+    this->writeTimeout = settings->writeTimeout ? static_cast<int>(settings->writeTimeout) : -1;
+}
+
+HttpResponse::~HttpResponse()
+{
+    this->deferred.detach();
+
+    if (this->corked)
+    {
+        HttpSocketOptions::setCorked(this->socket->socketDescriptor(), false);
+    }
 }
 
 void HttpResponse::setHeader(const QByteArray &name, const QByteArray &value)
@@ -77,10 +101,37 @@ bool HttpResponse::writeToSocket(QByteArray data)
 
     while (this->socket->isOpen() && remaining > 0)
     {
-        // If the output buffer has become large, then wait until it has been sent.
-        if (this->socket->bytesToWrite() > 16384)
+        // If the output buffer has become large, then wait until most of it has been sent.
+        // Deferred responses are written by the event loop of the connection, which must not block.
+        if (this->socket->bytesToWrite() > this->highWatermark && !this->isDeferred())
         {
-            this->socket->waitForBytesWritten(-1);
+            // The timeout applies while the client makes no progress, like the write timeout of the connection
+            this->writeTimer.start();
+            qint64 pending = this->socket->bytesToWrite();
+
+            while (pending > this->lowWatermark)
+            {
+                int timeout = -1;
+                if (this->writeTimeout >= 0)
+                {
+                    timeout = qMax(this->writeTimeout - static_cast<int>(this->writeTimer.elapsed()), 0);
+                }
+
+                if (timeout == 0 || !this->socket->waitForBytesWritten(timeout))
+                {
+                    qWarning("HttpResponse: client does not receive, closing the connection");
+                    this->socket->abort();
+                    return false;
+                }
+
+                // Any progress restarts the timeout
+                if (this->socket->bytesToWrite() < pending)
+                {
+                    this->writeTimer.restart();
+                }
+
+                pending = this->socket->bytesToWrite();
+            }
         }
 
         int written = this->socket->write(ptr, remaining);
@@ -93,6 +144,12 @@ bool HttpResponse::writeToSocket(QByteArray data)
         remaining -= written;
     }
 
+    // Let the connection watch for progress, a client that does not receive at all emits no signal
+    if (this->connection && this->isDeferred() && this->socket->bytesToWrite() > this->lowWatermark)
+    {
+        QMetaObject::invokeMethod(this->connection, "watchWrites", Qt::DirectConnection);
+    }
+
     return true;
 }
 
@@ -100,6 +157,12 @@ void HttpResponse::write(const QByteArray &data, bool lastPart)
 {
     Q_ASSERT(!this->sentLastPart);
 
+    // Hold back partial segments until the response is flushed
+    if (this->cork && !this->corked && this->socket->isOpen())
+    {
+        this->corked = HttpSocketOptions::setCorked(this->socket->socketDescriptor(), true);
+    }
+
     // Send HTTP headers, if not already done (that happens only on the first call to write())
     if (!this->sentHeaders)
     {
@@ -155,7 +218,7 @@ void HttpResponse::write(const QByteArray &data, bool lastPart)
             this->writeToSocket("0\n\n");
         }
 
-        this->socket->flush();
+        this->flush();
         this->sentLastPart = true;
     }
 }
@@ -190,6 +253,12 @@ void HttpResponse::redirect(const QByteArray &url)
 void HttpResponse::flush()
 {
     this->socket->flush();
+
+    if (this->corked)
+    {
+        HttpSocketOptions::setCorked(this->socket->socketDescriptor(), false);
+        this->corked = false;
+    }
 }
 
 bool HttpResponse::isConnected() const
@@ -197,4 +266,40 @@ bool HttpResponse::isConnected() const
     return this->socket->isOpen();
 }
 
+HttpDeferredResponse HttpResponse::defer()
+{
+    if (this->deferred.isNull())
+    {
+        if (!this->connection)
+        {
+            qWarning("HttpResponse: deferred responses are not supported here");
+            return HttpDeferredResponse();
+        }
+
+        this->deferred = HttpDeferredResponse(this->connection, this->highWatermark, this->lowWatermark);
+    }
+
+    return this->deferred;
+}
+
+bool HttpResponse::isDeferred() const
+{
+    return !this->deferred.isNull();
+}
+
+bool HttpResponse::isWritable() const
+{
+    return this->socket->bytesToWrite() <= this->highWatermark;
+}
+
+void HttpResponse::applyDeferred()
+{
+    this->deferred.apply(*this);
+}
+
+void HttpResponse::updateBackpressure()
+{
+    this->deferred.setPendingBytes(this->socket->bytesToWrite());
+}
+
 QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -1,12 +1,15 @@
 #ifndef HTTPRESPONSE_HPP
 #define HTTPRESPONSE_HPP
 
+#include <QElapsedTimer>
 #include <QMap>
 #include <QString>
 #include <QTcpSocket>
 
 #include "HttpGlobal.hpp"
 #include "HttpCookie.hpp"
+#include "HttpDeferredResponse.hpp"
+#include "HttpServerSettings.hpp"
 
 QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
 
@@ -27,6 +30,20 @@ QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
   <p>
   In case of large responses (e.g. file downloads), a Content-Length header should be set
   before calling write(). Web Browsers use that information to display a progress bar.
+  <p>
+  A request handler that has to wait for something else can call defer() and complete
+  the response later from any thread, see HttpDeferredResponse.
+  <p>
+  The output is buffered. While service() is running, write() waits when more than
+  writeHighWatermark bytes are pending until the client has received all but writeLowWatermark
+  of them, so a fast producer is slowed down to the speed of the client. If the client receives
+  nothing for writeTimeout milliseconds, the connection is closed and isConnected() returns false.
+  A client that receives steadily is never aborted, however long the response takes.
+  <p>
+  While write() waits, the thread cannot serve anything else. With the EventLoop engine the thread
+  serves many other connections, so handlers that produce large output should call defer() and
+  write whenever isWritable() returns true, instead of relying on the timeout.
+  Deferred responses never wait, producers should check isWritable() instead.
 */
 
 class DECLSPEC HttpResponse
@@ -38,8 +55,15 @@ public:
     /**
       Constructor.
       @param socket used to write the response
+      @param connection Object in the thread of the socket that completes deferred responses,
+             defer() is not available if `nullptr`
+      @param settings Socket options, watermarks and write timeout. If `nullptr`, the defaults are used
+             but the socket is never corked.
     */
-    HttpResponse(QTcpSocket *socket);
+    HttpResponse(QTcpSocket *socket, QObject *connection = nullptr, const HttpServerSettings *settings = nullptr);
+
+    /** Destructor, disconnects a deferred response and uncorks the socket */
+    ~HttpResponse();
 
     /**
       Set a HTTP response header.
@@ -106,7 +130,7 @@ public:
     void redirect(const QByteArray &url);
 
     /**
-     * Flush the output buffer (of the underlying socket).
+     * Flush the output buffer (of the underlying socket) and uncork it.
      * You normally don't need to call this method because flush is
      * automatically called after HttpRequestHandler::service() returns.
      */
@@ -118,8 +142,31 @@ public:
      */
     bool isConnected() const;
 
+    /**
+      Complete this response after HttpRequestHandler::service() has returned.
+      The response must then be written through the returned handle only, the
+      connection does not finalize it when service() returns.
+      @return a thread safe handle, or a null handle if deferring is not supported
+    */
+    HttpDeferredResponse defer();
+
+    /** Indicates whether defer() has been called */
+    bool isDeferred() const;
+
+    /** Returns false while more than writeHighWatermark bytes wait to be sent */
+    bool isWritable() const;
+
+    /** Write the data that has been passed to the deferred handle, called in the thread of the socket */
+    void applyDeferred();
+
+    /** Update the writability of the deferred handle, called in the thread of the socket when data has been sent */
+    void updateBackpressure();
+
 private:
 
+    friend class HttpDeferredResponse;
+    friend class HttpCoroutineHandler;
+
     /** Request headers */
     QMap<QByteArray, QByteArray> headers;
 
@@ -138,13 +185,37 @@ private:
     /** Indicator whether the body has been sent completely */
     bool sentLastPart;
 
+    /** Whether the socket shall be corked while writing */
+    bool cork;
+
+    /** Pending output above which write() waits, see HttpServerSettings::writeHighWatermark */
+    qint64 highWatermark;
+
+    /** Pending output at which write() continues */
+    qint64 lowWatermark;
+
+    /** Maximum time that write() may wait without progress of the client, -1 = forever */
+    int writeTimeout;
+
+    /** Time since the client has made progress while write() waits */
+    QElapsedTimer writeTimer;
+
+    /** Whether the socket is corked now */
+    bool corked;
+
     /** Whether the response is sent in chunked mode */
     bool chunkedMode;
 
     /** Cookies */
     QMap<QByteArray, HttpCookie> cookies;
 
-    /** Write raw data to the socket. This method blocks until all bytes have been passed to the TCP buffer */
+    /** Receives the completion of a deferred response */
+    QObject *connection = nullptr;
+
+    /** Handle that has been returned by defer(), null if not deferred */
+    HttpDeferredResponse deferred;
+
+    /** Write raw data to the socket. Blocks above the high watermark, unless the response is deferred. */
     bool writeToSocket(QByteArray data);
 
     /**
@@ -0,0 +1,210 @@
+#include "HttpScanner.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define QTWEBAPP_SCANNER_SSE2
+    #include <emmintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+#if defined(QTWEBAPP_SCANNER_SSE2) && defined(__GNUC__)
+    #define QTWEBAPP_SCANNER_AVX2
+    #include <immintrin.h>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+namespace {
+
+typedef int (*FindEitherFunction)(const char *data, int from, int to, char first, char second);
+typedef int (*ScanFunction)(const char *data, int from, int to);
+
+/** Space, control characters and DEL end the target, bytes above 127 are allowed */
+inline bool isTargetEnd(char c)
+{
+    return static_cast<uchar>(c) <= ' ' || c == 0x7f;
+}
+
+int findEitherScalar(const char *data, int from, int to, char first, char second)
+{
+    while (from < to && data[from] != first && data[from] != second)
+    {
+        ++from;
+    }
+
+    return from;
+}
+
+int findTargetEndScalar(const char *data, int from, int to)
+{
+    while (from < to && !isTargetEnd(data[from]))
+    {
+        ++from;
+    }
+
+    return from;
+}
+
+#ifdef QTWEBAPP_SCANNER_SSE2
+
+/** Index of the lowest set bit, the mask must not be 0 */
+inline int lowestBit(unsigned mask)
+{
+    #ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+    #else
+        return __builtin_ctz(mask);
+    #endif
+}
+
+int findEitherSse2(const char *data, int from, int to, char first, char second)
+{
+    const __m128i firstBytes = _mm_set1_epi8(first);
+    const __m128i secondBytes = _mm_set1_epi8(second);
+
+    for (; from + 16 <= to; from += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, firstBytes), _mm_cmpeq_epi8(bytes, secondBytes))));
+
+        if (mask)
+        {
+            return from + lowestBit(mask);
+        }
+    }
+
+    return findEitherScalar(data, from, to, first, second);
+}
+
+int findTargetEndSse2(const char *data, int from, int to)
+{
+    // The comparison is signed, bytes above 127 are negative and must not match
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i limit = _mm_set1_epi8(' ' + 1);
+    const __m128i del = _mm_set1_epi8(0x7f);
+
+    for (; from + 16 <= to; from += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+        const __m128i control = _mm_andnot_si128(_mm_cmplt_epi8(bytes, zero), _mm_cmplt_epi8(bytes, limit));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(control, _mm_cmpeq_epi8(bytes, del))));
+
+        if (mask)
+        {
+            return from + lowestBit(mask);
+        }
+    }
+
+    return findTargetEndScalar(data, from, to);
+}
+
+#endif
+
+#ifdef QTWEBAPP_SCANNER_AVX2
+
+__attribute__((target("avx2")))
+int findEitherAvx2(const char *data, int from, int to, char first, char second)
+{
+    const __m256i firstBytes = _mm256_set1_epi8(first);
+    const __m256i secondBytes = _mm256_set1_epi8(second);
+
+    for (; from + 32 <= to; from += 32)
+    {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + from));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, firstBytes), _mm256_cmpeq_epi8(bytes, secondBytes))));
+
+        if (mask)
+        {
+            return from + lowestBit(mask);
+        }
+    }
+
+    return findEitherSse2(data, from, to, first, second);
+}
+
+__attribute__((target("avx2")))
+int findTargetEndAvx2(const char *data, int from, int to)
+{
+    // The comparison is signed, bytes above 127 are negative and must not match
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i limit = _mm256_set1_epi8(' ' + 1);
+    const __m256i del = _mm256_set1_epi8(0x7f);
+
+    for (; from + 32 <= to; from += 32)
+    {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + from));
+        const __m256i control = _mm256_andnot_si256(_mm256_cmpgt_epi8(zero, bytes), _mm256_cmpgt_epi8(limit, bytes));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(control, _mm256_cmpeq_epi8(bytes, del))));
+
+        if (mask)
+        {
+            return from + lowestBit(mask);
+        }
+    }
+
+    return findTargetEndSse2(data, from, to);
+}
+
+#endif
+
+/** Kernels for the CPU, selected once */
+struct Kernels
+{
+    HttpScanner::InstructionSet instructionSet = HttpScanner::Scalar;
+    FindEitherFunction findEither = findEitherScalar;
+    ScanFunction findTargetEnd = findTargetEndScalar;
+
+    Kernels()
+    {
+        #if defined(QTWEBAPP_SCANNER_AVX2)
+            if (__builtin_cpu_supports("avx2"))
+            {
+                this->instructionSet = HttpScanner::AVX2;
+                this->findEither = findEitherAvx2;
+                this->findTargetEnd = findTargetEndAvx2;
+                return;
+            }
+        #endif
+
+        #if defined(QTWEBAPP_SCANNER_SSE2)
+            this->instructionSet = HttpScanner::SSE2;
+            this->findEither = findEitherSse2;
+            this->findTargetEnd = findTargetEndSse2;
+        #endif
+    }
+};
+
+const Kernels &kernels()
+{
+    static const Kernels instance;
+    return instance;
+}
+
+}
+
+int HttpScanner::findLineEnd(const char *data, int from, int to)
+{
+    return kernels().findEither(data, from, to, '\r', '\n');
+}
+
+int HttpScanner::findUrlEscape(const char *data, int from, int to)
+{
+    return kernels().findEither(data, from, to, '%', '+');
+}
+
+int HttpScanner::findTargetEnd(const char *data, int from, int to)
+{
+    return kernels().findTargetEnd(data, from, to);
+}
+
+HttpScanner::InstructionSet HttpScanner::getInstructionSet()
+{
+    return kernels().instructionSet;
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,56 @@
+#ifndef HTTPSCANNER_HPP
+#define HTTPSCANNER_HPP
+
+#include "HttpGlobal.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Vectorized search for the delimiters of the HTTP request head, used by HttpRequestParser
+  for the long parts of a request: the target and the values of the header fields. The URL
+  decoder of HttpRequest uses it to skip the characters that need no decoding.
+  <p>
+  Each function compares 32 bytes at once with AVX2 or 16 bytes with SSE2, the rest and
+  all other platforms are scanned byte by byte. The AVX2 kernels are selected at runtime
+  when the CPU supports them, which requires GCC or Clang. Otherwise SSE2 is used on x86,
+  which every x86-64 CPU supports.
+*/
+
+class DECLSPEC HttpScanner
+{
+public:
+
+    /** Instruction sets of the kernels */
+    enum InstructionSet : quint8
+    {
+        Scalar = 0,
+        SSE2,
+        AVX2
+    };
+
+    /**
+      Find the end of a line.
+      @return Position of the first CR or LF between from and to, or to if there is none
+    */
+    static int findLineEnd(const char *data, int from, int to);
+
+    /**
+      Find the end of the request target.
+      @return Position of the first space or control character between from and to, or to if there is none
+    */
+    static int findTargetEnd(const char *data, int from, int to);
+
+    /**
+      Find the next character that must be URL decoded.
+      @return Position of the first '%' or '+' between from and to, or to if there is none
+    */
+    static int findUrlEscape(const char *data, int from, int to);
+
+    /** The instruction set that has been selected for this CPU */
+    static InstructionSet getInstructionSet();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPSCANNER_HPP
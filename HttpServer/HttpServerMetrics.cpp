@@ -0,0 +1,223 @@
+#include "HttpServerMetrics.hpp"
+#include "HttpThreadPlacement.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpServerMetrics::HttpServerMetrics()
+    : acceptedConnections(0),
+      rejectedConnections(0),
+      cappedConnections(0),
+      throttledConnections(0),
+      pendingConnections(0),
+      queuedConnections(0),
+      expiredConnections(0),
+      pendingWaitTime(0),
+      maxPendingWaitTime(0),
+      bufferedBytes(0),
+      shedRequests(0),
+      throttledRequests(0),
+      localConnections(0),
+      remoteConnections(0)
+{
+}
+
+quint64 HttpServerMetrics::getAcceptedConnections() const
+{
+    return this->acceptedConnections.load();
+}
+
+quint64 HttpServerMetrics::getRejectedConnections() const
+{
+    return this->rejectedConnections.load();
+}
+
+quint64 HttpServerMetrics::getCappedConnections() const
+{
+    return this->cappedConnections.load();
+}
+
+quint64 HttpServerMetrics::getThrottledConnections() const
+{
+    return this->throttledConnections.load();
+}
+
+quint64 HttpServerMetrics::getPendingConnections() const
+{
+    return this->pendingConnections.load();
+}
+
+quint64 HttpServerMetrics::getQueuedConnections() const
+{
+    return this->queuedConnections.load();
+}
+
+quint64 HttpServerMetrics::getExpiredConnections() const
+{
+    return this->expiredConnections.load();
+}
+
+quint64 HttpServerMetrics::getPendingWaitTime() const
+{
+    return this->pendingWaitTime.load();
+}
+
+quint64 HttpServerMetrics::getMaxPendingWaitTime() const
+{
+    return this->maxPendingWaitTime.load();
+}
+
+quint64 HttpServerMetrics::getBufferedBytes() const
+{
+    return this->bufferedBytes.load();
+}
+
+quint64 HttpServerMetrics::getShedRequests() const
+{
+    return this->shedRequests.load();
+}
+
+quint64 HttpServerMetrics::getThrottledRequests() const
+{
+    return this->throttledRequests.load();
+}
+
+quint64 HttpServerMetrics::getLocalConnections() const
+{
+    return this->localConnections.load();
+}
+
+quint64 HttpServerMetrics::getRemoteConnections() const
+{
+    return this->remoteConnections.load();
+}
+
+QVariantList HttpServerMetrics::getThreads() const
+{
+    QMutexLocker locker(&this->mutex);
+    QVariantList list;
+
+    for (const ThreadPlacement &placement : this->threads)
+    {
+        QVariantList cpus;
+        for (int cpu : placement.cpus)
+        {
+            cpus.append(cpu);
+        }
+
+        QVariantMap entry;
+        entry.insert("role", QString::fromLatin1(placement.role));
+        entry.insert("cpus", cpus);
+        entry.insert("node", placement.node);
+        entry.insert("startCpu", placement.startCpu);
+        list.append(entry);
+    }
+
+    return list;
+}
+
+QVariantMap HttpServerMetrics::toVariantMap() const
+{
+    QVariantMap map;
+    map.insert("acceptedConnections", this->getAcceptedConnections());
+    map.insert("rejectedConnections", this->getRejectedConnections());
+    map.insert("cappedConnections", this->getCappedConnections());
+    map.insert("throttledConnections", this->getThrottledConnections());
+    map.insert("pendingConnections", this->getPendingConnections());
+    map.insert("queuedConnections", this->getQueuedConnections());
+    map.insert("expiredConnections", this->getExpiredConnections());
+    map.insert("pendingWaitTime", this->getPendingWaitTime());
+    map.insert("maxPendingWaitTime", this->getMaxPendingWaitTime());
+    map.insert("bufferedBytes", this->getBufferedBytes());
+    map.insert("shedRequests", this->getShedRequests());
+    map.insert("throttledRequests", this->getThrottledRequests());
+    map.insert("localConnections", this->getLocalConnections());
+    map.insert("remoteConnections", this->getRemoteConnections());
+    map.insert("threads", this->getThreads());
+    return map;
+}
+
+void HttpServerMetrics::addAcceptedConnection()
+{
+    this->acceptedConnections.ref();
+}
+
+void HttpServerMetrics::addRejectedConnection()
+{
+    this->rejectedConnections.ref();
+}
+
+void HttpServerMetrics::addCappedConnection()
+{
+    this->cappedConnections.ref();
+}
+
+void HttpServerMetrics::addThrottledConnection()
+{
+    this->throttledConnections.ref();
+}
+
+void HttpServerMetrics::addPendingConnection()
+{
+    this->pendingConnections.ref();
+    this->queuedConnections.ref();
+}
+
+void HttpServerMetrics::removePendingConnection(quint64 waitTime, bool expired)
+{
+    this->pendingConnections.deref();
+    this->pendingWaitTime.fetchAndAddRelaxed(waitTime);
+
+    if (expired)
+    {
+        this->expiredConnections.ref();
+    }
+
+    // Raise the maximum, unless another thread has raised it even more in the meantime
+    quint64 maxWaitTime = this->maxPendingWaitTime.load();
+    while (waitTime > maxWaitTime && !this->maxPendingWaitTime.testAndSetOrdered(maxWaitTime, waitTime, maxWaitTime))
+    {
+    }
+}
+
+quint64 HttpServerMetrics::addBufferedBytes(qint64 delta)
+{
+    // Unsigned arithmetic wraps, so adding the two's complement subtracts
+    return this->bufferedBytes.fetchAndAddRelaxed(static_cast<quint64>(delta)) + static_cast<quint64>(delta);
+}
+
+void HttpServerMetrics::addShedRequest()
+{
+    this->shedRequests.ref();
+}
+
+void HttpServerMetrics::addThrottledRequest()
+{
+    this->throttledRequests.ref();
+}
+
+void HttpServerMetrics::addPlacedConnection(bool local)
+{
+    if (local)
+    {
+        this->localConnections.ref();
+    }
+
+    else
+    {
+        this->remoteConnections.ref();
+    }
+}
+
+void HttpServerMetrics::registerThread(const char *role, const void *thread, const QList<int> &cpus, int node)
+{
+    QMutexLocker locker(&this->mutex);
+    this->threads.insert(thread, ThreadPlacement{role, cpus, node, HttpThreadPlacement::getCurrentCpu()});
+}
+
+void HttpServerMetrics::unregisterThread(const void *thread)
+{
+    QMutexLocker locker(&this->mutex);
+    this->threads.remove(thread);
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,172 @@
+#ifndef HTTPSERVERMETRICS_HPP
+#define HTTPSERVERMETRICS_HPP
+
+#include <QAtomicInteger>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QVariantMap>
+
+#include "HttpGlobal.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Runtime counters of a HttpListener, shared by all of its acceptors.
+  All methods are thread safe and can be read at any time, for example by a request
+  handler that serves a status page. The counters are lock-free, only the list of
+  threads is protected by a mutex because it changes when threads start or stop.
+  @see HttpListener::getMetrics()
+*/
+
+class DECLSPEC HttpServerMetrics
+{
+    Q_DISABLE_COPY(HttpServerMetrics)
+
+public:
+
+    /** Constructor, all counters start at 0 */
+    HttpServerMetrics();
+
+    /** Number of connections that have been accepted from the listening sockets */
+    quint64 getAcceptedConnections() const;
+
+    /** Number of connections that have been rejected with "503 Too Many Connections" */
+    quint64 getRejectedConnections() const;
+
+    /** Number of connections that have been rejected because their client had too many open connections */
+    quint64 getCappedConnections() const;
+
+    /** Number of connections that have been rejected because their client exceeded the connection rate */
+    quint64 getThrottledConnections() const;
+
+    /** Number of connections that are currently waiting for a free handler or worker */
+    quint64 getPendingConnections() const;
+
+    /** Number of connections that had to wait for a free handler or worker */
+    quint64 getQueuedConnections() const;
+
+    /** Number of waiting connections that have been rejected because they waited too long */
+    quint64 getExpiredConnections() const;
+
+    /** Sum of the waiting time of all connections that have left the pending queue, in milliseconds */
+    quint64 getPendingWaitTime() const;
+
+    /** Longest waiting time of a connection in the pending queue, in milliseconds */
+    quint64 getMaxPendingWaitTime() const;
+
+    /** Number of request and response bytes that the connections currently hold in memory */
+    quint64 getBufferedBytes() const;
+
+    /** Number of requests that have been rejected with "503 Service Unavailable" because maxBufferedBytes was reached */
+    quint64 getShedRequests() const;
+
+    /** Number of requests that have been rejected with "429 Too Many Requests" because their client exceeded the request rate */
+    quint64 getThrottledRequests() const;
+
+    /** Number of connections that have been passed to a worker on the NUMA node of their receiving CPU */
+    quint64 getLocalConnections() const;
+
+    /** Number of connections that have been passed to a worker on another NUMA node */
+    quint64 getRemoteConnections() const;
+
+    /**
+      Placement of the running acceptor, worker and handler threads. Each entry contains
+      the role, the allowed CPUs, the NUMA node (-1 if unknown or mixed) and the CPU that
+      the thread has started on.
+    */
+    QVariantList getThreads() const;
+
+    /** All counters by name, e.g. for a JSON status page */
+    QVariantMap toVariantMap() const;
+
+    /** Count a connection that has been accepted from a listening socket */
+    void addAcceptedConnection();
+
+    /** Count a connection that has been rejected */
+    void addRejectedConnection();
+
+    /** Count a connection that has been rejected by the limit of open connections per client */
+    void addCappedConnection();
+
+    /** Count a connection that has been rejected by the connection rate per client */
+    void addThrottledConnection();
+
+    /** Count a connection that has entered the pending queue */
+    void addPendingConnection();
+
+    /**
+      Count a connection that has left the pending queue.
+      @param waitTime Time in milliseconds that the connection has waited
+      @param expired true if the connection is rejected because it waited too long
+    */
+    void removePendingConnection(quint64 waitTime, bool expired);
+
+    /**
+      Change the number of bytes that the connections hold in memory.
+      @param delta Number of bytes that a connection has reserved (positive) or released (negative)
+      @return the new number of buffered bytes
+    */
+    quint64 addBufferedBytes(qint64 delta);
+
+    /** Count a request that has been rejected because the memory budget was exhausted */
+    void addShedRequest();
+
+    /** Count a request that has been rejected by the request rate per client */
+    void addThrottledRequest();
+
+    /**
+      Count a connection that has been steered to a worker.
+      @param local true if the worker runs on the NUMA node of the receiving CPU
+    */
+    void addPlacedConnection(bool local);
+
+    /**
+      Add the calling thread to the list of threads.
+      @param role Kind of the thread, e.g. "worker"
+      @param thread Identifies the thread for unregisterThread()
+      @param cpus CPUs that the thread has been pinned to, empty if not pinned
+      @param node NUMA node of the CPUs, -1 if unknown or mixed
+    */
+    void registerThread(const char *role, const void *thread, const QList<int> &cpus, int node);
+
+    /** Remove a thread from the list of threads */
+    void unregisterThread(const void *thread);
+
+private:
+
+    /** Entry of the list of threads */
+    struct ThreadPlacement
+    {
+        const char *role;
+        QList<int> cpus;
+        int node;
+        int startCpu;
+    };
+
+    QAtomicInteger<quint64> acceptedConnections;
+    QAtomicInteger<quint64> rejectedConnections;
+    QAtomicInteger<quint64> cappedConnections;
+    QAtomicInteger<quint64> throttledConnections;
+    QAtomicInteger<quint64> pendingConnections;
+    QAtomicInteger<quint64> queuedConnections;
+    QAtomicInteger<quint64> expiredConnections;
+    QAtomicInteger<quint64> pendingWaitTime;
+    QAtomicInteger<quint64> maxPendingWaitTime;
+    QAtomicInteger<quint64> bufferedBytes;
+    QAtomicInteger<quint64> shedRequests;
+    QAtomicInteger<quint64> throttledRequests;
+    QAtomicInteger<quint64> localConnections;
+    QAtomicInteger<quint64> remoteConnections;
+
+    /** Running threads, protected by the mutex */
+    QHash<const void*, ThreadPlacement> threads;
+
+    /** Used to synchronize access to the list of threads */
+    mutable QMutex mutex;
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPSERVERMETRICS_HPP
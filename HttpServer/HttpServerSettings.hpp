@@ -3,6 +3,7 @@
 
 #include <QtGlobal>
 #include <QString>
+#include <QList>
 #include <QByteArray>
 
 #include "HttpGlobal.hpp"
@@ -11,12 +12,44 @@ QTWEBAPP_NAMESPACE_BEGIN
 
 struct HttpServerSettings
 {
+    /** Values for connectionEngine */
+    enum ConnectionEngine : quint8 {
+        ThreadPerConnection = 0, // one HttpConnectionHandler thread per connection, limited by maxThreads
+        EventLoop                // fixed number of HttpWorker threads, each serving many connections
+    };
+
     QString host;
     quint16 port;
+    ConnectionEngine connectionEngine = ThreadPerConnection;
+    quint32 acceptorThreads = 1U; // more than 1 opens that many SO_REUSEPORT sockets, each with its own shard
     quint32 minThreads = 4U;
     quint32 maxThreads = 100U;
+    quint32 spareThreads = 4U; // idle handlers that are kept ready ahead of the expected load
+    quint32 workerThreads = 0U; // 0 = one worker per CPU core
+    QList<int> acceptorCpus; // CPUs for the HttpAcceptor threads, one per acceptor, empty = not pinned, see HttpThreadPlacement::parseCpuList()
+    QList<int> workerCpus; // CPUs for the workers (one per worker) and connection handlers (the whole set), empty = not pinned, see HttpThreadPlacement::parseCpuList()
+    bool steerConnections = false; // pass each connection to a worker on the NUMA node of its receiving CPU
+    quint32 maxConnections = 10000U;
+    quint32 maxClientConnections = 0U; // open connections of one client address, 0 = unlimited
+    quint32 clientConnectionRate = 0U; // new connections per second of one client address, 0 = unlimited
+    quint32 clientConnectionBurst = 0U; // connections that a quiet client may open at once, 0 = clientConnectionRate
+    quint32 clientRequestRate = 0U; // requests per second of one client address, 0 = unlimited
+    quint32 clientRequestBurst = 0U; // requests that a quiet client may send at once, 0 = clientRequestRate
+    quint32 maxPendingConnections = 128U; // 0 = reject at once when no handler or worker is free
+    quint32 maxPendingTime = 1000U;
     quint32 cleanupInterval = 1000U;
     quint32 readTimeout = 60000U;
+    quint32 writeTimeout = 60000U; // close a connection whose pending output makes no progress for this long, 0 = never
+    quint64 writeHighWatermark = 65536ULL; // pending output above which producers are slowed down or told to wait
+    quint64 writeLowWatermark = 16384ULL; // pending output at which producers may continue
+    bool ioUring = true; // EventLoop engine and acceptors: use io_uring if the library is built with it and the kernel supports it
+    bool parkIdleConnections = false; // ThreadPerConnection engine: release the handler while a keep-alive connection waits for its next request
+    bool tcpNoDelay = true; // send small responses at once instead of waiting for Nagle's algorithm
+    bool tcpCork = true; // send the headers and the body of a response in full segments
+    quint32 deferAccept = 0U; // seconds that the kernel waits for the first request data before accepting, 0 = off
+    quint32 fastOpenQueue = 0U; // pending TCP Fast Open connections of each listening socket, 0 = off
+    QList<qintptr> inheritedSockets; // listening sockets handed over by a previous process, used once by HttpListener::listen()
+    quint64 maxBufferedBytes = 0ULL; // request and response bytes that all connections of a listener may hold in memory, 0 = unlimited
     quint64 maxRequestSize = 1600ULL;
     quint64 maxMultiPartSize = 1000000ULL;
     QString sslKeyFile;
@@ -0,0 +1,70 @@
+#include "HttpSocketOptions.hpp"
+
+#ifdef Q_OS_UNIX
+    #include <errno.h>
+    #include <string.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <sys/socket.h>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+void HttpSocketOptions::applyToListeningSocket(qintptr socketDescriptor, const HttpServerSettings &settings)
+{
+#ifdef Q_OS_UNIX
+    const int fd = static_cast<int>(socketDescriptor);
+
+    #ifdef TCP_DEFER_ACCEPT
+        if (settings.deferAccept > 0)
+        {
+            const int seconds = static_cast<int>(settings.deferAccept);
+            if (::setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &seconds, sizeof(seconds)) == -1)
+            {
+                qWarning("HttpSocketOptions: cannot set TCP_DEFER_ACCEPT: %s", strerror(errno));
+            }
+        }
+    #endif
+
+    #ifdef TCP_FASTOPEN
+        if (settings.fastOpenQueue > 0)
+        {
+            const int queueLength = static_cast<int>(settings.fastOpenQueue);
+            if (::setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &queueLength, sizeof(queueLength)) == -1)
+            {
+                qWarning("HttpSocketOptions: cannot set TCP_FASTOPEN: %s", strerror(errno));
+            }
+        }
+    #endif
+
+    Q_UNUSED(fd)
+#else
+    Q_UNUSED(socketDescriptor)
+#endif
+    Q_UNUSED(settings)
+}
+
+void HttpSocketOptions::applyToConnection(QAbstractSocket *socket, const HttpServerSettings &settings)
+{
+    if (settings.tcpNoDelay)
+    {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    }
+}
+
+bool HttpSocketOptions::setCorked(qintptr socketDescriptor, bool corked)
+{
+    const int value = corked ? 1 : 0;
+
+#if defined(Q_OS_UNIX) && defined(TCP_CORK)
+    return ::setsockopt(static_cast<int>(socketDescriptor), IPPROTO_TCP, TCP_CORK, &value, sizeof(value)) == 0;
+#elif defined(Q_OS_UNIX) && defined(TCP_NOPUSH)
+    return ::setsockopt(static_cast<int>(socketDescriptor), IPPROTO_TCP, TCP_NOPUSH, &value, sizeof(value)) == 0;
+#else
+    Q_UNUSED(socketDescriptor)
+    Q_UNUSED(value)
+    return false;
+#endif
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
@@ -0,0 +1,58 @@
+#ifndef HTTPSOCKETOPTIONS_HPP
+#define HTTPSOCKETOPTIONS_HPP
+
+#include <QtGlobal>
+#include <QAbstractSocket>
+
+#include "HttpGlobal.hpp"
+#include "HttpServerSettings.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Helper functions that apply the socket option profile of the HttpServerSettings.
+  <p>
+  Listening sockets get TCP_DEFER_ACCEPT and TCP_FASTOPEN, accepted connections get TCP_NODELAY
+  through QAbstractSocket::LowDelayOption on all platforms.
+  HttpResponse corks the connection while it writes the headers and the body, so that they are
+  sent in full segments, and uncorks it when the response is flushed.
+  <p>
+  TCP_DEFER_ACCEPT is only supported on Linux, TCP_FASTOPEN on Linux and FreeBSD. Corking uses
+  TCP_CORK on Linux and TCP_NOPUSH on the BSDs and macOS. Options that the platform does not
+  support are silently skipped.
+  @see HttpServerSettings::tcpNoDelay
+  @see HttpServerSettings::tcpCork
+  @see HttpServerSettings::deferAccept
+  @see HttpServerSettings::fastOpenQueue
+*/
+
+class DECLSPEC HttpSocketOptions
+{
+public:
+
+    /**
+      Apply the options of a listening socket.
+      @param socketDescriptor references the listening socket.
+      @param settings Configuration settings of the HTTP webserver
+    */
+    static void applyToListeningSocket(qintptr socketDescriptor, const HttpServerSettings &settings);
+
+    /**
+      Apply the options of an accepted connection.
+      @param socket The accepted connection, after its socket descriptor has been set.
+      @param settings Configuration settings of the HTTP webserver
+    */
+    static void applyToConnection(QAbstractSocket *socket, const HttpServerSettings &settings);
+
+    /**
+      Cork or uncork a connection. While corked, the kernel sends only full segments.
+      Uncorking sends the remaining data at once.
+      @return false if corking is not supported
+    */
+    static bool setCorked(qintptr socketDescriptor, bool corked);
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPSOCKETOPTIONS_HPP
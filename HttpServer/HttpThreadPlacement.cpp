@@ -0,0 +1,170 @@
+#include "HttpThreadPlacement.hpp"
+
+#include <cstring>
+
+#include <QDir>
+#include <QStringList>
+#include <QVector>
+
+#ifdef Q_OS_LINUX
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/socket.h>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+namespace {
+
+/** Read the NUMA node of each CPU from sysfs, the index is the CPU number */
+QVector<int> readCpuNodes()
+{
+    QVector<int> nodes;
+
+#ifdef Q_OS_LINUX
+    QDir cpuDirectory("/sys/devices/system/cpu");
+    for (const QString &cpuName : cpuDirectory.entryList(QStringList() << "cpu[0-9]*", QDir::Dirs))
+    {
+        bool ok;
+        const int cpu = cpuName.mid(3).toInt(&ok);
+        if (!ok)
+        {
+            continue;
+        }
+
+        if (nodes.size() <= cpu)
+        {
+            nodes.resize(cpu + 1);
+        }
+
+        // The node is a link named nodeN in the directory of the CPU
+        nodes[cpu] = -1;
+        for (const QString &nodeName : QDir(cpuDirectory.filePath(cpuName)).entryList(QStringList() << "node[0-9]*", QDir::Dirs))
+        {
+            nodes[cpu] = nodeName.mid(4).toInt();
+        }
+    }
+#endif
+
+    return nodes;
+}
+
+}
+
+QList<int> HttpThreadPlacement::parseCpuList(const QString &text)
+{
+    QList<int> cpus;
+
+    for (const QString &part : text.split(','))
+    {
+        if (part.trimmed().isEmpty())
+        {
+            continue;
+        }
+
+        bool okFirst, okLast = true;
+        const int dash = part.indexOf('-');
+        const int first = part.left(dash).trimmed().toInt(&okFirst);
+        const int last = dash >= 0 ? part.mid(dash + 1).trimmed().toInt(&okLast) : first;
+
+        if (!okFirst || !okLast || first < 0 || last < first)
+        {
+            qWarning("HttpThreadPlacement: invalid CPU list %s", qUtf8Printable(text));
+            return QList<int>();
+        }
+
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.append(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+bool HttpThreadPlacement::pinCurrentThread(const QList<int> &cpus)
+{
+    if (cpus.isEmpty())
+    {
+        return false;
+    }
+
+#ifdef Q_OS_LINUX
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+
+    const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (error != 0)
+    {
+        qWarning("HttpThreadPlacement: cannot pin thread: %s", strerror(error));
+        return false;
+    }
+
+    return true;
+#else
+    qWarning("HttpThreadPlacement: pinning threads is not supported on this platform");
+    return false;
+#endif
+}
+
+int HttpThreadPlacement::getCurrentCpu()
+{
+#ifdef Q_OS_LINUX
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+int HttpThreadPlacement::getNodeOfCpu(int cpu)
+{
+    // The topology does not change while the server is running
+    static const QVector<int> nodes = readCpuNodes();
+    return cpu >= 0 && cpu < nodes.size() ? nodes.at(cpu) : -1;
+}
+
+int HttpThreadPlacement::getNodeOfCpus(const QList<int> &cpus)
+{
+    if (cpus.isEmpty())
+    {
+        return -1;
+    }
+
+    const int node = getNodeOfCpu(cpus.first());
+    for (int cpu : cpus)
+    {
+        if (getNodeOfCpu(cpu) != node)
+        {
+            return -1;
+        }
+    }
+
+    return node;
+}
+
+int HttpThreadPlacement::getIncomingCpu(tSocketDescriptor socketDescriptor)
+{
+#if defined(Q_OS_LINUX) && defined(SO_INCOMING_CPU)
+    int cpu = -1;
+    socklen_t length = sizeof(cpu);
+
+    if (::getsockopt(static_cast<int>(socketDescriptor), SOL_SOCKET, SO_INCOMING_CPU, &cpu, &length) == 0)
+    {
+        return cpu;
+    }
+#else
+    Q_UNUSED(socketDescriptor)
+#endif
+
+    return -1;
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
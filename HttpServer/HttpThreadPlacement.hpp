@@ -0,0 +1,61 @@
+#ifndef HTTPTHREADPLACEMENT_HPP
+#define HTTPTHREADPLACEMENT_HPP
+
+#include <QList>
+#include <QString>
+
+#include "HttpGlobal.hpp"
+#include "HttpConnection.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Helper functions to place server threads on CPUs and NUMA nodes.
+  <p>
+  Pinning and the NUMA topology are only supported on Linux. On other platforms
+  the functions do nothing and report the CPU and node -1 (unknown).
+  @see HttpServerSettings::acceptorCpus
+  @see HttpServerSettings::workerCpus
+*/
+
+class DECLSPEC HttpThreadPlacement
+{
+public:
+
+    /**
+      Parse a list of CPUs like "0-3,8,10-11", the format of acceptorCpus and workerCpus in the config file:
+      <code><pre>
+      settings.workerCpus = HttpThreadPlacement::parseCpuList(config.value("workerCpus").toString());
+      </pre></code>
+      @return the CPU numbers, empty if the text is empty or malformed
+    */
+    static QList<int> parseCpuList(const QString &text);
+
+    /**
+      Restrict the calling thread to the given CPUs.
+      @param cpus CPU numbers, nothing happens if the list is empty
+      @return false if pinning failed or is not supported
+    */
+    static bool pinCurrentThread(const QList<int> &cpus);
+
+    /** Returns the CPU that the calling thread is running on, or -1 */
+    static int getCurrentCpu();
+
+    /** Returns the NUMA node of a CPU, or -1 */
+    static int getNodeOfCpu(int cpu);
+
+    /** Returns the NUMA node of a set of CPUs, or -1 if it is unknown or the CPUs belong to different nodes */
+    static int getNodeOfCpus(const QList<int> &cpus);
+
+    /**
+      Returns the CPU that has processed the incoming packets of a connection (SO_INCOMING_CPU),
+      which usually handles the receive queue of the network card. Returns -1 if unknown.
+      @param socketDescriptor references the accepted connection.
+    */
+    static int getIncomingCpu(tSocketDescriptor socketDescriptor);
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPTHREADPLACEMENT_HPP
@@ -0,0 +1,171 @@
+#include "HttpTimerWheel.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpTimerWheel::Timer::Timer(HttpTimerWheel *wheel, std::function<void()> callback)
+{
+    Q_ASSERT(wheel != nullptr);
+    this->wheel = wheel;
+    this->callback = std::move(callback);
+}
+
+HttpTimerWheel::Timer::~Timer()
+{
+    this->stop();
+}
+
+void HttpTimerWheel::Timer::start(int msec)
+{
+    if (this->active)
+    {
+        this->wheel->remove(this);
+    }
+
+    this->wheel->insert(this, msec);
+}
+
+void HttpTimerWheel::Timer::stop()
+{
+    if (this->active)
+    {
+        this->wheel->remove(this);
+    }
+}
+
+bool HttpTimerWheel::Timer::isActive() const
+{
+    return this->active;
+}
+
+HttpTimerWheel::HttpTimerWheel(int resolution, int slotCount, QObject *parent)
+    : QObject(parent), ticker(this)
+{
+    int size = 2;
+    while (size < slotCount)
+    {
+        size <<= 1;
+    }
+
+    this->slotHeads.fill(nullptr, size);
+    this->mask = static_cast<quint64>(size - 1);
+    this->resolution = qMax(resolution, 1);
+    this->clock.start();
+
+    this->ticker.setInterval(this->resolution);
+    QObject::connect(&this->ticker, &QTimer::timeout, this, &HttpTimerWheel::advance);
+}
+
+HttpTimerWheel::~HttpTimerWheel()
+{
+    Q_ASSERT(this->count == 0);
+}
+
+int HttpTimerWheel::getResolution() const
+{
+    return this->resolution;
+}
+
+int HttpTimerWheel::getCount() const
+{
+    return this->count;
+}
+
+quint64 HttpTimerWheel::getClockTick() const
+{
+    return static_cast<quint64>(this->clock.elapsed()) / static_cast<quint64>(this->resolution);
+}
+
+void HttpTimerWheel::insert(Timer *timer, int msec)
+{
+    const quint64 now = this->getClockTick();
+
+    // Skip the ticks that passed while the wheel was idle
+    if (this->count == 0)
+    {
+        this->currentTick = now;
+        this->ticker.start();
+    }
+
+    // Round up, so that the timer never fires early
+    const quint64 ticks = static_cast<quint64>(qMax(msec, 0) + this->resolution - 1) / static_cast<quint64>(this->resolution);
+    timer->expiry = qMax(now, this->currentTick) + qMax(ticks, Q_UINT64_C(1));
+
+    Timer *&head = this->slotHeads[static_cast<int>(timer->expiry & this->mask)];
+    timer->previous = nullptr;
+    timer->next = head;
+    if (head)
+    {
+        head->previous = timer;
+    }
+
+    head = timer;
+    timer->active = true;
+    ++this->count;
+}
+
+void HttpTimerWheel::remove(Timer *timer)
+{
+    if (timer == this->cursor)
+    {
+        this->cursor = timer->next;
+    }
+
+    if (timer->previous)
+    {
+        timer->previous->next = timer->next;
+    }
+
+    else
+    {
+        this->slotHeads[static_cast<int>(timer->expiry & this->mask)] = timer->next;
+    }
+
+    if (timer->next)
+    {
+        timer->next->previous = timer->previous;
+    }
+
+    timer->previous = nullptr;
+    timer->next = nullptr;
+    timer->active = false;
+    --this->count;
+}
+
+void HttpTimerWheel::expire(quint64 tick)
+{
+    Timer *timer = this->slotHeads.at(static_cast<int>(tick & this->mask));
+
+    // The cursor follows removals, because a callback may stop or delete any other timer
+    while (timer)
+    {
+        this->cursor = timer->next;
+
+        if (timer->expiry <= tick)
+        {
+            this->remove(timer);
+            timer->callback();
+        }
+
+        timer = this->cursor;
+    }
+
+    this->cursor = nullptr;
+}
+
+void HttpTimerWheel::advance()
+{
+    const quint64 now = this->getClockTick();
+
+    while (this->currentTick < now && this->count > 0)
+    {
+        ++this->currentTick;
+        this->expire(this->currentTick);
+    }
+
+    if (this->count == 0)
+    {
+        this->ticker.stop();
+    }
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
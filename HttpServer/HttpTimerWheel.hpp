@@ -0,0 +1,147 @@
+#ifndef HTTPTIMERWHEEL_HPP
+#define HTTPTIMERWHEEL_HPP
+
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include "HttpGlobal.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Hashed timer wheel for the timeouts of all connections in one thread.
+  <p>
+  Each timer is linked into the slot of its expiry tick, so starting, restarting and stopping
+  a timer costs O(1) without any heap allocation, no matter how many connections are open.
+  A single QTimer advances the wheel by one slot per tick. Timeouts that are longer than one
+  revolution stay in their slot until their tick has come. The QTimer only runs while at least
+  one timer is active.
+  <p>
+  Timeouts are rounded up to the resolution, so a timer fires between msec and msec+resolution
+  after it has been started. The wheel and its timers must be used from the thread that the
+  wheel lives in.
+*/
+
+class DECLSPEC HttpTimerWheel : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpTimerWheel)
+
+public:
+
+    /**
+      A timeout in a HttpTimerWheel, usually a member of the object that it belongs to.
+      The callback is called in the thread of the wheel, it may start or stop any timer and
+      also delete the timer that has fired.
+    */
+    class DECLSPEC Timer
+    {
+        Q_DISABLE_COPY(Timer)
+
+    public:
+
+        /**
+          Constructor, the timer is not active.
+          @param wheel Wheel that drives this timer. Must not be 0.
+          @param callback Called when the timer expires
+        */
+        Timer(HttpTimerWheel *wheel, std::function<void()> callback);
+
+        /** Destructor, stops the timer */
+        ~Timer();
+
+        /** Start or restart the timer */
+        void start(int msec);
+
+        /** Stop the timer */
+        void stop();
+
+        /** Whether the timer has been started and has not expired yet */
+        bool isActive() const;
+
+    private:
+
+        friend class HttpTimerWheel;
+
+        HttpTimerWheel *wheel = nullptr;
+        std::function<void()> callback;
+
+        /** Tick at which the timer expires */
+        quint64 expiry = 0;
+
+        /** Neighbours in the slot */
+        Timer *previous = nullptr;
+        Timer *next = nullptr;
+
+        bool active = false;
+    };
+
+    /**
+      Constructor.
+      @param resolution Duration of one tick in milliseconds
+      @param slotCount Number of slots, rounded up to the next power of two
+      @param parent Parent object.
+    */
+    explicit HttpTimerWheel(int resolution = 100, int slotCount = 512, QObject *parent = nullptr);
+
+    /** Destructor, the timers must have been stopped or deleted before */
+    virtual ~HttpTimerWheel();
+
+    /** Duration of one tick in milliseconds */
+    int getResolution() const;
+
+    /** Number of active timers */
+    int getCount() const;
+
+private:
+
+    /** First timer of each slot, the index is the expiry tick modulo the number of slots */
+    QVector<Timer*> slotHeads;
+
+    /** Number of slots minus one */
+    quint64 mask = 0;
+
+    /** Duration of one tick */
+    int resolution = 100;
+
+    /** Number of active timers */
+    int count = 0;
+
+    /** Last tick that has been processed */
+    quint64 currentTick = 0;
+
+    /** Next timer to visit while a slot is processed */
+    Timer *cursor = nullptr;
+
+    /** Measures the ticks */
+    QElapsedTimer clock;
+
+    /** Drives the wheel while timers are active */
+    QTimer ticker;
+
+    /** Current tick according to the clock */
+    quint64 getClockTick() const;
+
+    /** Link a timer into the slot of its expiry */
+    void insert(Timer *timer, int msec);
+
+    /** Unlink a timer from its slot */
+    void remove(Timer *timer);
+
+    /** Fire the expired timers of one slot */
+    void expire(quint64 tick);
+
+private slots:
+
+    /** Received from the ticker, processes all ticks up to now */
+    void advance();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPTIMERWHEEL_HPP
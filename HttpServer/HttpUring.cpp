@@ -0,0 +1,795 @@
+#include "HttpUring.hpp"
+
+#ifdef QTWEBAPP_URING
+    #include <errno.h>
+    #include <string.h>
+    #include <sys/eventfd.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+    #include <liburing.h>
+
+    #include <QElapsedTimer>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+#ifdef QTWEBAPP_URING
+
+/** Number of submission entries of a ring */
+static const unsigned ringEntries = 1024;
+
+/** Group of the provided receive buffers */
+static const int bufferGroup = 0;
+
+/** The lower bits of the user data carry the operation, the rest points to the channel */
+static const quintptr operationMask = 3;
+
+struct HttpUring::Channel
+{
+    /** Socket of the channel */
+    qintptr socketDescriptor = -1;
+
+    /** Receives the completions, `nullptr` after close() */
+    Handler *handler = nullptr;
+
+    /** Whether the socket is a listening socket that the ring does not own */
+    bool listening = false;
+
+    /** Set by close() */
+    bool closed = false;
+
+    /** Operations that the kernel has not finished yet */
+    int pending = 0;
+
+    /** Completions of this channel that are being processed, it must not be released during that time */
+    int busy = 0;
+
+    /** Whether a send is in flight */
+    bool sending = false;
+
+    /** Whether the channel is in the list of writers */
+    bool writing = false;
+
+    /** Data of the send in flight */
+    QByteArray output;
+
+    /** Bytes of the output that have been sent */
+    qint64 sent = 0;
+
+    /** Data that has been queued while a send is in flight */
+    QByteArray queued;
+};
+
+HttpUring::HttpUring(QObject *parent)
+    : QObject(parent)
+{
+}
+
+HttpUring::~HttpUring()
+{
+    delete this->notifier;
+    this->notifier = nullptr;
+
+    // Operations in flight may still read the output of a channel or write into the receive buffers,
+    // so they are finished before the ring, the channels and the buffers are freed
+    const bool finished = !this->ring || this->cancelAll();
+
+    if (this->ring)
+    {
+        if (this->bufferRing)
+        {
+            io_uring_free_buf_ring(this->ring, this->bufferRing, static_cast<unsigned>(this->bufferCount), bufferGroup);
+        }
+
+        io_uring_queue_exit(this->ring);
+        delete this->ring;
+    }
+
+    for (Channel *channel : this->channels)
+    {
+        if (!channel->listening)
+        {
+            ::close(static_cast<int>(channel->socketDescriptor));
+        }
+
+        // Leaked rather than freed while the kernel might still use it
+        if (finished)
+        {
+            delete channel;
+        }
+    }
+
+    this->channels.clear();
+
+    if (finished)
+    {
+        delete[] this->buffers;
+    }
+
+    if (this->eventDescriptor != -1)
+    {
+        ::close(this->eventDescriptor);
+    }
+}
+
+bool HttpUring::cancelAll()
+{
+    // Completions that wait() has taken are not processed anymore, the handlers may be gone
+    for (const Completion &completion : this->deferred)
+    {
+        if (!(completion.flags & IORING_CQE_F_MORE))
+        {
+            --reinterpret_cast<Channel*>(static_cast<quintptr>(completion.userData & ~static_cast<quint64>(operationMask)))->pending;
+        }
+    }
+
+    this->deferred.clear();
+
+    int pending = 0;
+    for (Channel *channel : this->channels)
+    {
+        pending += channel->pending;
+    }
+
+    if (pending == 0)
+    {
+        return true;
+    }
+
+    // The cancellation has no channel, entries that are still prepared are submitted before it
+    io_uring_sqe *entry = this->getEntry();
+    io_uring_prep_cancel64(entry, 0, IORING_ASYNC_CANCEL_ANY);
+    io_uring_sqe_set_data64(entry, Cancel);
+    io_uring_submit(this->ring);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    while (pending > 0 && timer.elapsed() < 1000)
+    {
+        __kernel_timespec timeout;
+        timeout.tv_sec = 0;
+        timeout.tv_nsec = 100000000;
+
+        io_uring_cqe *cqe = nullptr;
+        const int ret = io_uring_wait_cqe_timeout(this->ring, &cqe, &timeout);
+        if (ret == -EINTR || ret == -ETIME)
+        {
+            continue;
+        }
+
+        if (ret < 0)
+        {
+            break;
+        }
+
+        const Completion completion = {cqe->user_data, cqe->res, cqe->flags};
+        io_uring_cqe_seen(this->ring, cqe);
+
+        Channel *channel = reinterpret_cast<Channel*>(static_cast<quintptr>(completion.userData & ~static_cast<quint64>(operationMask)));
+        const Operation operation = static_cast<Operation>(completion.userData & operationMask);
+
+        // A connection that has been accepted meanwhile has no handler anymore
+        if (operation == Accept && completion.result >= 0)
+        {
+            ::close(completion.result);
+        }
+
+        if (channel && !(completion.flags & IORING_CQE_F_MORE))
+        {
+            --channel->pending;
+            --pending;
+        }
+    }
+
+    if (pending > 0)
+    {
+        qWarning("HttpUring (%p): %i operations have not finished, their buffers are not freed", this, pending);
+        return false;
+    }
+
+    return true;
+}
+
+bool HttpUring::isSupported()
+{
+    static const bool supported = []()
+    {
+        io_uring probeRing;
+        if (io_uring_queue_init(4, &probeRing, 0) < 0)
+        {
+            // Also the case if io_uring is disabled by the administrator
+            return false;
+        }
+
+        bool result = false;
+        if (io_uring_probe *probe = io_uring_get_probe_ring(&probeRing))
+        {
+            // Multishot receive with provided buffers came with Linux 6.0, like zero copy send,
+            // which is the only way to find out the kernel version by a probe
+            result = io_uring_opcode_supported(probe, IORING_OP_ACCEPT) &&
+                     io_uring_opcode_supported(probe, IORING_OP_RECV) &&
+                     io_uring_opcode_supported(probe, IORING_OP_SEND_ZC);
+            io_uring_free_probe(probe);
+        }
+
+        io_uring_queue_exit(&probeRing);
+        return result;
+    }();
+
+    return supported;
+}
+
+HttpUring *HttpUring::create(int bufferCount, int bufferSize, QObject *parent)
+{
+    if (!isSupported())
+    {
+        return nullptr;
+    }
+
+    HttpUring *uring = new HttpUring(parent);
+    uring->ring = new io_uring;
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_SINGLE_ISSUER;
+
+    int ret = io_uring_queue_init_params(ringEntries, uring->ring, &params);
+    if (ret == -EINVAL)
+    {
+        // Older kernels do not know the flags
+        memset(&params, 0, sizeof(params));
+        ret = io_uring_queue_init_params(ringEntries, uring->ring, &params);
+    }
+
+    if (ret < 0)
+    {
+        qWarning("HttpUring: cannot create ring: %s", strerror(-ret));
+        delete uring->ring;
+        uring->ring = nullptr;
+        delete uring;
+        return nullptr;
+    }
+
+    if (bufferCount > 0)
+    {
+        // The kernel needs a power of two
+        int count = 1;
+        while (count < bufferCount)
+        {
+            count <<= 1;
+        }
+
+        uring->bufferRing = io_uring_setup_buf_ring(uring->ring, static_cast<unsigned>(count), bufferGroup, 0, &ret);
+        if (!uring->bufferRing)
+        {
+            qWarning("HttpUring: cannot register receive buffers: %s", strerror(-ret));
+            delete uring;
+            return nullptr;
+        }
+
+        uring->bufferCount = count;
+        uring->bufferSize = bufferSize;
+        uring->buffers = new char[static_cast<size_t>(count) * static_cast<size_t>(bufferSize)];
+
+        for (int i = 0; i < count; ++i)
+        {
+            io_uring_buf_ring_add(uring->bufferRing, uring->buffers + static_cast<size_t>(i) * static_cast<size_t>(bufferSize),
+                                  static_cast<unsigned>(bufferSize), static_cast<unsigned short>(i), io_uring_buf_ring_mask(static_cast<unsigned>(count)), i);
+        }
+
+        io_uring_buf_ring_advance(uring->bufferRing, count);
+    }
+
+    uring->eventDescriptor = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (uring->eventDescriptor == -1 || io_uring_register_eventfd(uring->ring, uring->eventDescriptor) < 0)
+    {
+        qWarning("HttpUring: cannot register eventfd: %s", strerror(errno));
+        delete uring;
+        return nullptr;
+    }
+
+    uring->notifier = new QSocketNotifier(uring->eventDescriptor, QSocketNotifier::Read, uring);
+    QObject::connect(uring->notifier, &QSocketNotifier::activated, uring, &HttpUring::complete);
+
+    qDebug("HttpUring (%p): created with %i receive buffers", uring, uring->bufferCount);
+    return uring;
+}
+
+HttpUring::Channel *HttpUring::listen(qintptr socketDescriptor, Handler *handler)
+{
+    Channel *channel = new Channel;
+    channel->socketDescriptor = socketDescriptor;
+    channel->handler = handler;
+    channel->listening = true;
+    this->channels.insert(channel);
+
+    this->arm(channel);
+    this->scheduleSubmit();
+    return channel;
+}
+
+HttpUring::Channel *HttpUring::open(qintptr socketDescriptor, Handler *handler)
+{
+    if (!this->bufferRing)
+    {
+        return nullptr;
+    }
+
+    Channel *channel = new Channel;
+    channel->socketDescriptor = socketDescriptor;
+    channel->handler = handler;
+    this->channels.insert(channel);
+
+    this->arm(channel);
+    this->scheduleSubmit();
+    return channel;
+}
+
+void HttpUring::send(Channel *channel, const char *data, qint64 size)
+{
+    channel->queued.append(data, static_cast<int>(size));
+
+    // All data of this event loop iteration goes out with one send
+    if (!channel->sending && !channel->writing)
+    {
+        channel->writing = true;
+        this->writers.append(channel);
+        this->scheduleSubmit();
+    }
+}
+
+qint64 HttpUring::getPendingBytes(const Channel *channel) const
+{
+    return channel->output.size() - channel->sent + channel->queued.size();
+}
+
+void HttpUring::close(Channel *channel)
+{
+    if (!channel || channel->closed)
+    {
+        return;
+    }
+
+    channel->handler = nullptr;
+    channel->closed = true;
+
+    if (channel->writing)
+    {
+        channel->writing = false;
+        this->writers.removeOne(channel);
+    }
+
+    if (channel->pending == 0)
+    {
+        this->release(channel);
+        return;
+    }
+
+    io_uring_sqe *entry = this->getEntry();
+
+    if (channel->listening)
+    {
+        // The caller closes the listening socket, so the accept is cancelled by its user data
+        io_uring_prep_cancel64(entry, reinterpret_cast<quintptr>(channel) | Accept, 0);
+        io_uring_sqe_set_data64(entry, reinterpret_cast<quintptr>(channel) | Cancel);
+        ++channel->pending;
+
+        // At once, until then the kernel would accept connections for a socket that is closed
+        this->submit();
+        return;
+    }
+
+    io_uring_prep_cancel_fd(entry, static_cast<int>(channel->socketDescriptor), IORING_ASYNC_CANCEL_ALL);
+    io_uring_sqe_set_data64(entry, reinterpret_cast<quintptr>(channel) | Cancel);
+    ++channel->pending;
+    this->scheduleSubmit();
+}
+
+bool HttpUring::wait(Channel *channel, int msecs)
+{
+    // A completion that an earlier wait() has taken must be processed first
+    for (int i = 0; i < this->deferred.size(); ++i)
+    {
+        if ((this->deferred.at(i).userData & ~static_cast<quint64>(operationMask)) == reinterpret_cast<quintptr>(channel))
+        {
+            this->process(this->deferred.takeAt(i));
+            return true;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    this->submit();
+
+    for (;;)
+    {
+        io_uring_cqe *cqe = nullptr;
+        int ret;
+
+        if (msecs < 0)
+        {
+            ret = io_uring_wait_cqe(this->ring, &cqe);
+        }
+
+        else
+        {
+            const qint64 remaining = msecs - timer.elapsed();
+            if (remaining <= 0)
+            {
+                return false;
+            }
+
+            __kernel_timespec timeout;
+            timeout.tv_sec = remaining / 1000;
+            timeout.tv_nsec = (remaining % 1000) * 1000000;
+            ret = io_uring_wait_cqe_timeout(this->ring, &cqe, &timeout);
+        }
+
+        if (ret == -EINTR)
+        {
+            continue;
+        }
+
+        if (ret < 0)
+        {
+            return false;
+        }
+
+        const Completion completion = {cqe->user_data, cqe->res, cqe->flags};
+        io_uring_cqe_seen(this->ring, cqe);
+
+        if ((completion.userData & ~static_cast<quint64>(operationMask)) == reinterpret_cast<quintptr>(channel))
+        {
+            this->process(completion);
+            return true;
+        }
+
+        // The event loop processes the completions of the other channels, as if nobody had waited
+        if (this->deferred.isEmpty())
+        {
+            QMetaObject::invokeMethod(this, "complete", Qt::QueuedConnection);
+        }
+
+        this->deferred.append(completion);
+    }
+}
+
+io_uring_sqe *HttpUring::getEntry()
+{
+    io_uring_sqe *entry = io_uring_get_sqe(this->ring);
+
+    if (!entry)
+    {
+        // The submission queue is full, the entries cannot wait for the event loop
+        io_uring_submit(this->ring);
+        entry = io_uring_get_sqe(this->ring);
+    }
+
+    Q_ASSERT(entry != nullptr);
+    return entry;
+}
+
+void HttpUring::scheduleSubmit()
+{
+    if (!this->submitScheduled)
+    {
+        this->submitScheduled = true;
+        QMetaObject::invokeMethod(this, "submit", Qt::QueuedConnection);
+    }
+}
+
+void HttpUring::arm(Channel *channel)
+{
+    io_uring_sqe *entry = this->getEntry();
+
+    if (channel->listening)
+    {
+        io_uring_prep_multishot_accept(entry, static_cast<int>(channel->socketDescriptor), nullptr, nullptr, SOCK_CLOEXEC);
+        io_uring_sqe_set_data64(entry, reinterpret_cast<quintptr>(channel) | Accept);
+    }
+
+    else
+    {
+        io_uring_prep_recv_multishot(entry, static_cast<int>(channel->socketDescriptor), nullptr, 0, 0);
+        entry->flags |= IOSQE_BUFFER_SELECT;
+        entry->buf_group = bufferGroup;
+        io_uring_sqe_set_data64(entry, reinterpret_cast<quintptr>(channel) | Receive);
+    }
+
+    ++channel->pending;
+}
+
+void HttpUring::prepareSend(Channel *channel)
+{
+    if (channel->sent == channel->output.size())
+    {
+        channel->output.clear();
+        channel->output.swap(channel->queued);
+        channel->sent = 0;
+    }
+
+    if (channel->output.isEmpty())
+    {
+        return;
+    }
+
+    io_uring_sqe *entry = this->getEntry();
+    io_uring_prep_send(entry, static_cast<int>(channel->socketDescriptor), channel->output.constData() + channel->sent,
+                       static_cast<size_t>(channel->output.size() - channel->sent), MSG_NOSIGNAL);
+    io_uring_sqe_set_data64(entry, reinterpret_cast<quintptr>(channel) | Send);
+
+    channel->sending = true;
+    ++channel->pending;
+}
+
+void HttpUring::submit()
+{
+    this->submitScheduled = false;
+
+    for (Channel *channel : this->writers)
+    {
+        channel->writing = false;
+
+        if (!channel->sending)
+        {
+            this->prepareSend(channel);
+        }
+    }
+
+    this->writers.clear();
+
+    if (io_uring_sq_ready(this->ring) > 0)
+    {
+        const int ret = io_uring_submit(this->ring);
+        if (ret < 0 && ret != -EINTR)
+        {
+            qWarning("HttpUring (%p): submit failed: %s", this, strerror(-ret));
+        }
+    }
+}
+
+void HttpUring::complete()
+{
+    quint64 count;
+    if (::read(this->eventDescriptor, &count, sizeof(count)) == -1)
+    {
+        // Nothing signalled, for example after wait() has taken the completions
+    }
+
+    // The completions that wait() has taken are older than the ones in the ring
+    const QVector<Completion> completions = this->deferred;
+    this->deferred.clear();
+
+    for (const Completion &completion : completions)
+    {
+        this->process(completion);
+    }
+
+    io_uring_cqe *cqe = nullptr;
+    while (io_uring_peek_cqe(this->ring, &cqe) == 0)
+    {
+        const Completion completion = {cqe->user_data, cqe->res, cqe->flags};
+        io_uring_cqe_seen(this->ring, cqe);
+        this->process(completion);
+    }
+
+    // The handlers have queued their answers meanwhile, they go out together
+    if (!this->writers.isEmpty() || io_uring_sq_ready(this->ring) > 0)
+    {
+        this->submit();
+    }
+}
+
+void HttpUring::process(const Completion &completion)
+{
+    Channel *channel = reinterpret_cast<Channel*>(static_cast<quintptr>(completion.userData & ~static_cast<quint64>(operationMask)));
+    const Operation operation = static_cast<Operation>(completion.userData & operationMask);
+    const bool more = completion.flags & IORING_CQE_F_MORE;
+
+    if (!more)
+    {
+        --channel->pending;
+    }
+
+    ++channel->busy;
+
+    switch (operation)
+    {
+        case Accept:
+            if (completion.result >= 0)
+            {
+                if (channel->handler)
+                {
+                    channel->handler->accepted(completion.result);
+                }
+
+                else
+                {
+                    ::close(completion.result);
+                }
+            }
+
+            else if (completion.result != -ECANCELED)
+            {
+                qWarning("HttpUring (%p): accept failed: %s", this, strerror(-completion.result));
+            }
+
+            if (!more && channel->handler && completion.result != -ECANCELED)
+            {
+                this->arm(channel);
+                this->scheduleSubmit();
+            }
+
+            break;
+
+        case Receive:
+            if (completion.result > 0 && (completion.flags & IORING_CQE_F_BUFFER))
+            {
+                const int index = static_cast<int>(completion.flags >> IORING_CQE_BUFFER_SHIFT);
+
+                if (channel->handler)
+                {
+                    channel->handler->received(this->buffers + static_cast<size_t>(index) * static_cast<size_t>(this->bufferSize), completion.result);
+                }
+
+                this->recycleBuffer(index);
+            }
+
+            if (!more && channel->handler)
+            {
+                // The receive also ends when the kernel runs out of buffers or the completion ring overflows
+                if (completion.result > 0 || completion.result == -ENOBUFS)
+                {
+                    this->arm(channel);
+                    this->scheduleSubmit();
+                }
+
+                else
+                {
+                    channel->handler->failed(completion.result == 0 ? 0 : -completion.result);
+                }
+            }
+
+            break;
+
+        case Send:
+            channel->sending = false;
+
+            if (completion.result >= 0)
+            {
+                channel->sent += completion.result;
+
+                if (channel->handler)
+                {
+                    channel->handler->sent(completion.result);
+                }
+
+                if (channel->handler)
+                {
+                    this->prepareSend(channel);
+                    this->scheduleSubmit();
+                }
+            }
+
+            else if (channel->handler)
+            {
+                channel->handler->failed(-completion.result);
+            }
+
+            break;
+
+        case Cancel:
+            break;
+    }
+
+    --channel->busy;
+
+    if (channel->closed)
+    {
+        this->release(channel);
+    }
+}
+
+void HttpUring::recycleBuffer(int index)
+{
+    io_uring_buf_ring_add(this->bufferRing, this->buffers + static_cast<size_t>(index) * static_cast<size_t>(this->bufferSize),
+                          static_cast<unsigned>(this->bufferSize), static_cast<unsigned short>(index),
+                          io_uring_buf_ring_mask(static_cast<unsigned>(this->bufferCount)), 0);
+    io_uring_buf_ring_advance(this->bufferRing, 1);
+}
+
+void HttpUring::release(Channel *channel)
+{
+    if (channel->pending > 0 || channel->busy > 0)
+    {
+        return;
+    }
+
+    if (!channel->listening)
+    {
+        ::close(static_cast<int>(channel->socketDescriptor));
+    }
+
+    this->channels.remove(channel);
+    delete channel;
+}
+
+#else // QTWEBAPP_URING
+
+struct HttpUring::Channel
+{
+};
+
+HttpUring::HttpUring(QObject *parent)
+    : QObject(parent)
+{
+}
+
+HttpUring::~HttpUring()
+{
+}
+
+bool HttpUring::isSupported()
+{
+    return false;
+}
+
+HttpUring *HttpUring::create(int bufferCount, int bufferSize, QObject *parent)
+{
+    Q_UNUSED(bufferCount)
+    Q_UNUSED(bufferSize)
+    Q_UNUSED(parent)
+    return nullptr;
+}
+
+HttpUring::Channel *HttpUring::listen(qintptr socketDescriptor, Handler *handler)
+{
+    Q_UNUSED(socketDescriptor)
+    Q_UNUSED(handler)
+    return nullptr;
+}
+
+HttpUring::Channel *HttpUring::open(qintptr socketDescriptor, Handler *handler)
+{
+    Q_UNUSED(socketDescriptor)
+    Q_UNUSED(handler)
+    return nullptr;
+}
+
+void HttpUring::send(Channel *channel, const char *data, qint64 size)
+{
+    Q_UNUSED(channel)
+    Q_UNUSED(data)
+    Q_UNUSED(size)
+}
+
+qint64 HttpUring::getPendingBytes(const Channel *channel) const
+{
+    Q_UNUSED(channel)
+    return 0;
+}
+
+void HttpUring::close(Channel *channel)
+{
+    Q_UNUSED(channel)
+}
+
+bool HttpUring::wait(Channel *channel, int msecs)
+{
+    Q_UNUSED(channel)
+    Q_UNUSED(msecs)
+    return false;
+}
+
+void HttpUring::submit()
+{
+}
+
+void HttpUring::complete()
+{
+}
+
+#endif // QTWEBAPP_URING
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
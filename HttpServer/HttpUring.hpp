@@ -0,0 +1,218 @@
+#ifndef HTTPURING_HPP
+#define HTTPURING_HPP
+
+#include <QByteArray>
+#include <QObject>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QVector>
+
+#include "HttpGlobal.hpp"
+
+struct io_uring;
+struct io_uring_buf_ring;
+struct io_uring_sqe;
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Linux io_uring submission and completion ring of one thread, an alternative to the
+  socket notifiers of Qt for the connections of a HttpWorker and the listening socket
+  of a HttpAcceptor.
+  <p>
+  A listening socket uses one multishot accept, and each connection one multishot receive
+  that takes its buffers from a ring of provided buffers, so an armed socket costs no system
+  call until data arrives. Sends are prepared while the event loop runs and submitted
+  together with one system call when control returns to the event loop. The completions
+  are signalled through an eventfd that is watched by a QSocketNotifier.
+  <p>
+  The ring is only available if the library has been built with <code>CONFIG += qtwebapp_uring</code>
+  (which links liburing) and the kernel supports multishot receive with provided buffers (Linux 6.0).
+  create() returns `nullptr` otherwise, so that the caller can fall back to the normal sockets.
+  <p>
+  The ring and all of its channels must only be used in the thread that created the ring.
+  @see HttpUringSocket which connects a ring to the HttpConnection.
+*/
+
+class DECLSPEC HttpUring : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpUring)
+
+public:
+
+    /** Receives the completions of a channel */
+    class Handler
+    {
+    public:
+
+        virtual ~Handler() = default;
+
+        /** A connection has been accepted by a listening channel. The handler takes ownership. */
+        virtual void accepted(qintptr socketDescriptor) { Q_UNUSED(socketDescriptor) }
+
+        /** Data has been received, the buffer is only valid during the call */
+        virtual void received(const char *data, qint64 size) { Q_UNUSED(data) Q_UNUSED(size) }
+
+        /** Queued data has been sent */
+        virtual void sent(qint64 size) { Q_UNUSED(size) }
+
+        /**
+          The peer has closed the connection or an error occurred. The channel does not
+          receive anymore, but it must still be closed by the handler.
+          @param error errno value, 0 if the peer has closed the connection
+        */
+        virtual void failed(int error) { Q_UNUSED(error) }
+    };
+
+    /** A socket that is registered at the ring, created by listen() or open() */
+    struct Channel;
+
+    /**
+      Create a ring for the calling thread.
+      @param bufferCount Number of provided receive buffers, 0 for a ring that only accepts
+      @param bufferSize Size of each receive buffer
+      @param parent Parent object
+      @return `nullptr` if io_uring is not supported or the ring cannot be created.
+    */
+    static HttpUring *create(int bufferCount = 256, int bufferSize = 16384, QObject *parent = nullptr);
+
+    /** Returns true if the library has been built with io_uring and the kernel supports it */
+    static bool isSupported();
+
+    /** Destructor, closes all channels */
+    virtual ~HttpUring();
+
+    /**
+      Start accepting connections on a listening socket, they are passed to Handler::accepted().
+      @param socketDescriptor Listening socket, the caller keeps ownership.
+      @param handler Receives the completions
+      @return `nullptr` if the socket cannot be registered
+    */
+    Channel *listen(qintptr socketDescriptor, Handler *handler);
+
+    /**
+      Start receiving on a connected socket, the data is passed to Handler::received().
+      @param socketDescriptor Connected socket, the ring takes ownership and closes it with the channel.
+      @param handler Receives the completions
+      @return `nullptr` if the socket cannot be registered
+    */
+    Channel *open(qintptr socketDescriptor, Handler *handler);
+
+    /**
+      Queue data for sending. Data that is queued while a send is in flight is sent
+      with the next submission in one piece.
+    */
+    void send(Channel *channel, const char *data, qint64 size);
+
+    /** Number of queued bytes that have not been sent yet */
+    qint64 getPendingBytes(const Channel *channel) const;
+
+    /**
+      Detach the handler and cancel the operations of the channel. The channel is released,
+      and the socket of a connection is closed, when the kernel has finished all operations.
+    */
+    void close(Channel *channel);
+
+    /**
+      Block until the next completion of the channel has been processed. Completions of other
+      channels are kept and processed later by the event loop.
+      @return false on timeout
+    */
+    bool wait(Channel *channel, int msecs);
+
+private:
+
+    /** Operation types, stored in the lower bits of the user data */
+    enum Operation : quintptr
+    {
+        Accept = 0,
+        Receive = 1,
+        Send = 2,
+        Cancel = 3
+    };
+
+    /** Completion that has been taken from the ring by wait() but not processed yet */
+    struct Completion
+    {
+        quint64 userData;
+        int result;
+        unsigned flags;
+    };
+
+    /** Constructor, see create() */
+    HttpUring(QObject *parent);
+
+    /** The kernel ring */
+    io_uring *ring = nullptr;
+
+    /** Ring of provided buffers for receiving */
+    io_uring_buf_ring *bufferRing = nullptr;
+
+    /** Memory of the provided buffers */
+    char *buffers = nullptr;
+
+    /** Number of provided buffers */
+    int bufferCount = 0;
+
+    /** Size of each provided buffer */
+    int bufferSize = 0;
+
+    /** Signalled by the kernel when completions are available */
+    int eventDescriptor = -1;
+
+    /** Watches the eventfd */
+    QSocketNotifier *notifier = nullptr;
+
+    /** Registered channels */
+    QSet<Channel*> channels;
+
+    /** Channels with queued data that waits for the next submission */
+    QVector<Channel*> writers;
+
+    /** Completions taken by wait() */
+    QVector<Completion> deferred;
+
+    /** Whether a submission has been scheduled */
+    bool submitScheduled = false;
+
+    /** Get a free submission entry, submits the ring if it is full */
+    io_uring_sqe *getEntry();
+
+    /** Submit the prepared entries when control returns to the event loop */
+    void scheduleSubmit();
+
+    /** Prepare a multishot accept or receive */
+    void arm(Channel *channel);
+
+    /** Prepare a send of the rest of the data in flight, or of all queued data */
+    void prepareSend(Channel *channel);
+
+    /** Process one completion */
+    void process(const Completion &completion);
+
+    /** Return a provided buffer to the kernel */
+    void recycleBuffer(int index);
+
+    /** Close the socket of a closed channel and delete it, if the kernel has finished all operations */
+    void release(Channel *channel);
+
+    /**
+      Cancel all operations in flight and wait until the kernel has finished them, used by the destructor.
+      @return false if some operations have not finished within a second
+    */
+    bool cancelAll();
+
+private slots:
+
+    /** Submit all prepared entries with one system call */
+    void submit();
+
+    /** Received from the notifier, processes all available completions */
+    void complete();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPURING_HPP
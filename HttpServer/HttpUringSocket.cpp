@@ -0,0 +1,264 @@
+#include "HttpUringSocket.hpp"
+
+#include <QElapsedTimer>
+
+#include <string.h>
+
+#ifdef Q_OS_UNIX
+    #include <netinet/in.h>
+    #include <sys/socket.h>
+#endif
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpUringSocket::HttpUringSocket(HttpUring *uring, QObject *parent)
+    : QTcpSocket(parent)
+{
+    Q_ASSERT(uring != nullptr);
+    this->uring = uring;
+}
+
+HttpUringSocket::~HttpUringSocket()
+{
+    if (this->channel)
+    {
+        this->uring->close(this->channel);
+        this->channel = nullptr;
+    }
+
+    // Otherwise the base class would abort through the socket engine of Qt
+    this->setSocketState(UnconnectedState);
+}
+
+bool HttpUringSocket::setSocketDescriptor(qintptr socketDescriptor, SocketState state, OpenMode openMode)
+{
+    Q_ASSERT(this->channel == nullptr);
+
+    this->channel = this->uring->open(socketDescriptor, this);
+    if (!this->channel)
+    {
+        this->setSocketError(UnsupportedSocketOperationError);
+        this->setErrorString(tr("The socket cannot be registered at the io_uring"));
+        return false;
+    }
+
+    #ifdef Q_OS_UNIX
+        sockaddr_storage storage;
+        socklen_t length = sizeof(storage);
+        memset(&storage, 0, sizeof(storage));
+
+        if (::getpeername(static_cast<int>(socketDescriptor), reinterpret_cast<sockaddr*>(&storage), &length) == 0)
+        {
+            this->setPeerAddress(QHostAddress(reinterpret_cast<sockaddr*>(&storage)));
+            this->setPeerPort(ntohs(storage.ss_family == AF_INET6 ? reinterpret_cast<sockaddr_in6*>(&storage)->sin6_port
+                                                                  : reinterpret_cast<sockaddr_in*>(&storage)->sin_port));
+        }
+    #endif
+
+    this->readBuffer.clear();
+    this->readOffset = 0;
+    this->setSocketError(UnknownSocketError);
+    this->setSocketState(state);
+
+    // The data is buffered by the ring and by this socket, QIODevice does not need to buffer it once more
+    QIODevice::open(openMode | QIODevice::Unbuffered);
+    return true;
+}
+
+void HttpUringSocket::connectToHost(const QString &hostName, quint16 port, OpenMode openMode, NetworkLayerProtocol protocol)
+{
+    Q_UNUSED(hostName)
+    Q_UNUSED(port)
+    Q_UNUSED(openMode)
+    Q_UNUSED(protocol)
+}
+
+void HttpUringSocket::disconnectFromHost()
+{
+    if (this->state() == UnconnectedState)
+    {
+        return;
+    }
+
+    // sent() closes the connection when the rest has been sent
+    if (this->bytesToWrite() > 0)
+    {
+        this->setSocketState(ClosingState);
+        return;
+    }
+
+    this->close();
+}
+
+void HttpUringSocket::close()
+{
+    const bool connected = this->state() != UnconnectedState;
+
+    this->uring->close(this->channel);
+    this->channel = nullptr;
+
+    this->readBuffer.clear();
+    this->readOffset = 0;
+
+    if (this->isOpen())
+    {
+        QIODevice::close();
+    }
+
+    this->setSocketState(UnconnectedState);
+
+    if (connected)
+    {
+        emit this->disconnected();
+    }
+}
+
+qint64 HttpUringSocket::bytesAvailable() const
+{
+    return this->readBuffer.size() - this->readOffset + QIODevice::bytesAvailable();
+}
+
+qint64 HttpUringSocket::bytesToWrite() const
+{
+    return this->channel ? this->uring->getPendingBytes(this->channel) : 0;
+}
+
+bool HttpUringSocket::canReadLine() const
+{
+    return this->readBuffer.indexOf('\n', this->readOffset) != -1 || QIODevice::canReadLine();
+}
+
+bool HttpUringSocket::waitForReadyRead(int msecs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 received = this->receivedBytes;
+
+    while (this->channel && this->receivedBytes == received)
+    {
+        const int remaining = msecs < 0 ? -1 : msecs - static_cast<int>(timer.elapsed());
+        if ((msecs >= 0 && remaining <= 0) || !this->uring->wait(this->channel, remaining))
+        {
+            this->setSocketError(SocketTimeoutError);
+            this->setErrorString(tr("Socket operation timed out"));
+            return false;
+        }
+    }
+
+    return this->receivedBytes != received;
+}
+
+bool HttpUringSocket::waitForBytesWritten(int msecs)
+{
+    if (this->bytesToWrite() == 0)
+    {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 sent = this->sentBytes;
+
+    while (this->channel && this->sentBytes == sent)
+    {
+        const int remaining = msecs < 0 ? -1 : msecs - static_cast<int>(timer.elapsed());
+        if ((msecs >= 0 && remaining <= 0) || !this->uring->wait(this->channel, remaining))
+        {
+            this->setSocketError(SocketTimeoutError);
+            this->setErrorString(tr("Socket operation timed out"));
+            return false;
+        }
+    }
+
+    return this->sentBytes != sent;
+}
+
+qint64 HttpUringSocket::readData(char *data, qint64 maxSize)
+{
+    const int size = static_cast<int>(qMin(maxSize, static_cast<qint64>(this->readBuffer.size() - this->readOffset)));
+
+    if (size == 0 && !this->channel)
+    {
+        return -1;
+    }
+
+    memcpy(data, this->readBuffer.constData() + this->readOffset, static_cast<size_t>(size));
+    this->consume(size);
+    return size;
+}
+
+qint64 HttpUringSocket::readLineData(char *data, qint64 maxSize)
+{
+    const int end = this->readBuffer.indexOf('\n', this->readOffset);
+    const qint64 lineSize = end == -1 ? this->readBuffer.size() - this->readOffset : end - this->readOffset + 1;
+    return this->readData(data, qMin(maxSize, lineSize));
+}
+
+qint64 HttpUringSocket::writeData(const char *data, qint64 size)
+{
+    if (!this->channel || this->state() != ConnectedState)
+    {
+        this->setSocketError(NetworkError);
+        this->setErrorString(tr("Socket is not connected"));
+        return -1;
+    }
+
+    this->uring->send(this->channel, data, size);
+    return size;
+}
+
+void HttpUringSocket::consume(int size)
+{
+    this->readOffset += size;
+
+    if (this->readOffset == this->readBuffer.size())
+    {
+        this->readBuffer.clear();
+        this->readOffset = 0;
+    }
+}
+
+void HttpUringSocket::received(const char *data, qint64 size)
+{
+    this->readBuffer.append(data, static_cast<int>(size));
+    this->receivedBytes += size;
+
+    if (!this->emittingReadyRead)
+    {
+        this->emittingReadyRead = true;
+        emit this->readyRead();
+        this->emittingReadyRead = false;
+    }
+}
+
+void HttpUringSocket::sent(qint64 size)
+{
+    this->sentBytes += size;
+    emit this->bytesWritten(size);
+
+    if (this->state() == ClosingState && this->bytesToWrite() == 0)
+    {
+        this->close();
+    }
+}
+
+void HttpUringSocket::failed(int error)
+{
+    if (error == 0)
+    {
+        this->setSocketError(RemoteHostClosedError);
+        this->setErrorString(tr("The remote host closed the connection"));
+    }
+
+    else
+    {
+        this->setSocketError(NetworkError);
+        #ifdef Q_OS_UNIX
+            this->setErrorString(QString::fromLocal8Bit(strerror(error)));
+        #endif
+    }
+
+    this->close();
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
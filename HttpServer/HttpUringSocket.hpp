@@ -0,0 +1,106 @@
+#ifndef HTTPURINGSOCKET_HPP
+#define HTTPURINGSOCKET_HPP
+
+#include <QByteArray>
+#include <QTcpSocket>
+
+#include "HttpGlobal.hpp"
+#include "HttpUring.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  TCP socket of an accepted connection that does its I/O through a HttpUring instead of the
+  socket engine of Qt. HttpConnection, HttpRequest and HttpResponse use it like any other
+  QTcpSocket: readyRead(), bytesWritten() and disconnected() are emitted as usual, and
+  waitForBytesWritten() blocks on the ring.
+  <p>
+  Written data is queued in the ring and sent when control returns to the event loop, so all
+  writes of a response go out with one send, and the sends of all connections of the thread
+  with one system call. socketDescriptor() returns -1, because the ring owns the socket;
+  the connection can therefore not be parked and is not corked.
+  <p>
+  Only server side connections are supported, connectToHost() does nothing.
+*/
+
+class DECLSPEC HttpUringSocket : public QTcpSocket, public HttpUring::Handler
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpUringSocket)
+
+public:
+
+    /**
+      Constructor.
+      @param uring Ring of the thread that the socket lives in
+      @param parent Parent object
+    */
+    HttpUringSocket(HttpUring *uring, QObject *parent = nullptr);
+
+    /** Destructor */
+    virtual ~HttpUringSocket();
+
+    /** Register an accepted connection at the ring, which takes ownership of the descriptor */
+    bool setSocketDescriptor(qintptr socketDescriptor, SocketState state = ConnectedState, OpenMode openMode = ReadWrite);
+
+    /** Does nothing, only accepted connections are supported */
+    void connectToHost(const QString &hostName, quint16 port, OpenMode openMode = ReadWrite, NetworkLayerProtocol protocol = AnyIPProtocol);
+
+    /** Close the connection after all queued data has been sent */
+    void disconnectFromHost();
+
+    /** Close the connection at once */
+    void close();
+
+    qint64 bytesAvailable() const;
+
+    qint64 bytesToWrite() const;
+
+    bool canReadLine() const;
+
+    bool waitForReadyRead(int msecs = 30000);
+
+    bool waitForBytesWritten(int msecs = 30000);
+
+protected:
+
+    qint64 readData(char *data, qint64 maxSize);
+
+    qint64 readLineData(char *data, qint64 maxSize);
+
+    qint64 writeData(const char *data, qint64 size);
+
+private:
+
+    /** Ring of the thread */
+    HttpUring *uring = nullptr;
+
+    /** Registration of the connection at the ring, `nullptr` while not connected */
+    HttpUring::Channel *channel = nullptr;
+
+    /** Received data that has not been read yet, starting at readOffset */
+    QByteArray readBuffer;
+
+    /** Position of the first unread byte in readBuffer */
+    int readOffset = 0;
+
+    /** Set while readyRead() is emitted, like QAbstractSocket the signal is not emitted recursively */
+    bool emittingReadyRead = false;
+
+    /** Counters for the wait functions */
+    qint64 receivedBytes = 0;
+    qint64 sentBytes = 0;
+
+    /** Remove the read part of the buffer */
+    void consume(int size);
+
+    /** Handler of the ring */
+    void received(const char *data, qint64 size);
+    void sent(qint64 size);
+    void failed(int error);
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPURINGSOCKET_HPP
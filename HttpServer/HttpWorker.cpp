@@ -0,0 +1,186 @@
+#include "HttpWorker.hpp"
+#include "HttpEventDispatcher.hpp"
+#include "HttpThreadPlacement.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpWorker::HttpWorker(HttpServerSettings *settings, HttpRequestHandler *requestHandler, QSslConfiguration *sslConfiguration,
+                       int index, HttpServerMetrics *metrics, HttpClientLimiter *limiter)
+    : QThread()
+{
+    Q_ASSERT(requestHandler != nullptr);
+
+    this->settings = settings;
+    this->requestHandler = requestHandler;
+    this->sslConfiguration = sslConfiguration;
+    this->metrics = metrics;
+    this->limiter = limiter;
+
+    // The node is known before the thread starts, so that the pool can steer connections at once
+    if (!this->settings->workerCpus.isEmpty())
+    {
+        this->cpu = this->settings->workerCpus.at(index % this->settings->workerCpus.size());
+        this->node = HttpThreadPlacement::getNodeOfCpu(this->cpu);
+    }
+
+    // The channel and the wheel are children, so they move into the thread together with this worker
+    this->handoff = new HttpHandoffChannel(1024, this);
+    this->timerWheel = new HttpTimerWheel(100, 512, this);
+    QObject::connect(this->handoff, &HttpHandoffChannel::received, this, &HttpWorker::handleConnection);
+
+    // The dispatcher must be installed before the thread starts, otherwise Qt creates its own
+    if (HttpEventDispatcher *dispatcher = HttpEventDispatcher::create())
+    {
+        this->setEventDispatcher(dispatcher);
+    }
+
+    // execute signals in my own thread
+    this->moveToThread(this);
+
+    qDebug("HttpWorker (%p): constructed", this);
+    this->start();
+}
+
+HttpWorker::~HttpWorker()
+{
+    this->quit();
+    this->wait();
+    qDebug("HttpWorker (%p): destroyed", this);
+}
+
+void HttpWorker::run()
+{
+    qDebug("HttpWorker (%p): thread started", this);
+
+    QList<int> cpus;
+    if (this->cpu >= 0 && HttpThreadPlacement::pinCurrentThread(QList<int>() << this->cpu))
+    {
+        cpus.append(this->cpu);
+    }
+
+    if (this->metrics)
+    {
+        this->metrics->registerThread("worker", this, cpus, cpus.isEmpty() ? -1 : this->node);
+    }
+
+    // The ring must be created in the thread that submits to it
+    if (this->settings->ioUring && !this->sslConfiguration)
+    {
+        this->uring = HttpUring::create(256, 16384, this);
+        if (!this->uring)
+        {
+            qDebug("HttpWorker (%p): io_uring is not available, using the socket notifiers", this);
+        }
+    }
+
+    this->handoff->attach();
+
+    try
+    {
+        this->exec();
+    }
+
+    catch (...)
+    {
+        qCritical("HttpWorker (%p): an uncatched exception occured in the thread", this);
+    }
+
+    for (HttpConnection *connection : this->connections)
+    {
+        delete connection;
+    }
+
+    this->connections.clear();
+    this->handoff->detach();
+
+    // After the connections, because their sockets are registered at the ring
+    delete this->uring;
+    this->uring = nullptr;
+
+    if (this->metrics)
+    {
+        this->metrics->unregisterThread(this);
+    }
+
+    qDebug("HttpWorker (%p): thread stopped", this);
+}
+
+void HttpWorker::assignConnection(tSocketDescriptor socketDescriptor)
+{
+    this->connectionCount.ref();
+
+    // The descriptor is passed via the handoff channel because the worker lives in another thread.
+    // Only if the channel is full, it takes the slower way through the event queue.
+    if (!this->handoff->push(socketDescriptor))
+    {
+        QMetaObject::invokeMethod(this, "handleConnection", Qt::QueuedConnection, Q_ARG(tSocketDescriptor, socketDescriptor));
+    }
+}
+
+int HttpWorker::getConnectionCount() const
+{
+    return this->connectionCount.load();
+}
+
+int HttpWorker::getNode() const
+{
+    return this->node;
+}
+
+void HttpWorker::handleConnection(tSocketDescriptor socketDescriptor)
+{
+    HttpConnection *connection = new HttpConnection(this->settings, this->requestHandler, this->timerWheel, this->limiter, this->metrics,
+                                                    this->sslConfiguration, this->uring);
+
+    if (!connection->open(socketDescriptor))
+    {
+        delete connection;
+        this->connectionCount.deref();
+        emit this->connectionReleased();
+        return;
+    }
+
+    QObject::connect(connection, &HttpConnection::closed, this, &HttpWorker::connectionClosed);
+    this->connections.insert(connection);
+
+    if (this->draining)
+    {
+        connection->drain();
+    }
+
+    #ifdef QTWEBAPP_SUPERVERBOSE
+        qDebug("HttpWorker (%p): serving %i connections", this, this->connections.size());
+    #endif
+}
+
+void HttpWorker::drain()
+{
+    QMetaObject::invokeMethod(this, "drainConnections", Qt::QueuedConnection);
+}
+
+void HttpWorker::drainConnections()
+{
+    this->draining = true;
+
+    // Closing an idle connection may remove it from the set
+    const QSet<HttpConnection*> connections = this->connections;
+    for (HttpConnection *connection : connections)
+    {
+        connection->drain();
+    }
+}
+
+void HttpWorker::connectionClosed()
+{
+    HttpConnection *connection = static_cast<HttpConnection*>(this->sender());
+
+    if (this->connections.remove(connection))
+    {
+        // The connection may still be on the call stack, so delete it later
+        connection->deleteLater();
+        this->connectionCount.deref();
+        emit this->connectionReleased();
+    }
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
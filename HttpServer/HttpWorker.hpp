@@ -0,0 +1,146 @@
+#ifndef HTTPWORKER_HPP
+#define HTTPWORKER_HPP
+
+#include <QAtomicInt>
+#include <QSet>
+#include <QThread>
+
+#include "HttpGlobal.hpp"
+#include "HttpConnection.hpp"
+#include "HttpHandoffChannel.hpp"
+#include "HttpTimerWheel.hpp"
+#include "HttpUring.hpp"
+#include "HttpRequestHandler.hpp"
+#include "HttpServerMetrics.hpp"
+#include "HttpServerSettings.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  A worker thread of the event loop connection engine. Unlike HttpConnectionHandler,
+  a worker serves any number of connections at the same time: each connection is an
+  HttpConnection object that lives in the event loop of this thread, and idle keep-alive
+  clients cost no more than their socket.
+  <p>
+  Requests of different connections of the same worker are processed one after the other,
+  so a slow HttpRequestHandler::service() delays all other connections of this worker.
+  <p>
+  On Linux, the worker thread runs a HttpEventDispatcher, which waits for the sockets with epoll,
+  so a wakeup only costs time for the connections that are ready. On other platforms the default
+  dispatcher of Qt is used, which scans the notifiers of all connections of the thread on every
+  wakeup, so there the cost of an event grows with the number of connections.
+  <p>
+  If workerCpus is configured, the worker pins its thread to one CPU of that list,
+  selected by the index of the worker.
+  <p>
+  With ioUring, the connections of a worker do their I/O through one HttpUring instead of the
+  socket notifiers of Qt, if the library has been built with io_uring support and the kernel
+  supports it. SSL connections always use the socket notifiers.
+  @see HttpWorkerPool which creates the workers and distributes the connections.
+*/
+class DECLSPEC HttpWorker : public QThread
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpWorker)
+
+public:
+
+    /**
+      Constructor.
+      @param settings Configuration settings of the HTTP webserver
+      @param requestHandler Handler that will process each incoming HTTP request
+      @param sslConfiguration SSL (HTTPS) will be used if not `nullptr`
+      @param index Number of this worker in the pool, selects the CPU from workerCpus
+      @param metrics Counters of the listener, may be `nullptr`
+      @param limiter Limits of the client addresses, may be `nullptr`
+    */
+    HttpWorker(HttpServerSettings *settings, HttpRequestHandler *requestHandler, QSslConfiguration *sslConfiguration = nullptr,
+               int index = 0, HttpServerMetrics *metrics = nullptr, HttpClientLimiter *limiter = nullptr);
+
+    /** Destructor, closes all connections of this worker */
+    virtual ~HttpWorker();
+
+    /**
+      Pass a new connection to this worker. This method is thread safe,
+      the connection is opened in the thread of the worker.
+      @param socketDescriptor references the accepted connection.
+    */
+    void assignConnection(tSocketDescriptor socketDescriptor);
+
+    /** Number of connections that are assigned to this worker */
+    int getConnectionCount() const;
+
+    /** NUMA node that this worker is pinned to, -1 if not pinned or unknown */
+    int getNode() const;
+
+    /** Close all connections as soon as they are idle, see HttpConnection::drain(). This method is thread safe. */
+    void drain();
+
+signals:
+
+    /** Emitted in the thread of this worker when an assigned connection has been closed or could not be opened */
+    void connectionReleased();
+
+private:
+
+    /** Configuration settings */
+    HttpServerSettings *settings = nullptr;
+
+    /** Will be assigned to each connection */
+    HttpRequestHandler *requestHandler = nullptr;
+
+    /** Configuration for SSL */
+    QSslConfiguration *sslConfiguration = nullptr;
+
+    /** Counters of the listener */
+    HttpServerMetrics *metrics = nullptr;
+
+    /** Limits of the client addresses */
+    HttpClientLimiter *limiter = nullptr;
+
+    /** CPU that the thread is pinned to, -1 if not pinned */
+    int cpu = -1;
+
+    /** NUMA node of the CPU */
+    int node = -1;
+
+    /** Open connections, only accessed from the thread of this worker */
+    QSet<HttpConnection*> connections;
+
+    /** Assigned connections, including the ones that are not opened yet */
+    QAtomicInt connectionCount;
+
+    /** Passes new connections into the thread of this worker */
+    HttpHandoffChannel *handoff = nullptr;
+
+    /** Timeouts of all connections of this worker */
+    HttpTimerWheel *timerWheel = nullptr;
+
+    /** I/O of all connections of this worker, `nullptr` if io_uring is not used */
+    HttpUring *uring = nullptr;
+
+    /** Set by drain(), only used in the thread of this worker */
+    bool draining = false;
+
+    /** Executes the threads own event loop */
+    void run();
+
+private slots:
+
+    /**
+      Open a new connection in the thread of this worker.
+      @param socketDescriptor references the accepted connection.
+    */
+    void handleConnection(tSocketDescriptor socketDescriptor);
+
+    /** Received from a connection when the client has disconnected */
+    void connectionClosed();
+
+    /** Drain all connections in the thread of this worker */
+    void drainConnections();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPWORKER_HPP
@@ -0,0 +1,164 @@
+#include "HttpWorkerPool.hpp"
+#include "HttpThreadPlacement.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+HttpWorkerPool::HttpWorkerPool(HttpServerSettings *settings, HttpRequestHandler *requestHandler, HttpPendingQueue *pendingQueue,
+                               HttpServerMetrics *metrics, HttpClientLimiter *limiter)
+    : QObject()
+{
+    this->settings = settings;
+    this->pendingQueue = pendingQueue;
+    this->metrics = metrics;
+    this->sslConfiguration = HttpConnection::createSslConfiguration(this->settings);
+
+    int workerCount = static_cast<int>(this->settings->workerThreads);
+    if (workerCount <= 0)
+    {
+        workerCount = qMax(QThread::idealThreadCount(), 1);
+    }
+
+    for (int i = 0; i < workerCount; ++i)
+    {
+        HttpWorker *worker = new HttpWorker(this->settings, requestHandler, this->sslConfiguration, i, this->metrics, limiter);
+
+        // the worker emits this signal in its own thread, the counters and the pending queue are safe to use from there
+        QObject::connect(worker, &HttpWorker::connectionReleased, this, &HttpWorkerPool::connectionReleased, Qt::DirectConnection);
+        this->workers.append(worker);
+    }
+
+    qDebug("HttpWorkerPool (%p): started %i workers", this, workerCount);
+}
+
+HttpWorkerPool::~HttpWorkerPool()
+{
+    // delete all workers and wait until their threads are closed
+
+    for (HttpWorker *worker : this->workers)
+    {
+        delete worker;
+    }
+
+    delete this->sslConfiguration;
+    this->sslConfiguration = nullptr;
+    qDebug("HttpWorkerPool (%p): destroyed", this);
+}
+
+bool HttpWorkerPool::dispatch(tSocketDescriptor socketDescriptor)
+{
+    if (!this->reserveConnection())
+    {
+        return false;
+    }
+
+    this->assignConnection(socketDescriptor);
+    return true;
+}
+
+void HttpWorkerPool::servePending()
+{
+    if (!this->pendingQueue)
+    {
+        return;
+    }
+
+    tSocketDescriptor socketDescriptor;
+
+    while (!this->pendingQueue->isEmpty() && this->reserveConnection())
+    {
+        // Another thread may have taken the last waiting connection in the meantime
+        if (!this->pendingQueue->take(socketDescriptor))
+        {
+            this->connectionCount.deref();
+            break;
+        }
+
+        this->assignConnection(socketDescriptor);
+    }
+}
+
+void HttpWorkerPool::drain()
+{
+    for (HttpWorker *worker : this->workers)
+    {
+        worker->drain();
+    }
+}
+
+int HttpWorkerPool::getConnectionCount() const
+{
+    return this->connectionCount.load();
+}
+
+bool HttpWorkerPool::reserveConnection()
+{
+    for (;;)
+    {
+        const int count = this->connectionCount.loadAcquire();
+        if (static_cast<quint32>(count) >= this->settings->maxConnections)
+        {
+            return false;
+        }
+
+        if (this->connectionCount.testAndSetOrdered(count, count + 1))
+        {
+            return true;
+        }
+    }
+}
+
+void HttpWorkerPool::assignConnection(tSocketDescriptor socketDescriptor)
+{
+    int node = -1;
+    if (this->settings->steerConnections)
+    {
+        node = HttpThreadPlacement::getNodeOfCpu(HttpThreadPlacement::getIncomingCpu(socketDescriptor));
+    }
+
+    HttpWorker *worker = this->getIdlestWorker(node);
+
+    if (node >= 0 && this->metrics)
+    {
+        this->metrics->addPlacedConnection(worker->getNode() == node);
+    }
+
+    worker->assignConnection(socketDescriptor);
+}
+
+HttpWorker *HttpWorkerPool::getIdlestWorker(int node) const
+{
+    HttpWorker *idlestWorker = this->workers.first();
+    HttpWorker *idlestLocalWorker = nullptr;
+
+    for (HttpWorker *worker : this->workers)
+    {
+        if (worker->getConnectionCount() < idlestWorker->getConnectionCount())
+        {
+            idlestWorker = worker;
+        }
+
+        if (node >= 0 && worker->getNode() == node &&
+            (!idlestLocalWorker || worker->getConnectionCount() < idlestLocalWorker->getConnectionCount()))
+        {
+            idlestLocalWorker = worker;
+        }
+    }
+
+    // Stay on the node unless its workers are much busier than the rest
+    if (idlestLocalWorker && idlestLocalWorker->getConnectionCount() <= 2 * idlestWorker->getConnectionCount() + 1)
+    {
+        return idlestLocalWorker;
+    }
+
+    return idlestWorker;
+}
+
+void HttpWorkerPool::connectionReleased()
+{
+    this->connectionCount.deref();
+
+    // Give the free slot to the oldest waiting connection, if any
+    this->servePending();
+}
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
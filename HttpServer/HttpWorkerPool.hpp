@@ -0,0 +1,124 @@
+#ifndef HTTPWORKERPOOL_HPP
+#define HTTPWORKERPOOL_HPP
+
+#include <QAtomicInt>
+#include <QList>
+#include <QObject>
+
+#include "HttpGlobal.hpp"
+#include "HttpPendingQueue.hpp"
+#include "HttpServerMetrics.hpp"
+#include "HttpWorker.hpp"
+#include "HttpServerSettings.hpp"
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_BEGIN
+
+/**
+  Fixed set of HttpWorker threads, used by the listener when the connection engine
+  is set to HttpServerSettings::EventLoop.
+  <p>
+  Example for the required configuration settings:
+  <code><pre>
+  connectionEngine=EventLoop
+  workerThreads=0
+  maxConnections=10000
+  readTimeout=60000
+  ;sslKeyFile=ssl/my.key
+  ;sslCertFile=ssl/my.cert
+  ;workerCpus=0-7
+  ;steerConnections=false
+  </pre></code>
+  All workers are started together with the pool. workerThreads=0 creates one worker
+  per CPU core. Each new connection is passed to the worker with the fewest connections.
+  When maxConnections connections are open, new connections wait in the pending queue
+  until another connection has been closed.
+  <p>
+  With workerCpus, each worker is pinned to one CPU of the list in turn. If steerConnections
+  is enabled in addition, the pool asks the kernel which CPU has received the packets of a new
+  connection (SO_INCOMING_CPU, Linux only) and prefers the idlest worker on the NUMA node of that
+  CPU, so the request data stays in the memory of the node that the network card writes to.
+  Workers of other nodes are used when the local workers have more than twice as many connections.
+  <p>
+  The settings minThreads, maxThreads and cleanupInterval are not used by this engine.
+  @see HttpConnectionHandlerPool for the description of the SSL settings
+*/
+
+class DECLSPEC HttpWorkerPool : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(HttpWorkerPool)
+
+public:
+
+    /**
+      Constructor.
+      @param settings Configuration settings for the HTTP server. Must not be 0.
+      @param requestHandler The handler that will process each received HTTP request.
+      @param pendingQueue Connections that wait for a free slot, may be `nullptr`.
+      @param metrics Counters of the listener, may be `nullptr`.
+      @param limiter Limits of the client addresses, may be `nullptr`.
+    */
+    HttpWorkerPool(HttpServerSettings *settings, HttpRequestHandler *requestHandler, HttpPendingQueue *pendingQueue = nullptr,
+                   HttpServerMetrics *metrics = nullptr, HttpClientLimiter *limiter = nullptr);
+
+    /** Destructor, stops all workers */
+    virtual ~HttpWorkerPool();
+
+    /**
+      Pass a new connection to the least loaded worker.
+      @param socketDescriptor references the accepted connection.
+      @return false if the maximum number of connections is reached.
+    */
+    bool dispatch(tSocketDescriptor socketDescriptor);
+
+    /** Pass waiting connections from the pending queue to the workers. This method is thread safe. */
+    void servePending();
+
+    /** Close all connections as soon as they are idle. This method is thread safe. */
+    void drain();
+
+    /** Number of open connections. This method is thread safe. */
+    int getConnectionCount() const;
+
+private:
+
+    /** Settings for this pool */
+    HttpServerSettings *settings = nullptr;
+
+    /** The worker threads */
+    QList<HttpWorker*> workers;
+
+    /** The SSL configuration (certificate, key and other settings) */
+    QSslConfiguration *sslConfiguration = nullptr;
+
+    /** Connections that wait for a free slot */
+    HttpPendingQueue *pendingQueue = nullptr;
+
+    /** Counters of the listener */
+    HttpServerMetrics *metrics = nullptr;
+
+    /** Number of connections of all workers, including the reserved ones */
+    QAtomicInt connectionCount;
+
+    /** Reserve a slot for a new connection, returns false if maxConnections is reached */
+    bool reserveConnection();
+
+    /**
+      Returns the worker with the fewest connections.
+      @param node Prefer the workers of this NUMA node, -1 for any worker
+    */
+    HttpWorker *getIdlestWorker(int node = -1) const;
+
+    /** Pass a connection with a reserved slot to a worker */
+    void assignConnection(tSocketDescriptor socketDescriptor);
+
+private slots:
+
+    /** Received from a worker in its own thread when one of its connections has been closed */
+    void connectionReleased();
+
+};
+
+QTWEBAPP_HTTPSERVER_NAMESPACE_END
+
+#endif // HTTPWORKERPOOL_HPP
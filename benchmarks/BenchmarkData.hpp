@@ -0,0 +1,41 @@
+#ifndef BENCHMARKDATA_HPP
+#define BENCHMARKDATA_HPP
+
+#include <QByteArray>
+
+/** Sample data that several benchmarks share */
+namespace BenchmarkData
+{
+    /** Head of a request from a command line client */
+    inline QByteArray smallHead()
+    {
+        return QByteArray("GET /index.html HTTP/1.1\r\n"
+                          "Host: www.example.com\r\n"
+                          "User-Agent: curl/8.5.0\r\n"
+                          "Accept: */*\r\n"
+                          "\r\n");
+    }
+
+    /** Head of a request from a web browser, with a query string and cookies */
+    inline QByteArray browserHead()
+    {
+        return QByteArray("GET /shop/search?q=red+shoes&size=42&sort=price&page=2 HTTP/1.1\r\n"
+                          "Host: www.example.com\r\n"
+                          "Connection: keep-alive\r\n"
+                          "Cache-Control: max-age=0\r\n"
+                          "Upgrade-Insecure-Requests: 1\r\n"
+                          "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+                          "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+                          "Sec-Fetch-Site: same-origin\r\n"
+                          "Sec-Fetch-Mode: navigate\r\n"
+                          "Sec-Fetch-User: ?1\r\n"
+                          "Sec-Fetch-Dest: document\r\n"
+                          "Referer: https://www.example.com/shop/search?q=shoes\r\n"
+                          "Accept-Encoding: gzip, deflate, br\r\n"
+                          "Accept-Language: de-DE,de;q=0.9,en-US;q=0.8,en;q=0.7\r\n"
+                          "Cookie: sessionid=6f1c2a9d0b7e4c3f8a5d; theme=dark; cart=3%2C17%2C42; consent=necessary%2Cstatistics\r\n"
+                          "\r\n");
+    }
+}
+
+#endif // BENCHMARKDATA_HPP
@@ -0,0 +1,11 @@
+QT += testlib
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+# Measurements are only meaningful with optimizations
+CONFIG -= debug
+CONFIG += release
+
+include($$PWD/../HttpServer.pri)
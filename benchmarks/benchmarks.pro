@@ -0,0 +1,14 @@
+# Microbenchmarks of the HttpServer, each one is a QtTest executable.
+# Build with "qmake && make", then run a benchmark from its directory, e.g.
+#   handlerqueue/handlerqueue -median 5
+# QtTest measures the wall time by default, see "-help" for the CPU tick counter,
+# callgrind and (on Linux) perf counters.
+TEMPLATE = subdirs
+
+SUBDIRS = handlerqueue \
+          handoff \
+          timerwheel \
+          requestparser \
+          scanner \
+          lazydecoding \
+          urldecode
@@ -0,0 +1,131 @@
+#include <QList>
+#include <QThread>
+#include <QtTest>
+
+#include <QtWebApp/HttpServer/HttpConnectionHandlerPool>
+#include <QtWebApp/HttpServer/HttpRequestHandler>
+
+using namespace QtWebApp::HttpServer;
+
+namespace
+{
+    /** Connections that each acquirer takes in one run */
+    const int rounds = 20000;
+}
+
+/** Stands in for an accepting thread, it takes handlers from the pool and gives them back at once */
+class Acquirer : public QThread
+{
+    Q_OBJECT
+
+public:
+
+    explicit Acquirer(HttpConnectionHandlerPool *pool)
+        : QThread()
+    {
+        this->pool = pool;
+    }
+
+protected:
+
+    void run()
+    {
+        int taken = 0;
+        while (taken < rounds)
+        {
+            HttpConnectionHandler *handler = this->pool->getConnectionHandler();
+            if (!handler)
+            {
+                // All handlers are taken by the other acquirers
+                QThread::yieldCurrentThread();
+                continue;
+            }
+
+            // Like a closed connection, the handler puts itself back into the pool
+            emit handler->released(handler);
+            ++taken;
+        }
+    }
+
+private:
+
+    HttpConnectionHandlerPool *pool = nullptr;
+
+};
+
+/**
+  Cost of taking an idle handler from HttpConnectionHandlerPool::getConnectionHandler() for a
+  new connection and giving it back through the released() signal of the handler, while
+  several threads do the same on one pool.
+  <p>
+  The pool has a fixed size, so the sizing thread does not start or stop handlers during
+  the measurement. Each run takes and releases 20000 handlers per acquirer thread.
+*/
+
+class HandlerQueueBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void acquireRelease_data();
+    void acquireRelease();
+
+};
+
+void HandlerQueueBenchmark::acquireRelease_data()
+{
+    QTest::addColumn<int>("handlerCount");
+    QTest::addColumn<int>("acquirerCount");
+
+    QTest::newRow("16 handlers, 1 acquirer") << 16 << 1;
+    QTest::newRow("16 handlers, 4 acquirers") << 16 << 4;
+    QTest::newRow("16 handlers, 8 acquirers") << 16 << 8;
+    QTest::newRow("256 handlers, 1 acquirer") << 256 << 1;
+    QTest::newRow("256 handlers, 4 acquirers") << 256 << 4;
+    QTest::newRow("256 handlers, 8 acquirers") << 256 << 8;
+}
+
+void HandlerQueueBenchmark::acquireRelease()
+{
+    QFETCH(int, handlerCount);
+    QFETCH(int, acquirerCount);
+
+    HttpServerSettings settings;
+    settings.minThreads = static_cast<quint32>(handlerCount);
+    settings.maxThreads = static_cast<quint32>(handlerCount);
+    settings.cleanupInterval = 60000U;
+
+    HttpRequestHandler requestHandler;
+    HttpConnectionHandlerPool pool(&settings, &requestHandler);
+
+    // The sizing thread starts the handlers in the background
+    QTRY_COMPARE_WITH_TIMEOUT(pool.getPoolSize(), handlerCount, 30000);
+    QTRY_COMPARE(pool.getConnectionCount(), 0);
+
+    QList<Acquirer*> acquirers;
+    for (int i = 0; i < acquirerCount; ++i)
+    {
+        acquirers.append(new Acquirer(&pool));
+    }
+
+    QBENCHMARK
+    {
+        for (Acquirer *acquirer : acquirers)
+        {
+            acquirer->start();
+        }
+
+        for (Acquirer *acquirer : acquirers)
+        {
+            acquirer->wait();
+        }
+    }
+
+    QCOMPARE(pool.getConnectionCount(), 0);
+    qDeleteAll(acquirers);
+}
+
+QTEST_MAIN(HandlerQueueBenchmark)
+
+#include "HandlerQueueBenchmark.moc"
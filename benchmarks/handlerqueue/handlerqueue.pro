@@ -0,0 +1,5 @@
+TARGET = handlerqueue
+
+include(../benchmarks.pri)
+
+SOURCES += HandlerQueueBenchmark.cpp
@@ -0,0 +1,131 @@
+#include <QSemaphore>
+#include <QThread>
+#include <QTimer>
+#include <QtTest>
+
+#include <QtWebApp/HttpServer/HttpHandoffChannel>
+
+using namespace QtWebApp::HttpServer;
+
+namespace
+{
+    /** Descriptor that is passed around but never opened or closed */
+    const tSocketDescriptor fakeDescriptor = 1 << 20;
+}
+
+/** Stands in for a connection handler or worker, it lives in the receiving thread */
+class Receiver : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit Receiver(QSemaphore *semaphore)
+        : QObject()
+    {
+        this->semaphore = semaphore;
+    }
+
+public slots:
+
+    /** Tells the benchmark that the connection has arrived */
+    void handleConnection(tSocketDescriptor socketDescriptor)
+    {
+        Q_UNUSED(socketDescriptor)
+        this->semaphore->release();
+    }
+
+private:
+
+    QSemaphore *semaphore = nullptr;
+
+};
+
+/**
+  Latency from passing an accepted socket to another thread until that thread has received it.
+  <p>
+  queuedCall() is the former way of the listener, a queued call of the slot handleConnection().
+  handoffChannel() pushes the descriptor into a HttpHandoffChannel. Each iteration passes one
+  descriptor and waits until the receiving thread has got it, so the receiver is idle and has
+  to be woken up every time, like at the start of a new connection.
+*/
+
+class HandoffBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void initTestCase();
+    void cleanupTestCase();
+
+    void queuedCall();
+    void handoffChannel();
+
+private:
+
+    /** The receiving thread */
+    QThread thread;
+
+    /** Released by the receivers */
+    QSemaphore semaphore;
+
+    /** Receives the queued calls */
+    Receiver *receiver = nullptr;
+
+    /** Receives the descriptors of the channel */
+    Receiver *channelReceiver = nullptr;
+
+    HttpHandoffChannel *channel = nullptr;
+
+};
+
+void HandoffBenchmark::initTestCase()
+{
+    qRegisterMetaType<tSocketDescriptor>("tSocketDescriptor");
+
+    this->receiver = new Receiver(&this->semaphore);
+    this->channelReceiver = new Receiver(&this->semaphore);
+    this->channel = new HttpHandoffChannel(1024);
+    QObject::connect(this->channel, &HttpHandoffChannel::received, this->channelReceiver, &Receiver::handleConnection);
+
+    for (QObject *object : {static_cast<QObject*>(this->receiver), static_cast<QObject*>(this->channelReceiver), static_cast<QObject*>(this->channel)})
+    {
+        object->moveToThread(&this->thread);
+        QObject::connect(&this->thread, &QThread::finished, object, &QObject::deleteLater);
+    }
+
+    this->thread.start();
+
+    // The channel must be attached in the receiving thread
+    HttpHandoffChannel *channel = this->channel;
+    QTimer::singleShot(0, channel, [channel]() { channel->attach(); });
+}
+
+void HandoffBenchmark::cleanupTestCase()
+{
+    this->thread.quit();
+    this->thread.wait();
+}
+
+void HandoffBenchmark::queuedCall()
+{
+    QBENCHMARK
+    {
+        QMetaObject::invokeMethod(this->receiver, "handleConnection", Qt::QueuedConnection, Q_ARG(tSocketDescriptor, fakeDescriptor));
+        this->semaphore.acquire();
+    }
+}
+
+void HandoffBenchmark::handoffChannel()
+{
+    QBENCHMARK
+    {
+        QVERIFY(this->channel->push(fakeDescriptor));
+        this->semaphore.acquire();
+    }
+}
+
+QTEST_MAIN(HandoffBenchmark)
+
+#include "HandoffBenchmark.moc"
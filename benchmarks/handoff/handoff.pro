@@ -0,0 +1,5 @@
+TARGET = handoff
+
+include(../benchmarks.pri)
+
+SOURCES += HandoffBenchmark.cpp
@@ -0,0 +1,167 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <QtTest>
+
+#include <QtWebApp/HttpServer/HttpRequest>
+
+#include "../BenchmarkData.hpp"
+
+using namespace QtWebApp;
+using namespace QtWebApp::HttpServer;
+
+namespace
+{
+    /** Number of heap allocations of the process */
+    std::atomic<qint64> allocationCount{0};
+}
+
+#ifdef __GLIBC__
+    // Qt allocates its containers with malloc(), so the C allocator is counted, not only operator new
+    extern "C"
+    {
+        void *__libc_malloc(size_t size);
+        void *__libc_calloc(size_t count, size_t size);
+        void *__libc_realloc(void *pointer, size_t size);
+
+        void *malloc(size_t size)
+        {
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+            return __libc_malloc(size);
+        }
+
+        void *calloc(size_t count, size_t size)
+        {
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+            return __libc_calloc(count, size);
+        }
+
+        void *realloc(void *pointer, size_t size)
+        {
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+            return __libc_realloc(pointer, size);
+        }
+    }
+#else
+    // Elsewhere only operator new is counted, which misses the Qt containers
+    void *operator new(std::size_t size)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+
+        if (void *pointer = std::malloc(size ? size : 1))
+        {
+            return pointer;
+        }
+
+        throw std::bad_alloc();
+    }
+
+    void operator delete(void *pointer) noexcept
+    {
+        std::free(pointer);
+    }
+
+    void operator delete(void *pointer, std::size_t) noexcept
+    {
+        std::free(pointer);
+    }
+#endif
+
+/**
+  Heap allocations and time of a request with a query string and cookies.
+  <p>
+  The parameters and cookies are decoded on the first access. The row "not accessed" is a
+  request for a static file or a health check, which never looks at them. The row "accessed"
+  reads all of them, which costs what every request paid before they were decoded lazily.
+  allocations() reports the number of allocations of one request as events, time() the
+  duration of one request. The C allocator is only counted with glibc.
+*/
+
+class LazyDecodingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void allocations_data();
+    void allocations();
+
+    void time_data();
+    void time();
+
+private:
+
+    /** Rows with and without access to the parameters and cookies */
+    void addAccess();
+
+    /** Parse a request and optionally read its parameters and cookies */
+    void serve(bool accessed);
+
+    HttpServerSettings settings;
+
+};
+
+void LazyDecodingBenchmark::addAccess()
+{
+    QTest::addColumn<bool>("accessed");
+
+    QTest::newRow("not accessed") << false;
+    QTest::newRow("accessed") << true;
+}
+
+void LazyDecodingBenchmark::serve(bool accessed)
+{
+    QByteArray buffer = BenchmarkData::browserHead();
+    HttpRequest request(&this->settings);
+    request.readFromBuffer(buffer);
+    QVERIFY(request.getStatus() == HttpRequest::Complete);
+
+    if (accessed)
+    {
+        QCOMPARE(request.getParameterMap().size(), 4);
+        QCOMPARE(request.getCookieMap().size(), 4);
+    }
+}
+
+void LazyDecodingBenchmark::allocations_data()
+{
+    this->addAccess();
+}
+
+void LazyDecodingBenchmark::allocations()
+{
+    QFETCH(bool, accessed);
+
+    this->settings.maxRequestSize = 16000;
+
+    // The first request may initialize static data
+    this->serve(accessed);
+
+    const qint64 before = allocationCount.load();
+    this->serve(accessed);
+    const qint64 after = allocationCount.load();
+
+    QTest::setBenchmarkResult(after - before, QTest::Events);
+}
+
+void LazyDecodingBenchmark::time_data()
+{
+    this->addAccess();
+}
+
+void LazyDecodingBenchmark::time()
+{
+    QFETCH(bool, accessed);
+
+    this->settings.maxRequestSize = 16000;
+
+    QBENCHMARK
+    {
+        this->serve(accessed);
+    }
+}
+
+QTEST_MAIN(LazyDecodingBenchmark)
+
+#include "LazyDecodingBenchmark.moc"
@@ -0,0 +1,5 @@
+TARGET = lazydecoding
+
+include(../benchmarks.pri)
+
+SOURCES += LazyDecodingBenchmark.cpp
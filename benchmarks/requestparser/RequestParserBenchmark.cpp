@@ -0,0 +1,85 @@
+#include <QtTest>
+
+#include <QtWebApp/HttpServer/HttpRequest>
+#include <QtWebApp/HttpServer/HttpRequestParser>
+
+#include "../BenchmarkData.hpp"
+
+using namespace QtWebApp;
+using namespace QtWebApp::HttpServer;
+
+/**
+  Cost of parsing the head of a request.
+  <p>
+  requestParser() runs HttpRequestParser over the receive buffer, and httpRequest() measures
+  the whole HttpRequest::readFromBuffer() including the request object.
+*/
+
+class RequestParserBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void requestParser_data();
+    void requestParser();
+
+    void httpRequest_data();
+    void httpRequest();
+
+private:
+
+    /** Rows with the heads */
+    void addHeads();
+
+};
+
+void RequestParserBenchmark::addHeads()
+{
+    QTest::addColumn<QByteArray>("head");
+
+    QTest::newRow("command line client") << BenchmarkData::smallHead();
+    QTest::newRow("web browser") << BenchmarkData::browserHead();
+}
+
+void RequestParserBenchmark::requestParser_data()
+{
+    this->addHeads();
+}
+
+void RequestParserBenchmark::requestParser()
+{
+    QFETCH(QByteArray, head);
+
+    QBENCHMARK
+    {
+        QByteArray buffer = head;
+        HttpRequestParser parser;
+        QVERIFY(parser.parse(buffer, 16000) == HttpRequestParser::Complete);
+    }
+}
+
+void RequestParserBenchmark::httpRequest_data()
+{
+    this->addHeads();
+}
+
+void RequestParserBenchmark::httpRequest()
+{
+    QFETCH(QByteArray, head);
+
+    HttpServerSettings settings;
+    settings.maxRequestSize = 16000;
+
+    QBENCHMARK
+    {
+        QByteArray buffer = head;
+        HttpRequest request(&settings);
+        request.readFromBuffer(buffer);
+        QVERIFY(request.getStatus() == HttpRequest::Complete);
+    }
+}
+
+QTEST_MAIN(RequestParserBenchmark)
+
+#include "RequestParserBenchmark.moc"
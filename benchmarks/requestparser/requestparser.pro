@@ -0,0 +1,5 @@
+TARGET = requestparser
+
+include(../benchmarks.pri)
+
+SOURCES += RequestParserBenchmark.cpp
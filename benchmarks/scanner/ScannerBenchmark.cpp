@@ -0,0 +1,77 @@
+#include <QtTest>
+
+#include <QtWebApp/HttpServer/HttpScanner>
+
+using namespace QtWebApp::HttpServer;
+
+namespace
+{
+    /** A header value without line end, like a long cookie */
+    QByteArray headerValue(int size)
+    {
+        QByteArray value;
+        value.reserve(size);
+
+        while (value.size() < size)
+        {
+            value.append("sessionid=6f1c2a9d0b7e4c3f8a5d; theme=dark; ");
+        }
+
+        value.truncate(size);
+        return value;
+    }
+}
+
+/**
+  Throughput of the search for the end of a header line, the most frequent scan of the parser.
+  <p>
+  findLineEnd() calls HttpScanner::findLineEnd() with the kernel that has been selected for
+  this CPU, each iteration scans the whole value. Run the benchmark with -tickcounter (or -perf
+  on Linux) to get the CPU cycles of one iteration; the size of the value divided by them is
+  the throughput in bytes per cycle.
+*/
+
+class ScannerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void initTestCase();
+
+    void findLineEnd_data();
+    void findLineEnd();
+
+};
+
+void ScannerBenchmark::initTestCase()
+{
+    const char *names[] = {"scalar", "SSE2", "AVX2"};
+    qDebug("HttpScanner uses the %s kernels", names[HttpScanner::getInstructionSet()]);
+}
+
+void ScannerBenchmark::findLineEnd_data()
+{
+    QTest::addColumn<QByteArray>("value");
+
+    QTest::newRow("64 bytes") << headerValue(64);
+    QTest::newRow("1024 bytes") << headerValue(1024);
+    QTest::newRow("65536 bytes") << headerValue(65536);
+}
+
+void ScannerBenchmark::findLineEnd()
+{
+    QFETCH(QByteArray, value);
+    int end = 0;
+
+    QBENCHMARK
+    {
+        end = HttpScanner::findLineEnd(value.constData(), 0, value.size());
+    }
+
+    QCOMPARE(end, value.size());
+}
+
+QTEST_MAIN(ScannerBenchmark)
+
+#include "ScannerBenchmark.moc"
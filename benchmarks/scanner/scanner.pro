@@ -0,0 +1,5 @@
+TARGET = scanner
+
+include(../benchmarks.pri)
+
+SOURCES += ScannerBenchmark.cpp
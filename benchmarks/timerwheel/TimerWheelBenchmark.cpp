@@ -0,0 +1,112 @@
+#include <memory>
+#include <vector>
+
+#include <QTimer>
+#include <QtTest>
+
+#include <QtWebApp/HttpServer/HttpTimerWheel>
+
+using namespace QtWebApp::HttpServer;
+
+namespace
+{
+    /** The default readTimeout */
+    const int timeout = 60000;
+}
+
+/**
+  Cost of rearming the read timeouts of all connections of a thread, which happens whenever
+  a request or a part of a body arrives.
+  <p>
+  qTimers() restarts one QTimer per connection, as the connections did before. timerWheel()
+  restarts the timers of one HttpTimerWheel. Each iteration rearms every timer once, the
+  event loop does not run, so no timer fires.
+*/
+
+class TimerWheelBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void qTimers_data();
+    void qTimers();
+
+    void timerWheel_data();
+    void timerWheel();
+
+private:
+
+    /** Rows with the number of connections */
+    void addConnectionCounts();
+
+};
+
+void TimerWheelBenchmark::addConnectionCounts()
+{
+    QTest::addColumn<int>("connectionCount");
+
+    QTest::newRow("1000 connections") << 1000;
+    QTest::newRow("10000 connections") << 10000;
+    QTest::newRow("100000 connections") << 100000;
+}
+
+void TimerWheelBenchmark::qTimers_data()
+{
+    this->addConnectionCounts();
+}
+
+void TimerWheelBenchmark::qTimers()
+{
+    QFETCH(int, connectionCount);
+
+    std::vector<std::unique_ptr<QTimer>> timers;
+    for (int i = 0; i < connectionCount; ++i)
+    {
+        timers.emplace_back(new QTimer());
+        timers.back()->setSingleShot(true);
+        timers.back()->start(timeout);
+    }
+
+    QBENCHMARK
+    {
+        for (const std::unique_ptr<QTimer> &timer : timers)
+        {
+            timer->start(timeout);
+        }
+    }
+}
+
+void TimerWheelBenchmark::timerWheel_data()
+{
+    this->addConnectionCounts();
+}
+
+void TimerWheelBenchmark::timerWheel()
+{
+    QFETCH(int, connectionCount);
+
+    HttpTimerWheel wheel;
+
+    // Declared after the wheel, so the timers are deleted first
+    std::vector<std::unique_ptr<HttpTimerWheel::Timer>> timers;
+    for (int i = 0; i < connectionCount; ++i)
+    {
+        timers.emplace_back(new HttpTimerWheel::Timer(&wheel, []() {}));
+        timers.back()->start(timeout);
+    }
+
+    QCOMPARE(wheel.getCount(), connectionCount);
+
+    QBENCHMARK
+    {
+        for (const std::unique_ptr<HttpTimerWheel::Timer> &timer : timers)
+        {
+            timer->start(timeout);
+        }
+    }
+}
+
+QTEST_MAIN(TimerWheelBenchmark)
+
+#include "TimerWheelBenchmark.moc"
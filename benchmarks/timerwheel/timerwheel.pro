@@ -0,0 +1,5 @@
+TARGET = timerwheel
+
+include(../benchmarks.pri)
+
+SOURCES += TimerWheelBenchmark.cpp
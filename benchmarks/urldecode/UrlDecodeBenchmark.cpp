@@ -0,0 +1,94 @@
+#include <QtTest>
+
+#include <QtWebApp/HttpServer/HttpRequest>
+
+using namespace QtWebApp::HttpServer;
+
+/**
+  Throughput of the decoding of URL encoded parameters.
+  <p>
+  byteArray() calls HttpRequest::urlDecode() which decodes in one pass into a new buffer,
+  buffer() decodes into a buffer of the caller without any allocation. The "escaped" rows
+  are mostly %XX escapes, like UTF-8 text in a form field, the "plain" row has no escape at all.
+*/
+
+class UrlDecodeBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void byteArray_data();
+    void byteArray();
+
+    void buffer_data();
+    void buffer();
+
+private:
+
+    /** Rows with the encoded values and their decoded form */
+    void addValues();
+
+    /** Add a row with a value of at least the given size, made of the pattern */
+    void addValue(const char *name, const QByteArray &pattern, const QByteArray &decodedPattern, int size);
+
+};
+
+void UrlDecodeBenchmark::addValues()
+{
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<QByteArray>("expected");
+
+    this->addValue("escaped 1024 bytes", "%E2%82%AC+%C3%A4%2F%3D", "\xE2\x82\xAC \xC3\xA4/=", 1024);
+    this->addValue("escaped 65536 bytes", "%E2%82%AC+%C3%A4%2F%3D", "\xE2\x82\xAC \xC3\xA4/=", 65536);
+    this->addValue("plain 65536 bytes", "redshoes-size42-", "redshoes-size42-", 65536);
+}
+
+void UrlDecodeBenchmark::addValue(const char *name, const QByteArray &pattern, const QByteArray &decodedPattern, int size)
+{
+    const int count = (size + pattern.size() - 1) / pattern.size();
+    QTest::newRow(name) << pattern.repeated(count) << decodedPattern.repeated(count);
+}
+
+void UrlDecodeBenchmark::byteArray_data()
+{
+    this->addValues();
+}
+
+void UrlDecodeBenchmark::byteArray()
+{
+    QFETCH(QByteArray, value);
+    QFETCH(QByteArray, expected);
+    QByteArray decoded;
+
+    QBENCHMARK
+    {
+        decoded = HttpRequest::urlDecode(value);
+    }
+
+    QCOMPARE(decoded, expected);
+}
+
+void UrlDecodeBenchmark::buffer_data()
+{
+    this->addValues();
+}
+
+void UrlDecodeBenchmark::buffer()
+{
+    QFETCH(QByteArray, value);
+    QFETCH(QByteArray, expected);
+    QByteArray target(value.size(), Qt::Uninitialized);
+    int size = 0;
+
+    QBENCHMARK
+    {
+        size = HttpRequest::urlDecode(value.constData(), value.size(), target.data());
+    }
+
+    QCOMPARE(target.left(size), expected);
+}
+
+QTEST_MAIN(UrlDecodeBenchmark)
+
+#include "UrlDecodeBenchmark.moc"
@@ -0,0 +1,5 @@
+TARGET = urldecode
+
+include(../benchmarks.pri)
+
+SOURCES += UrlDecodeBenchmark.cpp
@@ -403,6 +403,21 @@ bool QtServiceController::start()
     \sa QtServiceBase::processCommand()
 */
 
+/*!
+    \fn bool QtServiceController::upgrade()
+
+    Requests the running service to start a new process of the service
+    executable and to pass its upgrade descriptors (usually the listening
+    sockets) to that process. The old process then calls the
+    QtServiceBase::handOver() implementation, and the new process takes
+    over the control socket. Clients never see a closed port.
+
+    This is only supported on Unix. Returns true if the running service
+    has started its successor; otherwise returns false.
+
+    \sa QtServiceBase::setUpgradeDescriptors(), QtServiceBase::inheritedDescriptors()
+*/
+
 class QtServiceStarter : public QObject
 {
     Q_OBJECT
@@ -455,8 +470,11 @@ int QtServiceBasePrivate::run(bool asService, const QStringList &argList)
     if (!app)
         return -1;
 
-    if (asService)
-        sysSetPath();
+    if (asService && !sysSetPath()) {
+        delete app;
+        sysCleanup();
+        return -1;
+    }
 
     QtServiceStarter starter(this);
     QTimer::singleShot(0, &starter, SLOT(slotStart()));
@@ -570,6 +588,7 @@ int QtServiceBasePrivate::run(bool asService, const QStringList &argList)
     \row \i -t \i -terminate \i Stop the service.
     \row \i -p \i -pause \i Pause the service.
     \row \i -r \i -resume \i Resume a paused service.
+    \row \i -g \i -upgrade \i Replace the running service by a new process, see QtServiceController::upgrade().
     \row \i -c \e{cmd} \i -command \e{cmd}
 	 \i Send the user defined command code \e{cmd} to the service application.
     \row \i -v \i -version \i Display version and status information.
@@ -810,6 +829,10 @@ int QtServiceBase::exec()
         } else if (a == QLatin1String("-r") || a == QLatin1String("-resume")) {
             d_ptr->controller.resume();
             return 0;
+        } else if (a == QLatin1String("-g") || a == QLatin1String("-upgrade")) {
+            if (!d_ptr->controller.upgrade())
+                qErrnoWarning("The service could not be upgraded.");
+            return 0;
         } else if (a == QLatin1String("-c") || a == QLatin1String("-command")) {
             int code = 0;
             if (d_ptr->args.size() > 2)
@@ -822,6 +845,7 @@ int QtServiceBase::exec()
                    "\t-u(ninstall)\t: Uninstall the service.\n"
                    "\t-e(xec)\t\t: Run as a regular application. Useful for debugging.\n"
                    "\t-t(erminate)\t: Stop the service.\n"
+                   "\t-(up)g(rade)\t: Replace the running service by a new process without closing its sockets.\n"
                    //"\t-c(ommand) num\t: Send command code num to the service.\n"
                    "\t-v(ersion)\t: Print version and status information.\n"
                    "\t-h(elp)   \t: Show this help\n"
@@ -942,6 +966,60 @@ void QtServiceBase::processCommand(int /*code*/)
 {
 }
 
+/*!
+    Reimplement this function to shut down gracefully after the
+    upgrade descriptors have been passed to a new process, for example
+    to stop accepting connections and to quit when the open connections
+    have been served.
+
+    This function is called in reply to controller requests. The
+    default implementation calls stop() and quits the application.
+
+    \sa QtServiceController::upgrade(), setUpgradeDescriptors()
+*/
+void QtServiceBase::handOver()
+{
+    stop();
+    QCoreApplication::instance()->quit();
+}
+
+/*!
+    Sets the \a descriptors that are passed to a new process of the
+    service when the controller requests an upgrade. Usually these are
+    the listening sockets, so that no connection gets refused during
+    the upgrade. The upgrade is refused while no descriptors are set.
+
+    \sa inheritedDescriptors(), QtServiceController::upgrade()
+*/
+void QtServiceBase::setUpgradeDescriptors(const QList<int> &descriptors)
+{
+    d_ptr->upgradeDescriptors = descriptors;
+}
+
+/*!
+    Returns the descriptors that are passed to a new process on upgrade.
+
+    \sa setUpgradeDescriptors()
+*/
+QList<int> QtServiceBase::upgradeDescriptors() const
+{
+    return d_ptr->upgradeDescriptors;
+}
+
+/*!
+    Returns the descriptors that this process has received from its
+    predecessor, in the same order as they have been passed to
+    setUpgradeDescriptors(). The list is empty if the process has not
+    been started by an upgrade. The descriptors are available when
+    start() is called, the service takes ownership of them.
+
+    \sa setUpgradeDescriptors(), QtServiceController::upgrade()
+*/
+QList<int> QtServiceBase::inheritedDescriptors() const
+{
+    return d_ptr->inheritedDescriptors;
+}
+
 /*!
     \fn void QtServiceBase::createApplication(int &argc, char **argv)
 
@@ -47,6 +47,7 @@
 
 #include <QtGlobal>
 #include <QCoreApplication>
+#include <QList>
 
 // This is specific to Windows dll's
 #if defined(Q_OS_WIN)
@@ -93,6 +94,7 @@ public:
     bool pause();
     bool resume();
     bool sendCommand(int code);
+    bool upgrade();
 
 private:
     QtServiceControllerPrivate *d_ptr;
@@ -141,6 +143,10 @@ public:
 
     static QtServiceBase *instance();
 
+    void setUpgradeDescriptors(const QList<int> &descriptors);
+    QList<int> upgradeDescriptors() const;
+    QList<int> inheritedDescriptors() const;
+
 protected:
 
     virtual void start() = 0;
@@ -148,6 +154,7 @@ protected:
     virtual void pause();
     virtual void resume();
     virtual void processCommand(int code);
+    virtual void handOver();
 
     virtual void createApplication(int &argc, char **argv) = 0;
 
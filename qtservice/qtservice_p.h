@@ -66,6 +66,8 @@ public:
     QtServiceController::StartupType startupType;
     QtServiceBase::ServiceFlags serviceFlags;
     QStringList args;
+    QList<int> upgradeDescriptors;
+    QList<int> inheritedDescriptors;
 
     static class QtServiceBase *instance;
 
@@ -79,7 +81,7 @@ public:
 
     QString filePath() const;
     bool sysInit();
-    void sysSetPath();
+    bool sysSetPath();
     void sysCleanup();
     class QtServiceSysPrivate *sysd;
 };
@@ -48,6 +48,7 @@
 #include <QTimer>
 #include <QDir>
 #include <pwd.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdlib.h>
@@ -55,6 +56,9 @@
 #include <syslog.h>
 #include <signal.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
 #include <QMap>
 #include <QSettings>
 #include <QProcess>
@@ -114,6 +118,104 @@ static bool sendCmd(const QString &serviceName, const QString &cmd)
     return retValue;
 }
 
+// Maximum number of descriptors that are passed on upgrade
+static const int maxUpgradeDescriptors = 64;
+
+static bool sendDescriptors(int sock, const QList<int> &descriptors)
+{
+    char reply[] = "true";
+    struct iovec iov;
+    iov.iov_base = reply;
+    iov.iov_len = 4;
+
+    QByteArray control(CMSG_SPACE(sizeof(int) * descriptors.size()), '\0');
+    struct msghdr msg;
+    ::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * descriptors.size());
+    int *data = (int *)CMSG_DATA(cmsg);
+    for (int i = 0; i < descriptors.size(); ++i)
+        data[i] = descriptors.at(i);
+
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(sock, &msg, 0);
+    } while (sent == -1 && errno == EINTR);
+    return sent == 4;
+}
+
+static QList<int> receiveDescriptors(const QString &path)
+{
+    QList<int> descriptors;
+    int sock = ::socket(PF_UNIX, SOCK_STREAM, 0);
+    if (sock == -1)
+        return descriptors;
+
+    struct sockaddr_un addr;
+    ::memset(&addr, 0, sizeof(struct sockaddr_un));
+    addr.sun_family = AF_UNIX;
+    size_t pathlen = qMin(strlen(path.toLatin1().constData()), sizeof(addr.sun_path) - 1);
+    ::memcpy(addr.sun_path, path.toLatin1().constData(), pathlen);
+
+    // Do not wait forever for a predecessor that does not answer
+    struct timeval timeout;
+    timeout.tv_sec = 10;
+    timeout.tv_usec = 0;
+    ::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    const char cmd[] = "takeover\r\n";
+    if (::connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+        ::write(sock, cmd, sizeof(cmd) - 1) != (ssize_t)(sizeof(cmd) - 1)) {
+        ::close(sock);
+        return descriptors;
+    }
+
+    char reply[5];
+    struct iovec iov;
+    iov.iov_base = reply;
+    iov.iov_len = 4;
+
+    QByteArray control(CMSG_SPACE(sizeof(int) * maxUpgradeDescriptors), '\0');
+    struct msghdr msg;
+    ::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    int flags = 0;
+#ifdef MSG_CMSG_CLOEXEC
+    flags |= MSG_CMSG_CLOEXEC;
+#endif
+    ssize_t received;
+    do {
+        received = ::recvmsg(sock, &msg, flags);
+    } while (received == -1 && errno == EINTR);
+
+    if (received > 0) {
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                continue;
+            int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            int *data = (int *)CMSG_DATA(cmsg);
+            for (int i = 0; i < count; ++i) {
+                ::fcntl(data[i], F_SETFD, FD_CLOEXEC);
+                descriptors.append(data[i]);
+            }
+        }
+    }
+
+    ::close(sock);
+    return descriptors;
+}
+
 static QString absPath(const QString &path)
 {
     QString ret;
@@ -245,6 +347,11 @@ bool QtServiceController::sendCommand(int code)
     return sendCmd(serviceName(), QString(QLatin1String("num:") + QString::number(code)));
 }
 
+bool QtServiceController::upgrade()
+{
+    return sendCmd(serviceName(), QLatin1String("upgrade"));
+}
+
 bool QtServiceController::isInstalled() const
 {
     QSettings settings(QSettings::SystemScope, "QtSoftware");
@@ -295,6 +402,7 @@ private slots:
     void slotClosed();
 
 private:
+    bool startSuccessor();
     QString getCommand(const QTcpSocket *socket);
     QMap<const QTcpSocket *, QString> cache;
 };
@@ -341,6 +449,21 @@ void QtServiceSysPrivate::slotReady()
                 QtServiceBase::instance()->resume();
                 retValue = true;
             }
+        } else if (cmd == QLatin1String("upgrade")) {
+            retValue = startSuccessor();
+        } else if (cmd == QLatin1String("takeover")) {
+            // Sent by the successor, the reply carries the descriptors
+            QtServiceBasePrivate *d = QtServiceBase::instance()->d_ptr;
+            if (!d->upgradeDescriptors.isEmpty()) {
+                s->flush();
+                if (sendDescriptors(s->socketDescriptor(), d->upgradeDescriptors)) {
+                    // The successor owns the control socket from now on
+                    release();
+                    QtServiceBase::instance()->handOver();
+                    cmd = getCommand(s);
+                    continue;
+                }
+            }
         } else if (cmd == QLatin1String("alive")) {
             retValue = true;
         } else if (cmd.length() > 4 && cmd.left(4) == QLatin1String("num:")) {
@@ -359,6 +482,20 @@ void QtServiceSysPrivate::slotReady()
     }
 }
 
+bool QtServiceSysPrivate::startSuccessor()
+{
+    QtServiceBasePrivate *d = QtServiceBase::instance()->d_ptr;
+    if (d->upgradeDescriptors.isEmpty())
+        return false;
+
+    // The new process asks for the descriptors with the "takeover" command
+    ::setenv("QTSERVICE_RUN", "1", 1);
+    ::setenv("QTSERVICE_UPGRADE", "1", 1);
+    bool started = QProcess::startDetached(d->filePath(), d->args.mid(1), "/");
+    ::unsetenv("QTSERVICE_UPGRADE");
+    return started;
+}
+
 void QtServiceSysPrivate::slotClosed()
 {
     QTcpSocket *s = (QTcpSocket *)sender();
@@ -388,10 +525,23 @@ bool QtServiceBasePrivate::sysInit()
     return true;
 }
 
-void QtServiceBasePrivate::sysSetPath()
+bool QtServiceBasePrivate::sysSetPath()
 {
-    if (sysd)
+    if (sysd) {
+        // A successor takes the descriptors of the running process before it takes over the control socket
+        if (::getenv("QTSERVICE_UPGRADE")) {
+            ::unsetenv("QTSERVICE_UPGRADE");
+            inheritedDescriptors = receiveDescriptors(socketPath(controller.serviceName()));
+
+            // The running process has not handed over, so its control socket must stay
+            if (inheritedDescriptors.isEmpty()) {
+                qWarning("QtService: no descriptors received from the running service, upgrade aborted");
+                return false;
+            }
+        }
         sysd->setPath(socketPath(controller.serviceName()));
+    }
+    return true;
 }
 
 void QtServiceBasePrivate::sysCleanup()
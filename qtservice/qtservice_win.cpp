@@ -420,6 +420,12 @@ bool QtServiceController::sendCommand(int code)
     return result;
 }
 
+bool QtServiceController::upgrade()
+{
+    // Windows services cannot pass sockets to a successor
+    return false;
+}
+
 #if defined(QTSERVICE_DEBUG)
 extern void qtServiceLogDebug(QtMsgType type, const char* msg);
 #endif
@@ -924,9 +930,9 @@ bool QtServiceBasePrivate::sysInit()
     return true;
 }
 
-void QtServiceBasePrivate::sysSetPath()
+bool QtServiceBasePrivate::sysSetPath()
 {
-
+    return true;
 }
 
 void QtServiceBasePrivate::sysCleanup()
@@ -90,3 +90,10 @@ void QtUnixServerSocket::close()
         path_.clear();
     }
 }
+
+void QtUnixServerSocket::release()
+{
+    // Stop listening, but keep the socket file that belongs to another process now
+    path_.clear();
+    QTcpServer::close();
+}
@@ -52,6 +52,7 @@ public:
 
     void setPath(const QString &path);
     void close();
+    void release();
 
 private:
     QString path_;
@@ -0,0 +1,372 @@
+#include <QTemporaryFile>
+#include <QtTest>
+
+#include <QtWebApp/HttpServer/HttpRequest>
+
+using namespace QtWebApp;
+using namespace QtWebApp::HttpServer;
+
+namespace
+{
+    /** Split the data into pieces of the given size, 0 for one piece */
+    QList<QByteArray> split(const QByteArray &data, int size)
+    {
+        QList<QByteArray> pieces;
+
+        if (size <= 0)
+        {
+            pieces.append(data);
+            return pieces;
+        }
+
+        for (int i = 0; i < data.size(); i += size)
+        {
+            pieces.append(data.mid(i, size));
+        }
+
+        return pieces;
+    }
+
+    /**
+      Pass the pieces to the request like a connection does, each one after the data
+      that has not been consumed yet.
+      @return the data that follows the request
+    */
+    QByteArray feed(HttpRequest &request, const QList<QByteArray> &pieces)
+    {
+        QByteArray buffer;
+
+        for (const QByteArray &piece : pieces)
+        {
+            buffer.append(piece);
+
+            if (request.getStatus() != HttpRequest::Complete && request.getStatus() != HttpRequest::Abort)
+            {
+                buffer.remove(0, request.readFromBuffer(buffer));
+            }
+        }
+
+        return buffer;
+    }
+
+    /** Head of a POST request with a chunked body and the given further header lines */
+    QByteArray chunkedHead(const QByteArray &headers = "Transfer-Encoding: chunked\r\n")
+    {
+        return "POST /upload HTTP/1.1\r\n"
+               "Host: www.example.com\r\n" + headers + "\r\n";
+    }
+
+    /** Body of a multipart/form-data request with a form field and a file */
+    QByteArray multipartBody()
+    {
+        // The file contains partial delimiters, which must not end the part
+        return QByteArray("--AaB03x\r\n"
+                          "Content-Disposition: form-data; name=\"field\"\r\n"
+                          "\r\n"
+                          "value\r\n"
+                          "--AaB03x\r\n"
+                          "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+                          "Content-Type: text/plain\r\n"
+                          "\r\n"
+                          "line\r\n--AaB03\r\n--AaB0 end\r\n"
+                          "--AaB03x--\r\n");
+    }
+
+    /** Request with a multipart/form-data body */
+    QByteArray multipartRequest(const QByteArray &body)
+    {
+        return "POST /form HTTP/1.1\r\n"
+               "Host: www.example.com\r\n"
+               "Content-Type: multipart/form-data; boundary=AaB03x\r\n"
+               "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+               "\r\n" + body;
+    }
+}
+
+/**
+  Tests of the incremental parsing of requests by HttpRequest: heads, headers,
+  chunked bodies and multipart bodies that arrive in arbitrary pieces.
+*/
+
+class HttpRequestTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void init();
+
+    void splitHead_data();
+    void splitHead();
+
+    void pipelined();
+
+    void chunkedBody_data();
+    void chunkedBody();
+
+    void badChunkSize_data();
+    void badChunkSize();
+
+    void transferEncoding_data();
+    void transferEncoding();
+
+    void oversizeChunkedBody_data();
+    void oversizeChunkedBody();
+
+    void multipartBody_data();
+    void multipartBody();
+
+    void truncatedMultipartBody();
+
+private:
+
+    /** Rows with the size of the pieces in which the request arrives */
+    void addPieceSizes();
+
+    HttpServerSettings settings;
+
+};
+
+void HttpRequestTest::init()
+{
+    this->settings = HttpServerSettings();
+    this->settings.maxRequestSize = 16000;
+}
+
+void HttpRequestTest::addPieceSizes()
+{
+    QTest::addColumn<int>("pieceSize");
+
+    QTest::newRow("one piece") << 0;
+    QTest::newRow("single bytes") << 1;
+    QTest::newRow("7 bytes") << 7;
+    QTest::newRow("64 bytes") << 64;
+}
+
+void HttpRequestTest::splitHead_data()
+{
+    this->addPieceSizes();
+}
+
+void HttpRequestTest::splitHead()
+{
+    QFETCH(int, pieceSize);
+
+    const QByteArray head("GET /shop/search?q=red+shoes&size=42 HTTP/1.1\r\n"
+                          "Host: www.example.com\r\n"
+                          "content-TYPE: text/plain\r\n"
+                          "X-Custom: one\r\n"
+                          "x-custom: two\r\n"
+                          "\r\n");
+
+    HttpRequest request(&this->settings);
+    QVERIFY(feed(request, split(head, pieceSize)).isEmpty());
+    QVERIFY(request.getStatus() == HttpRequest::Complete);
+
+    QCOMPARE(request.getMethod(), QByteArray("GET"));
+    QCOMPARE(request.getPath(), QByteArray("/shop/search"));
+    QCOMPARE(request.getVersion(), QByteArray("HTTP/1.1"));
+    QCOMPARE(request.getParameter("q"), QByteArray("red shoes"));
+    QCOMPARE(request.getParameter("size"), QByteArray("42"));
+
+    // Well-known headers are found by id and by name in any case, the last one of a name wins
+    QCOMPARE(request.getHeader(HttpHeaders::ContentType), QByteArray("text/plain"));
+    QCOMPARE(request.getHeader("Content-Type"), QByteArray("text/plain"));
+    QVERIFY(request.hasHeaderValue(HttpHeaders::ContentType, "TEXT/PLAIN"));
+    QCOMPARE(request.getHeader("X-CUSTOM"), QByteArray("two"));
+    QCOMPARE(request.getHeaders("x-custom"), QList<QByteArray>() << "two" << "one");
+    QCOMPARE(request.getHeaderMap().values("x-custom").size(), 2);
+    QVERIFY(request.getHeader("X-Missing").isNull());
+}
+
+void HttpRequestTest::pipelined()
+{
+    const QByteArray second("GET /second HTTP/1.1\r\n"
+                            "Host: www.example.com\r\n"
+                            "\r\n");
+
+    const QByteArray data = "POST /first HTTP/1.1\r\n"
+                            "Host: www.example.com\r\n"
+                            "Content-Length: 5\r\n"
+                            "\r\n"
+                            "hello" + second;
+
+    HttpRequest first(&this->settings);
+    const QByteArray rest = feed(first, split(data, 0));
+    QVERIFY(first.getStatus() == HttpRequest::Complete);
+    QCOMPARE(first.getPath(), QByteArray("/first"));
+    QCOMPARE(first.getBody(), QByteArray("hello"));
+    QCOMPARE(rest, second);
+
+    HttpRequest next(&this->settings);
+    QVERIFY(feed(next, split(rest, 0)).isEmpty());
+    QVERIFY(next.getStatus() == HttpRequest::Complete);
+    QCOMPARE(next.getPath(), QByteArray("/second"));
+}
+
+void HttpRequestTest::chunkedBody_data()
+{
+    this->addPieceSizes();
+}
+
+void HttpRequestTest::chunkedBody()
+{
+    QFETCH(int, pieceSize);
+
+    // Chunk extensions and trailer fields are skipped, the next request is not consumed
+    const QByteArray next("GET / HTTP/1.1\r\n\r\n");
+    const QByteArray data = chunkedHead() +
+                            "4;name=value\r\n"
+                            "Wiki\r\n"
+                            "5 ; other\r\n"
+                            "pedia\r\n"
+                            "E\n"
+                            " in\r\n\r\nchunks.\n"
+                            "0\r\n"
+                            "Expires: never\r\n"
+                            "X-Checksum: 1234\r\n"
+                            "\r\n" + next;
+
+    HttpRequest request(&this->settings);
+    const QByteArray rest = feed(request, split(data, pieceSize));
+    QVERIFY(request.getStatus() == HttpRequest::Complete);
+    QCOMPARE(request.getBody(), QByteArray("Wikipedia in\r\n\r\nchunks."));
+    QCOMPARE(rest, next);
+}
+
+void HttpRequestTest::badChunkSize_data()
+{
+    QTest::addColumn<QByteArray>("body");
+
+    QTest::newRow("not hexadecimal") << QByteArray("zz\r\nWiki\r\n0\r\n\r\n");
+    QTest::newRow("empty") << QByteArray("\r\nWiki\r\n0\r\n\r\n");
+    QTest::newRow("negative") << QByteArray("-4\r\nWiki\r\n0\r\n\r\n");
+    QTest::newRow("overflow") << QByteArray("10000000000000004\r\nWiki\r\n0\r\n\r\n");
+    QTest::newRow("too much data") << QByteArray("2\r\nWiki\r\n0\r\n\r\n");
+}
+
+void HttpRequestTest::badChunkSize()
+{
+    QFETCH(QByteArray, body);
+
+    HttpRequest request(&this->settings);
+    feed(request, split(chunkedHead() + body, 0));
+    QVERIFY(request.getStatus() == HttpRequest::Abort);
+}
+
+void HttpRequestTest::transferEncoding_data()
+{
+    QTest::addColumn<QByteArray>("headers");
+    QTest::addColumn<bool>("accepted");
+
+    QTest::newRow("chunked") << QByteArray("Transfer-Encoding: chunked\r\n") << true;
+    QTest::newRow("upper case") << QByteArray("Transfer-Encoding: CHUNKED\r\n") << true;
+    QTest::newRow("other coding") << QByteArray("Transfer-Encoding: gzip\r\n") << false;
+    QTest::newRow("list") << QByteArray("Transfer-Encoding: gzip, chunked\r\n") << false;
+    QTest::newRow("two fields") << QByteArray("Transfer-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n") << false;
+    QTest::newRow("twice chunked") << QByteArray("Transfer-Encoding: chunked\r\nTransfer-Encoding: chunked\r\n") << false;
+    QTest::newRow("empty") << QByteArray("Transfer-Encoding: \r\n") << false;
+    QTest::newRow("content length after") << QByteArray("Transfer-Encoding: chunked\r\nContent-Length: 4\r\n") << false;
+    QTest::newRow("content length before") << QByteArray("Content-Length: 4\r\nTransfer-Encoding: chunked\r\n") << false;
+}
+
+void HttpRequestTest::transferEncoding()
+{
+    QFETCH(QByteArray, headers);
+    QFETCH(bool, accepted);
+
+    HttpRequest request(&this->settings);
+    feed(request, split(chunkedHead(headers) + "4\r\nWiki\r\n0\r\n\r\n", 0));
+
+    if (accepted)
+    {
+        QVERIFY(request.getStatus() == HttpRequest::Complete);
+        QCOMPARE(request.getBody(), QByteArray("Wiki"));
+    }
+
+    else
+    {
+        QVERIFY(request.getStatus() == HttpRequest::Abort);
+    }
+}
+
+void HttpRequestTest::oversizeChunkedBody_data()
+{
+    QTest::addColumn<int>("chunkSize");
+    QTest::addColumn<int>("chunkCount");
+    QTest::addColumn<bool>("accepted");
+
+    QTest::newRow("within the limit") << 50 << 10 << true;
+    QTest::newRow("one large chunk") << 100000 << 1 << false;
+    QTest::newRow("many small chunks") << 100 << 1000 << false;
+}
+
+void HttpRequestTest::oversizeChunkedBody()
+{
+    QFETCH(int, chunkSize);
+    QFETCH(int, chunkCount);
+    QFETCH(bool, accepted);
+
+    this->settings.maxRequestSize = 1000;
+
+    QByteArray data = chunkedHead();
+    for (int i = 0; i < chunkCount; ++i)
+    {
+        data.append(QByteArray::number(chunkSize, 16) + "\r\n" + QByteArray(chunkSize, 'x') + "\r\n");
+    }
+
+    data.append("0\r\n\r\n");
+
+    // The whole body arrives at once, like a full receive buffer of the kernel
+    HttpRequest request(&this->settings);
+    feed(request, split(data, 0));
+
+    if (accepted)
+    {
+        QVERIFY(request.getStatus() == HttpRequest::Complete);
+        QCOMPARE(request.getBody().size(), chunkSize * chunkCount);
+    }
+
+    else
+    {
+        QVERIFY(request.getStatus() == HttpRequest::Abort);
+        QVERIFY(request.getBody().size() <= 1000);
+    }
+}
+
+void HttpRequestTest::multipartBody_data()
+{
+    this->addPieceSizes();
+}
+
+void HttpRequestTest::multipartBody()
+{
+    QFETCH(int, pieceSize);
+
+    // Small pieces split the delimiters at every position
+    HttpRequest request(&this->settings);
+    QVERIFY(feed(request, split(multipartRequest(::multipartBody()), pieceSize)).isEmpty());
+    QVERIFY(request.getStatus() == HttpRequest::Complete);
+
+    QCOMPARE(request.getParameter("field"), QByteArray("value"));
+    QCOMPARE(request.getParameter("file"), QByteArray("a.txt"));
+
+    QTemporaryFile *file = request.getUploadedFile("file");
+    QVERIFY(file != nullptr);
+    QCOMPARE(file->readAll(), QByteArray("line\r\n--AaB03\r\n--AaB0 end"));
+}
+
+void HttpRequestTest::truncatedMultipartBody()
+{
+    // The body ends within the file, before the final delimiter
+    const QByteArray body = ::multipartBody();
+    const QByteArray truncated = body.left(body.indexOf("--AaB03x--") - 4);
+
+    HttpRequest request(&this->settings);
+    feed(request, split(multipartRequest(truncated), 0));
+    QVERIFY(request.getStatus() == HttpRequest::Abort);
+}
+
+QTEST_MAIN(HttpRequestTest)
+
+#include "HttpRequestTest.moc"
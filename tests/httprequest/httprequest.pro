@@ -0,0 +1,5 @@
+TARGET = httprequest
+
+include(../tests.pri)
+
+SOURCES += HttpRequestTest.cpp
@@ -0,0 +1,7 @@
+QT += testlib
+QT -= gui
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include($$PWD/../HttpServer.pri)
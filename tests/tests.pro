@@ -0,0 +1,5 @@
+# Behavior tests of the HttpServer, each one is a QtTest executable.
+# Build with "qmake && make", then run all of them with "make check".
+TEMPLATE = subdirs
+
+SUBDIRS = httprequest